@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "common/ReplayFile.h"
+#include "common/Utils.h"
+#include "server/WinValidator.h"
+
+namespace {
+    enum class ParseResult {
+        RUN,
+        SHOW_HELP,
+        INVALID
+    };
+
+    struct ReplayOptions {
+        bool seek = false;
+        unsigned long long seekTurn = 0; //Show the board after this turn
+        std::vector<std::string> paths; //Replay files, or directories of them
+    };
+
+    constexpr char PIECE_SYMBOLS[] = {'.', 'X', 'O', 'T', 'S', '8', 'H'};
+
+    void printUsage(const char *program) {
+        std::printf("Usage: %s [options] <replay file or directory>...\n"
+                    "Verifies every move of the archived games and that the recorded result matches the board.\n"
+                    "  -s, --seek <turn>              Also show the board right after this turn\n"
+                    "  -h, --help                     Show this help\n",
+                    program);
+    }
+
+    bool parseNumber(const char *text, const unsigned long long min, const unsigned long long max,
+                     unsigned long long &outValue) {
+        char *end = nullptr;
+        errno = 0;
+        outValue = std::strtoull(text, &end, 10);
+        return errno == 0 && end != text && *end == '\0' && outValue >= min && outValue <= max;
+    }
+
+    /**
+     * @brief Reads the command line into `options`.
+     *
+     * @return Whether to check the replays or quit right away.
+     */
+    ParseResult parseOptions(const int argc, char **argv, ReplayOptions &options) {
+        for (int i = 1; i < argc; ++i) {
+            const char *option = argv[i];
+            if (std::strcmp(option, "-h") == 0 || std::strcmp(option, "--help") == 0) {
+                printUsage(argv[0]);
+                return ParseResult::SHOW_HELP;
+            }
+
+            if (std::strcmp(option, "-s") == 0 || std::strcmp(option, "--seek") == 0) {
+                if (i + 1 >= argc || !parseNumber(argv[i + 1], 0, UINT16_MAX, options.seekTurn)) {
+                    std::printf(ANSI_RED "Invalid or missing turn for option %s\n" ANSI_RESET, option);
+                    return ParseResult::INVALID;
+                }
+                options.seek = true;
+                ++i;
+            } else if (option[0] == '-') {
+                std::printf(ANSI_RED "Unknown option %s\n" ANSI_RESET, option);
+                printUsage(argv[0]);
+                return ParseResult::INVALID;
+            } else {
+                options.paths.emplace_back(option);
+            }
+        }
+
+        if (options.paths.empty()) {
+            printUsage(argv[0]);
+            return ParseResult::INVALID;
+        }
+        return ParseResult::RUN;
+    }
+
+    /**
+     * @return The replay files to check, directories expanded to the replays in them in name order.
+     */
+    std::vector<std::string> collectReplays(const std::vector<std::string> &paths) {
+        std::vector<std::string> files;
+        for (const auto &path: paths) {
+            std::error_code error;
+            if (!std::filesystem::is_directory(path, error)) {
+                files.push_back(path);
+                continue;
+            }
+
+            std::vector<std::string> found;
+            for (const auto &entry: std::filesystem::directory_iterator(path, error)) {
+                if (entry.path().extension() == ReplayFile::FILE_EXTENSION) found.push_back(entry.path().string());
+            }
+            std::ranges::sort(found);
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        return files;
+    }
+
+    char pieceSymbol(const PieceType piece) {
+        const auto index = static_cast<size_t>(piece);
+        return index < std::size(PIECE_SYMBOLS) ? PIECE_SYMBOLS[index] : '?';
+    }
+
+    const char *finishReasonName(const FinishReason reason) {
+        switch (reason) {
+            case FinishReason::PLAYER_WIN:
+                return "won by";
+            case FinishReason::PLAYER_DISCONNECT:
+                return "abandoned by";
+            case FinishReason::OTHER:
+                return "ended by";
+            default:
+                return "unfinished,";
+        }
+    }
+
+    const ReplayPlayer *findPlayer(const ReplayReader &reader, const uint8_t playerId) {
+        for (const auto &player: reader.getPlayers()) {
+            if (player.playerId == playerId) return &player;
+        }
+        return nullptr;
+    }
+
+    void printHeader(const std::string &path, const ReplayReader &reader) {
+        const ReplayHeader &header = reader.getHeader();
+
+        char startedAt[32] = "unknown time";
+        const auto startedAtSeconds = static_cast<std::time_t>(header.startedAtMs / 1000);
+        if (header.startedAtMs != 0) {
+            if (const std::tm *time = std::gmtime(&startedAtSeconds)) {
+                std::strftime(startedAt, sizeof(startedAt), "%Y-%m-%d %H:%M:%S UTC", time);
+            }
+        }
+
+        const ReplayPlayer *finisher = findPlayer(reader, header.finishPlayerId);
+        std::printf(ANSI_CYAN "%s" ANSI_RESET "\n  room %u round %u, %ux%u board, %u in a row, started %s\n"
+                    "  %u moves, %s player %u (%s), %u keyframes every %u moves\n",
+                    path.c_str(), header.roomId, header.round, header.boardSize, header.boardSize,
+                    header.winConditionLength, startedAt, header.moveCount, finishReasonName(header.finishReason),
+                    header.finishPlayerId, finisher != nullptr ? finisher->playerName : "?", header.keyframeCount,
+                    header.keyframeInterval);
+        for (const auto &player: reader.getPlayers()) {
+            std::printf("  player %u %c %s%s\n", player.playerId, pieceSymbol(player.piece), player.playerName,
+                        player.isHost ? " (host)" : "");
+        }
+    }
+
+    void printBoard(const BoardData &board) {
+        for (const auto &row: board.grid) {
+            std::printf("  ");
+            for (const auto &square: row) {
+                std::printf(" %c", pieceSymbol(square.piece));
+            }
+            std::printf("\n");
+        }
+    }
+
+    /**
+     * @brief Replays the whole game on a fresh board and checks every move, every keyframe and the result.
+     *
+     * @return The number of problems found, each one printed.
+     */
+    size_t verifyReplay(const ReplayReader &reader) {
+        const ReplayHeader &header = reader.getHeader();
+        size_t problems = 0;
+
+        std::vector<Move> moves;
+        if (!reader.readMoves(0, header.moveCount, moves)) {
+            std::printf(ANSI_RED "  The move stream is corrupt\n" ANSI_RESET);
+            return 1;
+        }
+        if (!moves.empty() && header.firstTurn != 1) {
+            std::printf(ANSI_RED "  The first move was on turn %u, games start on turn 1\n" ANSI_RESET,
+                        header.firstTurn);
+            ++problems;
+        }
+
+        BoardData board{};
+        BoardData keyframeBoard{};
+        board.boardSize = header.boardSize;
+        board.winConditionLength = header.winConditionLength;
+        Utils::initializeGameBoard(board);
+
+        const std::vector<ReplayKeyframe> &keyframes = reader.getKeyframes();
+        size_t nextKeyframe = 0;
+        bool won = false;
+        uint8_t winnerId = 0;
+
+        for (uint32_t i = 0; i <= moves.size(); ++i) {
+            // Every keyframe has to show the board the moves before it built
+            if (nextKeyframe < keyframes.size() && keyframes[nextKeyframe].moveIndex == i) {
+                bool matches = reader.loadKeyframe(keyframes[nextKeyframe], keyframeBoard);
+                for (uint8_t y = 0; matches && y < board.boardSize; ++y) {
+                    for (uint8_t x = 0; matches && x < board.boardSize; ++x) {
+                        matches = board.grid[y][x].piece == keyframeBoard.grid[y][x].piece;
+                    }
+                }
+                if (!matches) {
+                    std::printf(ANSI_RED "  The keyframe at move %u doesn't match the moves before it\n" ANSI_RESET, i);
+                    ++problems;
+                }
+                ++nextKeyframe;
+            }
+            if (i == moves.size()) break;
+
+            const Move &move = moves[i];
+            const ReplayPlayer *player = findPlayer(reader, move.playerId);
+            if (player == nullptr) {
+                std::printf(ANSI_RED "  Move %u (turn %u at %u,%u): player %u isn't on the roster\n" ANSI_RESET,
+                            i + 1, move.turnPlaced, move.posX, move.posY, move.playerId);
+                ++problems;
+            } else if (player->piece != move.piece) {
+                std::printf(ANSI_RED "  Move %u (turn %u at %u,%u): player %u placed %c but plays %c\n" ANSI_RESET,
+                            i + 1, move.turnPlaced, move.posX, move.posY, move.playerId, pieceSymbol(move.piece),
+                            pieceSymbol(player->piece));
+                ++problems;
+            }
+            if (board.grid[move.posY][move.posX].piece != PieceType::EMPTY) {
+                std::printf(ANSI_RED "  Move %u (turn %u at %u,%u): the square is already taken\n" ANSI_RESET,
+                            i + 1, move.turnPlaced, move.posX, move.posY);
+                ++problems;
+            }
+            if (won) {
+                std::printf(ANSI_RED "  Move %u (turn %u at %u,%u): the game was already won by player %u\n"
+                            ANSI_RESET, i + 1, move.turnPlaced, move.posX, move.posY, winnerId);
+                ++problems;
+            }
+
+            board.grid[move.posY][move.posX] = BoardSquare{move.piece, move.playerId, move.turnPlaced};
+            if (!won && WinValidator::checkWin(board, move.posX, move.posY)) {
+                won = true;
+                winnerId = move.playerId;
+            }
+        }
+
+        // The recorded result has to be the one the board shows
+        if (header.finishReason == FinishReason::PLAYER_WIN) {
+            if (!won) {
+                std::printf(ANSI_RED "  Recorded as won by player %u, but nobody has %u in a row\n" ANSI_RESET,
+                            header.finishPlayerId, header.winConditionLength);
+                ++problems;
+            } else if (winnerId != header.finishPlayerId) {
+                std::printf(ANSI_RED "  Recorded as won by player %u, but player %u won\n" ANSI_RESET,
+                            header.finishPlayerId, winnerId);
+                ++problems;
+            }
+        } else if (won) {
+            std::printf(ANSI_RED "  Player %u won, but the game wasn't recorded as won\n" ANSI_RESET, winnerId);
+            ++problems;
+        }
+        return problems;
+    }
+
+    /**
+     * @brief Shows the board right after the given turn, decoded from the nearest keyframe.
+     */
+    bool printSeek(const ReplayReader &reader, const unsigned long long turn) {
+        const ReplayHeader &header = reader.getHeader();
+        const unsigned long long movesBefore = turn >= header.firstTurn ? turn - header.firstTurn + 1 : 0;
+        const auto moveCount = static_cast<uint32_t>(std::min<unsigned long long>(movesBefore, header.moveCount));
+
+        BoardData board{};
+        if (!reader.seek(moveCount, board)) {
+            std::printf(ANSI_RED "  Couldn't seek to turn %llu\n" ANSI_RESET, turn);
+            return false;
+        }
+
+        const uint32_t keyframeMove = moveCount / header.keyframeInterval * header.keyframeInterval;
+        std::printf("  Board after %u moves (keyframe at move %u, %u moves decoded):\n", moveCount, keyframeMove,
+                    moveCount - keyframeMove);
+        printBoard(board);
+        return true;
+    }
+}
+
+/**
+ * @brief Headless replay checker entry point.
+ * <br> Re-verifies archived games with the server's `WinValidator` and shows the board at any turn.
+ *
+ * @return 0 if every replay checked out, non-zero if one is corrupt or shows an invalid game.
+ */
+int main(const int argc, char **argv) {
+    ReplayOptions options;
+    switch (parseOptions(argc, argv, options)) {
+        case ParseResult::RUN:
+            break;
+        case ParseResult::SHOW_HELP:
+            return EXIT_SUCCESS;
+        case ParseResult::INVALID:
+            return EXIT_FAILURE;
+    }
+
+    const std::vector<std::string> files = collectReplays(options.paths);
+    size_t failedFiles = 0;
+    for (const auto &path: files) {
+        ReplayReader reader;
+        if (!reader.load(path)) {
+            std::printf(ANSI_RED "%s: not a valid replay file\n" ANSI_RESET, path.c_str());
+            ++failedFiles;
+            continue;
+        }
+
+        printHeader(path, reader);
+        bool valid = verifyReplay(reader) == 0;
+        if (options.seek) valid &= printSeek(reader, options.seekTurn);
+
+        if (valid) {
+            std::printf(ANSI_GREEN "  OK\n" ANSI_RESET);
+        } else {
+            ++failedFiles;
+        }
+    }
+
+    std::printf("%zu replay(s) checked, %zu failed\n", files.size(), failedFiles);
+    return failedFiles == 0 && !files.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,188 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "common/NetworkProtocol.h"
+#include "common/Logger.h"
+#include "common/Tracer.h"
+#include "common/Utils.h"
+#include "server/InternalGameServer.h"
+
+namespace {
+    std::atomic<bool> stopRequested = false;
+
+    std::atomic<bool> traceRequested = false;
+
+    void handleStopSignal(int) {
+        stopRequested = true;
+    }
+
+    void handleTraceSignal(int) {
+        traceRequested = true;
+    }
+
+    enum class ParseResult {
+        RUN,
+        SHOW_HELP,
+        INVALID
+    };
+
+    struct ServerOptions {
+        int port = DEFAULT_SERVER_PORT;
+        size_t shardCount = std::max(std::thread::hardware_concurrency(), 1u);
+        size_t maxClients = 0;
+        size_t outboundHighWaterMark = InternalGameServer::DEFAULT_OUTBOUND_HIGH_WATER_MARK;
+        const char *tracePath = nullptr; //Tracing stays off without one
+        const char *journalDirectory = nullptr; //Journaling stays off without one
+        const char *replayDirectory = nullptr; //Games aren't archived without one
+    };
+
+    void printUsage(const char *program) {
+        std::printf("Usage: %s [options]\n"
+                    "  -p, --port <port>              Port to listen on (default %d)\n"
+                    "  -s, --shards <count>           Worker threads, defaults to the number of hardware threads\n"
+                    "  -c, --max-clients <count>      Connections accepted at once, 0 for no limit (default 0)\n"
+                    "  -w, --high-water-mark <bytes>  Unsent bytes per client before it gets dropped (default %zu)\n"
+                    "  -t, --trace <file>             Record trace spans, written as Chrome trace JSON on exit"
+#ifdef SIGUSR1
+                    " and on SIGUSR1"
+#endif
+                    "\n"
+                    "  -j, --journal <directory>      Journal the rooms there, they come back after a crash\n"
+                    "  -r, --replays <directory>      Archive every finished game there as a replay file\n"
+                    "  -h, --help                     Show this help\n",
+                    program, DEFAULT_SERVER_PORT, InternalGameServer::DEFAULT_OUTBOUND_HIGH_WATER_MARK);
+    }
+
+    bool parseNumber(const char *text, const unsigned long long min, const unsigned long long max,
+                     unsigned long long &outValue) {
+        char *end = nullptr;
+        errno = 0;
+        outValue = std::strtoull(text, &end, 10);
+        return errno == 0 && end != text && *end == '\0' && outValue >= min && outValue <= max;
+    }
+
+    /**
+     * @brief Reads the command line into `options`.
+     *
+     * @return Whether to run the server or quit right away.
+     */
+    ParseResult parseOptions(const int argc, char **argv, ServerOptions &options) {
+        for (int i = 1; i < argc; ++i) {
+            const char *option = argv[i];
+            if (std::strcmp(option, "-h") == 0 || std::strcmp(option, "--help") == 0) {
+                printUsage(argv[0]);
+                return ParseResult::SHOW_HELP;
+            }
+
+            if (i + 1 >= argc) {
+                std::printf(ANSI_RED "Missing value for option %s\n" ANSI_RESET, option);
+                printUsage(argv[0]);
+                return ParseResult::INVALID;
+            }
+
+            const char *value = argv[++i];
+            unsigned long long number;
+            bool valid;
+            if (std::strcmp(option, "-p") == 0 || std::strcmp(option, "--port") == 0) {
+                valid = parseNumber(value, 1, 65535, number);
+                options.port = static_cast<int>(number);
+            } else if (std::strcmp(option, "-s") == 0 || std::strcmp(option, "--shards") == 0) {
+                valid = parseNumber(value, 1, 1024, number);
+                options.shardCount = number;
+            } else if (std::strcmp(option, "-c") == 0 || std::strcmp(option, "--max-clients") == 0) {
+                valid = parseNumber(value, 0, SIZE_MAX, number);
+                options.maxClients = number;
+            } else if (std::strcmp(option, "-w") == 0 || std::strcmp(option, "--high-water-mark") == 0) {
+                valid = parseNumber(value, 1, SIZE_MAX, number);
+                options.outboundHighWaterMark = number;
+            } else if (std::strcmp(option, "-t") == 0 || std::strcmp(option, "--trace") == 0) {
+                valid = *value != '\0';
+                options.tracePath = value;
+            } else if (std::strcmp(option, "-j") == 0 || std::strcmp(option, "--journal") == 0) {
+                valid = *value != '\0';
+                options.journalDirectory = value;
+            } else if (std::strcmp(option, "-r") == 0 || std::strcmp(option, "--replays") == 0) {
+                valid = *value != '\0';
+                options.replayDirectory = value;
+            } else {
+                std::printf(ANSI_RED "Unknown option %s\n" ANSI_RESET, option);
+                printUsage(argv[0]);
+                return ParseResult::INVALID;
+            }
+
+            if (!valid) {
+                std::printf(ANSI_RED "Invalid value '%s' for option %s\n" ANSI_RESET, value, option);
+                return ParseResult::INVALID;
+            }
+        }
+        return ParseResult::RUN;
+    }
+}
+
+/**
+ * @brief Headless dedicated server entry point.
+ * <br> Runs an InternalGameServer without the SFML client, until SIGINT or SIGTERM.
+ *
+ * @return 0 after a clean shutdown, non-zero if the options were invalid or the port couldn't be bound.
+ */
+int main(const int argc, char **argv) {
+    ServerOptions options;
+    switch (parseOptions(argc, argv, options)) {
+        case ParseResult::RUN:
+            break;
+        case ParseResult::SHOW_HELP:
+            return EXIT_SUCCESS;
+        case ParseResult::INVALID:
+            return EXIT_FAILURE;
+    }
+
+    InternalGameServer server;
+    server.setMaxClients(options.maxClients);
+    server.setOutboundHighWaterMark(options.outboundHighWaterMark);
+    if (options.journalDirectory != nullptr) server.setJournalDirectory(options.journalDirectory);
+    if (options.replayDirectory != nullptr) server.setReplayDirectory(options.replayDirectory);
+
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+    if (options.tracePath != nullptr) {
+        Tracer::setEnabled(true);
+#ifdef SIGUSR1
+        std::signal(SIGUSR1, handleTraceSignal);
+#endif
+    }
+
+    LOG_INFO(SERVER, ANSI_CYAN "[Server] Starting with %zu shard(s), press Ctrl+C to stop.\n" ANSI_RESET,
+             options.shardCount);
+
+    // The first shard runs on the calling thread, so the server gets its own and this one waits for a signal
+    std::atomic<bool> serverFinished = false;
+    bool started = false;
+    std::thread serverThread([&]() {
+        started = server.start(options.port, options.shardCount);
+        serverFinished = true;
+    });
+
+    while (!serverFinished) {
+        // Repeated, a signal can arrive before `start` got going
+        if (stopRequested) server.stop();
+        // Written from here, a signal handler can't touch files
+        if (traceRequested.exchange(false) && options.tracePath != nullptr) {
+            Tracer::exportChromeTrace(options.tracePath);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    serverThread.join();
+
+    if (options.tracePath != nullptr) {
+        Tracer::exportChromeTrace(options.tracePath);
+    }
+    return started ? EXIT_SUCCESS : EXIT_FAILURE;
+}
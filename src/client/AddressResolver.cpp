@@ -0,0 +1,125 @@
+#include "AddressResolver.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+namespace {
+    struct CacheEntry {
+        ResolvedAddress address;
+        std::chrono::steady_clock::time_point expiresAt;
+    };
+
+    struct AddressCache {
+        std::mutex mutex;
+        std::unordered_map<std::string, CacheEntry> entries; //Keyed by "host:port"
+    };
+
+    /**
+     * @brief State shared between a waiting caller and the worker doing the lookup, whichever is done last frees it.
+     */
+    struct Lookup {
+        std::mutex mutex;
+        std::condition_variable finishedSignal;
+        bool finished = false;
+        int error = 0;
+        ResolvedAddress address;
+    };
+
+    // Workers hold their own reference, a lookup outliving the static still has a cache to write to
+    std::shared_ptr<AddressCache> sharedCache() {
+        static const auto cache = std::make_shared<AddressCache>();
+        return cache;
+    }
+
+    void runLookup(const std::shared_ptr<Lookup> &lookup, const std::shared_ptr<AddressCache> &cache,
+                   const std::string &host, const std::string &port) {
+        SocketLayer::startup();
+
+        addrinfo requested{};
+        requested.ai_family = AF_INET;
+        requested.ai_socktype = SOCK_STREAM;
+        requested.ai_protocol = IPPROTO_TCP;
+
+        addrinfo *result = nullptr;
+        const int error = getaddrinfo(host.c_str(), port.c_str(), &requested, &result);
+
+        ResolvedAddress address{};
+        if (error == 0) {
+            std::memcpy(&address.address, result->ai_addr, result->ai_addrlen);
+            address.length = static_cast<socklen_t>(result->ai_addrlen);
+            freeaddrinfo(result);
+
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            cache->entries[host + ":" + port] = {address, std::chrono::steady_clock::now() + AddressResolver::CACHE_TTL};
+        }
+
+        SocketLayer::cleanup();
+
+        {
+            std::lock_guard<std::mutex> lock(lookup->mutex);
+            lookup->error = error;
+            lookup->address = address;
+            lookup->finished = true;
+        }
+        lookup->finishedSignal.notify_all();
+    }
+}
+
+ResolveStatus AddressResolver::resolve(const std::string &host, const std::string &port,
+                                       const std::chrono::steady_clock::time_point deadline,
+                                       const std::atomic<bool> &keepWaiting, ResolvedAddress &outAddress) {
+    const std::shared_ptr<AddressCache> cache = sharedCache();
+
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (const auto entry = cache->entries.find(host + ":" + port); entry != cache->entries.end()) {
+            if (entry->second.expiresAt > std::chrono::steady_clock::now()) {
+                LOG_DEBUG(NETWORK, ANSI_CYAN "[SockClient] Using the cached address of %s\n" ANSI_RESET, host.c_str());
+                outAddress = entry->second.address;
+                return ResolveStatus::RESOLVED;
+            }
+            cache->entries.erase(entry);
+        }
+    }
+
+    const auto lookup = std::make_shared<Lookup>();
+    std::thread(runLookup, lookup, cache, host, port).detach();
+
+    std::unique_lock<std::mutex> lock(lookup->mutex);
+    while (!lookup->finished) {
+        if (!keepWaiting) {
+            return ResolveStatus::CANCELLED;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            LOG_WARN(NETWORK, ANSI_RED "[SockClient] Resolving %s timed out\n" ANSI_RESET, host.c_str());
+            return ResolveStatus::TIMED_OUT;
+        }
+
+        lookup->finishedSignal.wait_until(lock, std::min(deadline, now + std::chrono::milliseconds(WAIT_SLICE_MS)));
+    }
+
+    if (lookup->error != 0) {
+        LOG_ERROR(NETWORK, ANSI_RED "[SockClient] getaddrinfo failed with error: %d\n" ANSI_RESET, lookup->error);
+        return ResolveStatus::FAILED;
+    }
+
+    outAddress = lookup->address;
+    return ResolveStatus::RESOLVED;
+}
+
+void AddressResolver::forget(const std::string &host, const std::string &port) {
+    const std::shared_ptr<AddressCache> cache = sharedCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->entries.erase(host + ":" + port);
+}
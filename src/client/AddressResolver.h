@@ -0,0 +1,61 @@
+#ifndef TICTACTOEOVERLAN_ADDRESSRESOLVER_H
+#define TICTACTOEOVERLAN_ADDRESSRESOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "../common/SocketLayer.h"
+
+/**
+ * @brief A resolved IPv4 endpoint, ready to be passed to `connect`.
+ */
+struct ResolvedAddress {
+    sockaddr_storage address{};
+    socklen_t length = 0;
+};
+
+/**
+ * @brief Outcome of `AddressResolver::resolve`.
+ */
+enum class ResolveStatus : uint8_t {
+    RESOLVED,
+    FAILED, // The name doesn't resolve
+    TIMED_OUT,
+    CANCELLED
+};
+
+/**
+ * @brief Resolves server addresses without letting a slow lookup block the caller past its deadline.
+ * <br> `getaddrinfo` can't be interrupted, so every lookup runs on its own detached worker thread and the caller
+ * only waits for it as long as it wants to. A lookup the caller gave up on still finishes and fills the cache.
+ * <br> Successful lookups are cached process-wide for `CACHE_TTL`, reconnecting to the same server skips the lookup.
+ */
+class AddressResolver {
+public:
+    constexpr static auto CACHE_TTL = std::chrono::minutes(5);
+    constexpr static int WAIT_SLICE_MS = 20; //How often a waiting caller checks if it should give up
+
+    /**
+     * @brief Resolves `host:port` to an IPv4 TCP endpoint, from the cache if possible.
+     *
+     * @param host The IP address (IPv4) or hostname.
+     * @param port The port number as a string.
+     * @param deadline Point in time after which the caller stops waiting.
+     * @param keepWaiting Checked every `WAIT_SLICE_MS`, the caller stops waiting once it turns false.
+     * @param outAddress Output parameter, filled only when `RESOLVED` is returned.
+     * @return Whether the address was resolved, or why not.
+     */
+    static ResolveStatus resolve(const std::string &host, const std::string &port,
+                                 std::chrono::steady_clock::time_point deadline,
+                                 const std::atomic<bool> &keepWaiting, ResolvedAddress &outAddress);
+
+    /**
+     * @brief Drops the cached address of `host:port`, e.g. after connecting to it failed.
+     */
+    static void forget(const std::string &host, const std::string &port);
+};
+
+
+#endif //TICTACTOEOVERLAN_ADDRESSRESOLVER_H
@@ -2,8 +2,10 @@
 
 #include <cmath>
 #include <ranges>
+#include <span>
 #include <thread>
 
+#include "../common/Tracer.h"
 #include "../common/resources/JetBrainsMonoRegularFont.h"
 #include "../common/resources/WindowIcon.h"
 #include "SFML/Graphics/Image.hpp"
@@ -26,7 +28,7 @@ GameClient::GameClient() {
     pieceType = PieceType::EMPTY;
 
     //Debug stuff
-    std::printf(ANSI_CYAN "[GameClient] Initial token %d\n", initialToken);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Initial token %d\n", initialToken);
 
     //Initialize the board with default settings
     boardData.boardSize = 3;
@@ -46,13 +48,13 @@ GameClient::GameClient() {
 
     sf::Image icon;
     if (!icon.loadFromMemory(TicTacToeOverLan_ICON_DATA, sizeof(TicTacToeOverLan_ICON_DATA))) {
-        printf(ANSI_RED "[GameClient] Failed to load the embedded icon\n" ANSI_RESET);
+        LOG_ERROR(CLIENT, ANSI_RED "[GameClient] Failed to load the embedded icon\n" ANSI_RESET);
         return;
     }
     window.setIcon(icon);
 
     if (!font.openFromMemory(JetBrainsMono_Regular, JetBrainsMono_Regular_Len)) {
-        printf(ANSI_RED "[GameClient] Failed to load the embedded font\n" ANSI_RESET);
+        LOG_ERROR(CLIENT, ANSI_RED "[GameClient] Failed to load the embedded font\n" ANSI_RESET);
         return;
     }
 
@@ -61,7 +63,7 @@ GameClient::GameClient() {
 
     this->initWidgets();
 
-    printf(ANSI_GREEN "[GameClient] Setup finished!\n" ANSI_RESET);
+    LOG_INFO(CLIENT, ANSI_GREEN "[GameClient] Setup finished!\n" ANSI_RESET);
 }
 
 void GameClient::initWidgets() {
@@ -86,7 +88,7 @@ void GameClient::initWidgets() {
             [this](const std::string &s) { this->userInputIP = s; })
         .setDisplayCondition([this]() { return this->clientState == ClientState::MENU; })
         .setPosition(MAIN_MENU_POSITION.x + 170, MAIN_MENU_POSITION.y + (DEFAULT_WIDGET_Y_OFFSET * 2) - 1)
-        .setMaxChars(20)
+        .setMaxChars(30)
         .build()
     });
 
@@ -284,6 +286,16 @@ void GameClient::handleInput() {
             if (keyEvent->code == sf::Keyboard::Key::F3) {
                 debugEnabled = !debugEnabled;
             }
+            //Traces the hosted server's ticks, the second press writes them out for chrome://tracing
+            if (keyEvent->code == sf::Keyboard::Key::F4) {
+                if (Tracer::isEnabled()) {
+                    Tracer::setEnabled(false);
+                    Tracer::exportChromeTrace(TRACE_FILE_NAME);
+                } else {
+                    LOG_INFO(CLIENT, ANSI_CYAN "[GameClient] Tracing started, press F4 again to save it.\n" ANSI_RESET);
+                    Tracer::setEnabled(true);
+                }
+            }
         }
 
         // Handle buttons
@@ -336,7 +348,8 @@ void GameClient::handleGameInput(const std::optional<sf::Event> &event, const sf
             const sf::Vector2i gridPos = BoardRenderer::getSquareAt(mousePos, boardData, BOARD_DRAW_AREA);
 
             if ((gridPos.x != -1 || gridPos.y != -1) && gamePhase != GamePhase::GAME_FINISHED) {
-                printf(ANSI_GREEN "[GameClient] Clicked square at: [%d, %d]\n" ANSI_RESET, gridPos.x, gridPos.y);
+                LOG_DEBUG(CLIENT,
+                          ANSI_GREEN "[GameClient] Clicked square at: [%d, %d]\n" ANSI_RESET, gridPos.x, gridPos.y);
                 this->sendMove(gridPos.x, gridPos.y);
             }
         }
@@ -353,122 +366,42 @@ void GameClient::update() {
     }
 
     // Networking
-    PacketHeader header{};
-    std::vector<char> payload;
-
-    while (networkManager.pollPacket(header, payload)) {
-        //S2C packets: SERVER_HELLO[x], SETUP_ACK[x], NEW_PLAYER_JOIN[x], SETTINGS_UPDATE[x], PLAYER_DISCONNECTED[x], GAME_START[x], BOARD_STATE_UPDATE[x], BACK_TO_GAME_ROOM[x], GAME_END[x]
-        switch (header.type) {
-            default: {
-                printf(ANSI_RED "[GameClient] Unknown packet received! Type: %hhd\n", header.type);
-                break;
-            }
-
-            case PacketType::SERVER_HELLO: {
-                printf(ANSI_CYAN "[GameClient] Got a Server Hello packet!\n" ANSI_RESET);
-
-                if (clientState != ClientState::GAME_ROOM) {
-                    printf(
-                        ANSI_RED "Client isn't in the game room state, but we received a SERVER_HELLO packet\n"
-                        ANSI_RESET);
-                }
-
-                const auto *packet = reinterpret_cast<ServerHelloPacket *>(payload.data());
-                this->handleServerHelloPacket(packet);
-
-                break;
-            }
-
-            case PacketType::SETUP_ACK: {
-                printf(ANSI_CYAN "[GameClient] Got a SETUP_ACK packet!\n" ANSI_RESET);
-
-                if (clientState != ClientState::GAME_ROOM) {
-                    printf(
-                        ANSI_RED "Client isn't in the game room state, but we received a SETUP_ACK packet\n"
-                        ANSI_RESET);
-                }
-
-                const auto *packet = reinterpret_cast<SetupAckPacket *>(payload.data());
-                this->handleSetupAckPacket(packet);
-
-                break;
-            }
-
-            case PacketType::NEW_PLAYER_JOIN: {
-                printf(ANSI_CYAN "[GameClient] Got a NEW_PLAYER_JOIN packet!\n" ANSI_RESET);
-
-                if (clientState != ClientState::GAME_ROOM) {
-                    printf(
-                        ANSI_RED "Client isn't in the game room state, but we received a NEW_PLAYER_JOIN packet\n"
-                        ANSI_RESET);
-                }
-
-                const auto *packet = reinterpret_cast<NewPlayerJoinPacket *>(payload.data());
-                this->handleNewPlayerJoinPacket(packet);
-
-                break;
-            }
-
-            case PacketType::SETTINGS_UPDATE: {
-                printf(ANSI_CYAN "[GameClient] Got a SETTINGS_UPDATE packet!\n" ANSI_RESET);
-
-                const auto *packet = reinterpret_cast<SettingsUpdatePacket *>(payload.data());
-                this->handleSettingsUpdatePacket(packet);
-
-                break;
-            }
-
-            case PacketType::PLAYER_DISCONNECTED: {
-                printf(ANSI_CYAN "[GameClient] Got a PLAYER_DISCONNECTED packet!\n" ANSI_RESET);
-
-                const auto *packet = reinterpret_cast<PlayerDisconnectedPacket *>(payload.data());
-                this->handlePlayerDisconnectedPacket(packet);
-
-                break;
-            }
-
-            case PacketType::GAME_START: {
-                printf(ANSI_CYAN "[GameClient] Got a GAME_START packet!\n" ANSI_RESET);
-
-                const auto *packet = reinterpret_cast<GameStartPacket *>(payload.data());
-                this->handleGameStartPacket(packet);
-
-                break;
-            }
-            case PacketType::BOARD_STATE_UPDATE: {
-                printf(ANSI_CYAN "[GameClient] Got a BOARD_STATE_UPDATE packet!\n" ANSI_RESET);
-
-                const auto *packet = reinterpret_cast<BoardStateUpdatePacket *>(payload.data());
-                if (this->handleBoardStateUpdatePacket(packet)) break;
-
-                break;
-            }
-
-            case PacketType::BACK_TO_GAME_ROOM: {
-                printf(ANSI_CYAN "[GameClient] Got a BACK_TO_GAME_ROOM packet, going back.\n" ANSI_RESET);
-
-                clientState = ClientState::GAME_ROOM;
-                gamePhase = GamePhase::WAITING_ROOM;
-
-                break;
-            }
-
-            case PacketType::GAME_END: {
-                printf(ANSI_CYAN "[GameClient] Got a GAME_END packet!\n" ANSI_RESET);
-
-                const auto *packet = reinterpret_cast<GameEndPacket *>(payload.data());
-                this->handleGameEndPacket(packet);
-
-                break;
-            }
+    PacketView packetView{};
+    const bool wasConnecting = networkManager.conPhase == ConnectionPhase::ESTABLISHING;
+
+    while (networkManager.pollPacket(packetView)) {
+        const PacketHeader &header = packetView.header;
+        //S2C packets: SERVER_HELLO[x], SETUP_ACK[x], NEW_PLAYER_JOIN[x], SETTINGS_UPDATE[x], PLAYER_DISCONNECTED[x], GAME_START[x], BOARD_STATE_UPDATE[x], MOVE_APPLIED[x], BACK_TO_GAME_ROOM[x], GAME_END[x]
+        const DispatchResult result = ServerPacketDispatcher::dispatch(*this, packetView);
+
+        if (result == DispatchResult::UNROUTED) {
+            LOG_WARN(CLIENT, ANSI_RED "[GameClient] Unknown packet received! Type: %d\n" ANSI_RESET,
+                     static_cast<int>(header.type));
+        } else if (result == DispatchResult::MALFORMED) {
+            LOG_WARN(CLIENT, ANSI_RED "[GameClient] Dropping a malformed packet! Type: %d, size: %u\n" ANSI_RESET,
+                     static_cast<int>(header.type), header.payloadSize);
         }
     }
+
+    // The connect attempt running in the background failed, there's no room to wait in
+    if (wasConnecting && networkManager.conPhase == ConnectionPhase::DISCONNECTED) {
+        LOG_ERROR(CLIENT, ANSI_RED "[GameClient] Failed to connect at %s...\n" ANSI_RESET, userInputIP.c_str());
+        this->disconnect();
+    }
 }
 
 void GameClient::handleServerHelloPacket(const ServerHelloPacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a Server Hello packet!\n" ANSI_RESET);
+
+    if (clientState != ClientState::GAME_ROOM) {
+        LOG_WARN(CLIENT,
+                 ANSI_RED "Client isn't in the game room state, but we received a SERVER_HELLO packet\n"
+                 ANSI_RESET);
+    }
+
     setupPhase = SetupPhase::SETTING_UP;
     playerId = packet->playerId;
-    printf(ANSI_CYAN "[GameClient] Assigned player ID: %hhu\n" ANSI_RESET, packet->playerId);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Assigned player ID: %hhu\n" ANSI_RESET, packet->playerId);
 
     // Send the SETUP_REQ packet
     SetupReqPacket setupReqPacket{};
@@ -477,20 +410,28 @@ void GameClient::handleServerHelloPacket(const ServerHelloPacket *packet) {
     strncpy(setupReqPacket.playerName, playerName.c_str(), MAX_PLAYER_NAME_LENGTH - 1);
     setupReqPacket.initialToken = initialToken;
     setupReqPacket.isHost = hosting;
+    setupReqPacket.roomId = roomId;
 
-    printf(
-        ANSI_CYAN "[GameClient] Sending SETUP_REQ packet with [pid:%hhu] [pName:%s] [initialToken:%d]\n"
-        ANSI_RESET, playerId, playerName.c_str(), initialToken);
+    LOG_DEBUG(CLIENT,
+              ANSI_CYAN "[GameClient] Sending SETUP_REQ packet with [pid:%hhu] [pName:%s] [initialToken:%d] [room:%u]\n"
+              ANSI_RESET, playerId, playerName.c_str(), initialToken, roomId);
     networkManager.sendPacket<SetupReqPacket>(PacketType::SETUP_REQ, setupReqPacket);
-    printf(ANSI_CYAN "[GameClient] SETUP_REQ sent!\n");
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] SETUP_REQ sent!\n");
 }
 
 void GameClient::handleSetupAckPacket(const SetupAckPacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a SETUP_ACK packet!\n" ANSI_RESET);
+
+    if (clientState != ClientState::GAME_ROOM) {
+        LOG_WARN(CLIENT,
+                 ANSI_RED "Client isn't in the game room state, but we received a SETUP_ACK packet\n"
+                 ANSI_RESET);
+    }
+
     if (playerId != packet->playerId) {
-        printf(
-            ANSI_RED
-            "[GameClient] Somehow got SETUP_ACK dedicated to another player! This shouldn't happen!\n"
-            ANSI_RESET);
+        // The room hands out its own IDs, the one from SERVER_HELLO was only provisional
+        LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Room assigned player ID: %hhu\n" ANSI_RESET, packet->playerId);
+        playerId = packet->playerId;
     }
 
     authToken = packet->generatedAuthToken;
@@ -508,18 +449,26 @@ void GameClient::handleSetupAckPacket(const SetupAckPacket *packet) {
         if (player.playerId == 0) {
             continue;
         }
-        printf("[%hhu, %s, %hhd, %hhd, %hhd]\n", player.playerId, player.playerName, player.piece,
-               player.myTurn, player.isMe);
+        LOG_DEBUG(CLIENT, "[%hhu, %s, %hhd, %hhd, %hhd]\n", player.playerId, player.playerName, player.piece,
+                  player.myTurn, player.isMe);
         players.push_back(player);
     }
 
     setupPhase = SetupPhase::CONNECTED;
     gamePhase = GamePhase::WAITING_ROOM;
-    printf(ANSI_CYAN "[GameClient] Generated AuthToken: %d Other: [name:%s, id:%hhd]\n" ANSI_RESET,
-           authToken, playerName.c_str(), pieceType);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Generated AuthToken: %d Other: [name:%s, id:%hhd]\n" ANSI_RESET,
+              authToken, playerName.c_str(), pieceType);
 }
 
 void GameClient::handleNewPlayerJoinPacket(const NewPlayerJoinPacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a NEW_PLAYER_JOIN packet!\n" ANSI_RESET);
+
+    if (clientState != ClientState::GAME_ROOM) {
+        LOG_WARN(CLIENT,
+                 ANSI_RED "Client isn't in the game room state, but we received a NEW_PLAYER_JOIN packet\n"
+                 ANSI_RESET);
+    }
+
     Player newPlayer{};
     newPlayer.playerId = packet->newPlayerId;
     memset(newPlayer.playerName, 0, MAX_PLAYER_NAME_LENGTH);
@@ -538,15 +487,19 @@ void GameClient::handleNewPlayerJoinPacket(const NewPlayerJoinPacket *packet) {
 }
 
 void GameClient::handleSettingsUpdatePacket(const SettingsUpdatePacket *packet) {
-    printf(ANSI_GREEN "[GameClient] New Board Size: %hhu, New Win Condition Length: %hhu\n" ANSI_RESET,
-           packet->newBoardSize, packet->newWinConditionLength);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a SETTINGS_UPDATE packet!\n" ANSI_RESET);
+
+    LOG_INFO(CLIENT, ANSI_GREEN "[GameClient] New Board Size: %hhu, New Win Condition Length: %hhu\n" ANSI_RESET,
+             packet->newBoardSize, packet->newWinConditionLength);
 
     boardData.boardSize = packet->newBoardSize;
     boardData.winConditionLength = packet->newWinConditionLength;
 }
 
 void GameClient::handlePlayerDisconnectedPacket(const PlayerDisconnectedPacket *packet) {
-    printf(ANSI_YELLOW "[GameClient] Player with ID %hhu has disconnected\n" ANSI_RESET, packet->playerId);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a PLAYER_DISCONNECTED packet!\n" ANSI_RESET);
+
+    LOG_INFO(CLIENT, ANSI_YELLOW "[GameClient] Player with ID %hhu has disconnected\n" ANSI_RESET, packet->playerId);
 
     std::erase_if(players, [packet](const Player &player) {
         return player.playerId == packet->playerId;
@@ -555,8 +508,10 @@ void GameClient::handlePlayerDisconnectedPacket(const PlayerDisconnectedPacket *
 }
 
 void GameClient::handleGameStartPacket(const GameStartPacket *packet) {
-    printf(ANSI_GREEN "[GameClient] The Game is starting... Started by player with ID %hhu\n" ANSI_RESET,
-           packet->requestedByPlayerId);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a GAME_START packet!\n" ANSI_RESET);
+
+    LOG_INFO(CLIENT, ANSI_GREEN "[GameClient] The Game is starting... Started by player with ID %hhu\n" ANSI_RESET,
+             packet->requestedByPlayerId);
 
     boardData.boardSize = packet->finalBoardSize;
     boardData.winConditionLength = packet->finalWinConditionLength;
@@ -570,29 +525,43 @@ void GameClient::handleGameStartPacket(const GameStartPacket *packet) {
     }
 
     Utils::initializeGameBoard(boardData);
-    Utils::deserializeBoard(packet->grid, boardData);
+    if (!Utils::deserializeBoard(packet->snapshot, packet->snapshotSize, boardData)) {
+        LOG_WARN(CLIENT, ANSI_RED "[GameClient] GAME_START carried a malformed board snapshot!\n" ANSI_RESET);
+    }
+    boardSequence = 0;
+    resyncRequested = false;
 
     clientState = ClientState::GAME;
     gamePhase = (playerId == packet->startingPlayerId ? GamePhase::MY_TURN : GamePhase::NOT_MY_TURN);
     isMyTurn = playerId == packet->startingPlayerId;
 }
 
-bool GameClient::handleBoardStateUpdatePacket(const BoardStateUpdatePacket *packet) {
+void GameClient::handleBoardStateUpdatePacket(const BoardStateUpdatePacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a BOARD_STATE_UPDATE packet!\n" ANSI_RESET);
+
     if (clientState != ClientState::GAME) {
-        printf(
-            ANSI_RED "Client isn't in the game state, but we received a BOARD_STATE_UPDATE packet\n"
-            ANSI_RESET);
-        return true;
+        LOG_WARN(CLIENT,
+                 ANSI_RED "Client isn't in the game state, but we received a BOARD_STATE_UPDATE packet\n"
+                 ANSI_RESET);
+        return;
     }
 
     //update board
-    Utils::deserializeBoard(packet->grid, boardData);
+    if (!Utils::deserializeBoard(packet->snapshot, packet->snapshotSize, boardData)) {
+        LOG_WARN(CLIENT, ANSI_RED "[GameClient] BOARD_STATE_UPDATE carried a malformed board snapshot!\n" ANSI_RESET);
+        return;
+    }
 
     boardData.round = packet->round;
     boardData.turn = packet->turn;
     boardData.actingPlayerId = packet->actingPlayerId;
     lastMove = packet->lastMove;
-    moves.push_back(packet->lastMove);
+    //A resync of a state we already have doesn't carry a new move
+    if (packet->sequence != boardSequence) {
+        moves.push_back(packet->lastMove);
+    }
+    boardSequence = packet->sequence;
+    resyncRequested = false;
 
     isMyTurn = playerId == packet->actingPlayerId;
 
@@ -601,12 +570,60 @@ bool GameClient::handleBoardStateUpdatePacket(const BoardStateUpdatePacket *pack
     for (int i = 0; i < packet->playerCount; ++i) {
         players.push_back(packet->players[i]);
     }
-    return false;
+}
+
+void GameClient::handleMoveAppliedPacket(const MoveAppliedPacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a MOVE_APPLIED packet!\n" ANSI_RESET);
+
+    if (clientState != ClientState::GAME) {
+        LOG_WARN(CLIENT,
+                 ANSI_RED "Client isn't in the game state, but we received a MOVE_APPLIED packet\n"
+                 ANSI_RESET);
+        return;
+    }
+
+    if (packet->sequence != boardSequence + 1) {
+        //One request per gap, the moves in flight until the keyframe arrives all miss the same one
+        if (!resyncRequested) {
+            LOG_WARN(CLIENT,
+                     ANSI_RED "[GameClient] Missed a move! [expected: %u, got: %u] Asking for a resync.\n" ANSI_RESET,
+                     boardSequence + 1, packet->sequence);
+            ResyncRequestPacket resyncReq{};
+            resyncReq.playerId = playerId;
+            resyncReq.sequence = boardSequence;
+            this->networkManager.sendPacket(PacketType::RESYNC_REQ, resyncReq);
+            resyncRequested = true;
+        }
+        return;
+    }
+
+    //apply the move
+    BoardSquare square{};
+    square.piece = packet->move.piece;
+    square.playerId = packet->move.playerId;
+    square.turnPlaced = packet->move.turnPlaced;
+    boardData.setSquareAt(packet->move.posX, packet->move.posY, square);
+
+    boardData.round = packet->round;
+    boardData.turn = packet->turn;
+    boardData.actingPlayerId = packet->actingPlayerId;
+    lastMove = packet->move;
+    moves.push_back(packet->move);
+    boardSequence = packet->sequence;
+
+    isMyTurn = playerId == packet->actingPlayerId;
+
+    //update players
+    for (auto &player: players) {
+        player.myTurn = player.playerId == packet->actingPlayerId;
+    }
 }
 
 void GameClient::handleGameEndPacket(const GameEndPacket *packet) {
-    printf(ANSI_GREEN "[GameClient] Player with ID %hhu finished the round!\n" ANSI_RESET,
-           packet->playerId);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a GAME_END packet!\n" ANSI_RESET);
+
+    LOG_INFO(CLIENT, ANSI_GREEN "[GameClient] Player with ID %hhu finished the round!\n" ANSI_RESET,
+             packet->playerId);
 
     gamePhase = GamePhase::GAME_FINISHED;
     finishReason = packet->reason;
@@ -620,6 +637,13 @@ void GameClient::handleGameEndPacket(const GameEndPacket *packet) {
     }
 }
 
+void GameClient::handleBackToGameRoomPacket(const BackToGameRoomPacket *packet) {
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Got a BACK_TO_GAME_ROOM packet, going back.\n" ANSI_RESET);
+
+    clientState = ClientState::GAME_ROOM;
+    gamePhase = GamePhase::WAITING_ROOM;
+}
+
 void GameClient::render() {
     window.clear(sf::Color(BACKGROUND_COLOR));
 
@@ -675,7 +699,11 @@ void GameClient::renderGameRoom() {
     window.draw(text);
 
     // Am I the Host
-    text.setString((hosting ? "You are the host!" : "Someone else is hosting!"));
+    if (networkManager.conPhase == ConnectionPhase::ESTABLISHING) {
+        text.setString("Connecting to " + userInputIP + "...");
+    } else {
+        text.setString((hosting ? "You are the host!" : "Someone else is hosting!"));
+    }
     text.move({0, DEFAULT_WIDGET_Y_OFFSET});
     window.draw(text);
 
@@ -847,7 +875,7 @@ void GameClient::renderDebugMenu() {
     text.setPosition({static_cast<float>(debugMenuPosition.x + 20), static_cast<float>(debugMenuPosition.y + 20)});
     window.draw(text);
 
-    text.setString("Server IP: " + serverAddress + ":" + serverPort);
+    text.setString("Server IP: " + serverAddress + ":" + serverPort + " Room: " + std::to_string(roomId));
     text.move({0, textYOffset});
     window.draw(text);
 
@@ -907,6 +935,21 @@ void GameClient::renderDebugMenu() {
     text.move({0, textYOffset});
     window.draw(text);
 
+    //Heartbeat round trips, as measured by the server
+    const LatencyReport latency = networkManager.getLatencyReport();
+    if (latency.heartbeatCount > 0) {
+        text.setString(std::format(
+            "Ping: Last: {:.1f}ms Median: {:.1f}ms P99: {:.1f}ms",
+            latency.lastRttUs / 1000.0,
+            latency.medianRttUs / 1000.0,
+            latency.p99RttUs / 1000.0
+        ));
+    } else {
+        text.setString("Ping: -");
+    }
+    text.move({0, textYOffset});
+    window.draw(text);
+
     //TODO: Make this prettier -- why are enums like this in cpp???
     std::string setupPhaseString = "Setup Phase: ";
     switch (setupPhase) {
@@ -1004,52 +1047,97 @@ void GameClient::renderDebugMenu() {
 
     //Internal Server stuff
     if (hosting) {
-        text.setString("Internal Game Server Debug");
+        text.setString(Tracer::isEnabled() ? "Internal Game Server Debug [tracing, F4 to save]"
+                                           : "Internal Game Server Debug");
         text.move({0, textYOffset * 2});
         window.draw(text);
 
+        //the tail tells a hiccup apart from a server that's slow all the time
+        const PackagedValues tickTimes = serverLogic.getTickTimes();
         std::string tickString = std::format(
-            "Tick: {} Avg: {:.2f}ms Last: {:.2f}ms",
+            "Tick: {} Avg: {:.2f}ms Last: {:.2f}ms P99: {:.2f}ms P99.9: {:.2f}ms Max: {:.2f}ms",
             serverLogic.getTick(),
-            serverLogic.getAvgTickTime() / 1000000.0,
-            serverLogic.getLastTickTime() / 1000000.0
+            tickTimes.average / 1000000.0,
+            serverLogic.getLastTickTime() / 1000000.0,
+            tickTimes.p99 / 1000000.0,
+            tickTimes.p999 / 1000000.0,
+            tickTimes.max / 1000000.0
         );
         text.setString(tickString);
         text.move({0, textYOffset});
         window.draw(text);
 
+        //round trips of every client, next to the tick time it tells network lag apart from a slow server
+        const LatencyHistogram roundTrips = serverLogic.getRoundTripTimes();
+        text.setString(std::format(
+            "Client RTT: Samples: {} Median: {:.1f}ms P99: {:.1f}ms Max: {:.1f}ms",
+            roundTrips.count(),
+            roundTrips.percentileUs(50) / 1000.0,
+            roundTrips.percentileUs(99) / 1000.0,
+            roundTrips.maxSampleUs() / 1000.0
+        ));
+        text.move({0, textYOffset});
+        window.draw(text);
+
         //server port
         text.setString("ServerPort: " + std::to_string(serverLogic.getServerPort()));
         text.move({0, textYOffset});
         window.draw(text);
 
+        //rooms
+        text.setString("Rooms: " + std::to_string(serverLogic.getRoomCount()));
+        text.move({0, textYOffset});
+        window.draw(text);
+
+        //shards, only worth a line each when there is more than one
+        const auto shardTelemetry = serverLogic.getShardTelemetry();
+        if (shardTelemetry.size() > 1) {
+            for (const auto &shard: shardTelemetry) {
+                text.setString(std::format(
+                    "Shard {}: Tick: {} Avg: {:.2f}ms Last: {:.2f}ms P99: {:.2f}ms Clients: {} Runnable: {}",
+                    shard.shardIndex,
+                    shard.tick,
+                    shard.tickTimes.average / 1000000.0,
+                    shard.lastTickTime / 1000000.0,
+                    shard.tickTimes.p99 / 1000000.0,
+                    shard.clientCount,
+                    shard.runnableRoomCount
+                ));
+                text.move({0, textYOffset});
+                window.draw(text);
+            }
+        }
+
+        //our room, as last published by the shard that owns it
+        serverLogic.watchRoom(roomId);
+        const RoomTelemetry room = serverLogic.getRoomTelemetry(roomId);
+
         //next player id
-        text.setString("NextPlayerID: " + std::to_string(serverLogic.getNextPlayerId()));
+        text.setString("NextPlayerID: " + std::to_string(room.nextPlayerId));
         text.move({0, textYOffset});
         window.draw(text);
 
         //turn
-        text.setString("Turn: " + std::to_string(serverLogic.getCurrentTurn()));
+        text.setString("Turn: " + std::to_string(room.turn));
         text.move({0, textYOffset});
         window.draw(text);
 
         //hosting player
-        text.setString("HostingPlayerID: " + std::to_string(serverLogic.getHostingPlayerId()));
+        text.setString("HostingPlayerID: " + std::to_string(room.hostingPlayerId));
         text.move({0, textYOffset});
         window.draw(text);
 
         //game settings
-        const auto &[srvBoardSize, srvWinConLength] = serverLogic.getBoardSettings();
         std::string gameSettings =
-                "Game Settings[BoardSize: " + std::to_string(srvBoardSize) +
-                ", WinConLength: " + std::to_string(srvWinConLength) + "]";
+                "Game Settings[BoardSize: " + std::to_string(room.boardSize) +
+                ", WinConLength: " + std::to_string(room.winConditionLength) + "]";
         text.setString(gameSettings);
         text.move({0, textYOffset});
         window.draw(text);
 
         //available pieces
         std::string availablePiecesString = "AvPieces[";
-        for (const auto &piece: serverLogic.getAllAvailablePieces()) {
+        for (const auto &piece: std::span(room.availablePieces.data(), room.availablePieceCount)) {
             availablePiecesString += Utils::pieceTypeToString(piece) + ",";
         }
         availablePiecesString += "]";
@@ -1059,7 +1147,7 @@ void GameClient::renderDebugMenu() {
 
         //players
         std::string playersString = "Players[";
-        for (const auto &player: serverLogic.getPlayers()) {
+        for (const auto &player: std::span(room.players.data(), room.playerCount)) {
             std::stringstream ss;
             ss << "{"
                     << static_cast<int>(player.playerId) << ", "
@@ -1076,7 +1164,7 @@ void GameClient::renderDebugMenu() {
 
         //moves
         std::string moveString = "Moves[";
-        for (const auto &move: serverLogic.getMoves()) {
+        for (const auto &move: std::span(room.moves.data(), room.moveCount)) {
             std::stringstream ss;
             ss << "{"
                     << static_cast<int>(move.playerId)
@@ -1094,25 +1182,28 @@ void GameClient::renderDebugMenu() {
     }
 }
 
-std::optional<std::pair<std::string, std::string> > GameClient::parseServerAddrAndPortFromTextField() const {
-    //^((?:\D+).\w{2,8}|(?:\b(?:(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\.){3}(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?))):(\d{1,5}\b)$
+std::optional<std::tuple<std::string, std::string, uint32_t> >
+GameClient::parseServerAddrAndPortFromTextField() const {
+    //^((?:\D+).\w{2,8}|(?:\b(?:(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\.){3}(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?))):(\d{1,5}\b)(?:/(\d{1,9}))?$
     // Examples:
     // 192.168.2.32:27015 <- valid -> Group 1: 192.168.2.32 Group 2: 27015
     // domain.example.com:27015 <- valid -> Group 1: domain.example.com Group 2: 27015
     // 129.212.913.123:12312 <- invalid
     // localhost:27015 <- valid -> Group 1: localhost Group 2: 27015
+    // localhost:27015/42 <- valid -> Group 1: localhost Group 2: 27015 Group 3: 42
     static std::regex SERVER_IP_PATTERN(
-        R"(^((?:\D+).\w{2,8}|(?:\b(?:(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\.){3}(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?))):(\d{1,5}\b)$)");
+        R"(^((?:\D+).\w{2,8}|(?:\b(?:(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?)\.){3}(?:25[0-5]|2[0-4][0-9]|[01]?[0-9][0-9]?))):(\d{1,5}\b)(?:/(\d{1,9}))?$)");
     if (std::smatch matches; std::regex_match(userInputIP, matches, SERVER_IP_PATTERN)) {
         // serverAddress = matches[1].str();
         // serverPort = matches[2].str();
+        const uint32_t parsedRoomId = matches[3].matched ? std::stoul(matches[3].str()) : DEFAULT_ROOM_ID;
 
-        return std::make_optional(std::make_pair(matches[1].str(), matches[2].str()));
+        return std::make_optional(std::make_tuple(matches[1].str(), matches[2].str(), parsedRoomId));
     }
 
-    printf(
-        ANSI_RED "[GameClient] Please input a valid server address in the format: {ip/address}:{port}\n"
-        ANSI_RESET);
+    LOG_WARN(CLIENT,
+             ANSI_RED "[GameClient] Please input a valid server address in the format: {ip/address}:{port}[/{room}]\n"
+             ANSI_RESET);
 
     return std::nullopt;
 }
@@ -1123,19 +1214,31 @@ void GameClient::connectAndSetup() {
         return;
     }
 
-    serverAddress = serverAddrOpt.value().first;
-    serverPort = serverAddrOpt.value().second;
+    std::tie(serverAddress, serverPort, roomId) = serverAddrOpt.value();
 
-    printf(ANSI_CYAN "[GameClient] Connecting to a server at %s... [%s, %s]\n" ANSI_RESET,
-           userInputIP.c_str(), serverAddress.c_str(), serverPort.c_str());
+    LOG_INFO(CLIENT, ANSI_CYAN "[GameClient] Connecting to a server at %s... [%s, %s, room %u]\n" ANSI_RESET,
+             userInputIP.c_str(), serverAddress.c_str(), serverPort.c_str(), roomId);
 
-    int conResult = networkManager.connectToServer(serverAddress, serverPort);
-    if (conResult == 0 || conResult == 1) {
-        clientState = ClientState::GAME_ROOM;
-    } else {
-        clientState = ClientState::MENU;
-        printf(ANSI_RED "[GameClient] Failed to connect at %s...\n" ANSI_RESET, userInputIP.c_str());
+    bool connectedInProcess = false;
+    if (this->isOwnServer(serverAddress, serverPort)) {
+        // Our own server runs in this process, skip the TCP stack and hand packets over directly
+        if (auto channel = serverLogic.connectLoopback(); channel != nullptr) {
+            networkManager.connectLoopback(std::move(channel));
+            connectedInProcess = true;
+        }
+    }
+    if (!connectedInProcess) {
+        // Returns right away, `update` goes back to the menu if the attempt fails
+        networkManager.connectToServer(serverAddress, serverPort);
+    }
+    clientState = ClientState::GAME_ROOM;
+}
+
+bool GameClient::isOwnServer(const std::string &address, const std::string &port) const {
+    if (!hosting || port != std::to_string(serverLogic.getServerPort())) {
+        return false;
     }
+    return address == "localhost" || address == "127.0.0.1";
 }
 
 void GameClient::disconnect() {
@@ -1153,15 +1256,15 @@ void GameClient::requestBoardSettingsUpdate(const uint8_t newBoardSize, const ui
     changeReq.newBoardSize = newBoardSize;
     changeReq.newWinConditionLength = newWinConditionLength;
 
-    printf(
-        ANSI_CYAN "[GameClient] Sending settings change request packet with [boardSize: %hhu, winLength: %hhu]\n"
-        ANSI_RESET, newBoardSize, newWinConditionLength);
+    LOG_DEBUG(CLIENT,
+              ANSI_CYAN "[GameClient] Sending settings change request packet with [boardSize: %hhu, winLength: %hhu]\n"
+              ANSI_RESET, newBoardSize, newWinConditionLength);
     this->networkManager.sendPacket(PacketType::SETTINGS_CHANGE_REQ, changeReq);
 }
 
 
 void GameClient::startGame(bool newGame) {
-    printf(ANSI_CYAN "[GameClient] Sending Start Game Request!\n" ANSI_RESET);
+    LOG_DEBUG(CLIENT, ANSI_CYAN "[GameClient] Sending Start Game Request!\n" ANSI_RESET);
     GameStartRequestPacket startReq{};
     startReq.requestingPlayerId = playerId;
     startReq.newGame = newGame;
@@ -1170,7 +1273,7 @@ void GameClient::startGame(bool newGame) {
 }
 
 void GameClient::sendMove(uint8_t posX, uint8_t posY) {
-    printf(ANSI_GREEN "[GameClient] Sending move packet with [x:%hhu, y:%hhu]]\n" ANSI_RESET, posX, posY);
+    LOG_DEBUG(CLIENT, ANSI_GREEN "[GameClient] Sending move packet with [x:%hhu, y:%hhu]]\n" ANSI_RESET, posX, posY);
     MoveRequestPacket moveReq{};
     moveReq.playerId = playerId;
     moveReq.x = posX;
@@ -1184,24 +1287,31 @@ void GameClient::sendMove(uint8_t posX, uint8_t posY) {
 void GameClient::startInternalServerThread() {
     auto serverAddrOpt = this->parseServerAddrAndPortFromTextField();
     if (!serverAddrOpt.has_value()) {
-        printf(ANSI_RED "[GameClient] Invalid address and port, can't start the server with this!\n" ANSI_RESET);
+        LOG_ERROR(CLIENT,
+                  ANSI_RED "[GameClient] Invalid address and port, can't start the server with this!\n" ANSI_RESET);
         return;
     }
 
-    serverPort = serverAddrOpt.value().second;
+    serverPort = std::get<1>(serverAddrOpt.value());
+    roomId = std::get<2>(serverAddrOpt.value());
 
-    printf(ANSI_CYAN "[GameClient] Internal Server is starting...\n" ANSI_RESET);
+    LOG_INFO(CLIENT, ANSI_CYAN "[GameClient] Internal Server is starting...\n" ANSI_RESET);
+    // If the last hosted game crashed, the rooms come back and the players get their seats back by rejoining
+    serverLogic.setJournalDirectory(JOURNAL_DIRECTORY);
+    serverLogic.setReplayDirectory(REPLAY_DIRECTORY);
     serverThread = std::thread([this]() {
         serverLogic.start(std::stoi(serverPort));
     });
 
     const auto widget = reinterpret_cast<TextFieldWidget *>(widgets["server_ip_input"].get());
     widget->setActive(false);
-    widget->setText(std::format("localhost:{}", serverPort));
+    widget->setText(roomId == DEFAULT_ROOM_ID
+                        ? std::format("localhost:{}", serverPort)
+                        : std::format("localhost:{}/{}", serverPort, roomId));
 }
 
 void GameClient::stopInternalServerThread() {
-    printf(ANSI_YELLOW "[GameClient] Internal Server is stopping...\n" ANSI_RESET);
+    LOG_INFO(CLIENT, ANSI_YELLOW "[GameClient] Internal Server is stopping...\n" ANSI_RESET);
 
     const auto widget = reinterpret_cast<TextFieldWidget *>(widgets["server_ip_input"].get());
     widget->setActive(true);
@@ -6,6 +6,7 @@
 #include <thread>
 
 #include "NetworkManager.h"
+#include "../common/PacketDispatcher.h"
 #include "../server/InternalGameServer.h"
 #include "SFML/Graphics/Font.hpp"
 #include "SFML/Graphics/RenderWindow.hpp"
@@ -69,6 +70,9 @@ public:
     constexpr static sf::Vector2f MAIN_MENU_POSITION{36, 36}; //left corner
     constexpr static sf::Vector2f GAME_ROOM_POSITION{36, 36}; //left corner
     constexpr static int DEFAULT_TEXT_SIZE = 20;
+    constexpr static auto TRACE_FILE_NAME = "tictactoe-trace.json"; //Written next to the executable by F4
+    constexpr static auto JOURNAL_DIRECTORY = "tictactoe-journal"; //The hosted server's crash recovery journal
+    constexpr static auto REPLAY_DIRECTORY = "tictactoe-replays"; //Where the hosted server archives finished games
     constexpr static int DEFAULT_WIDGET_Y_OFFSET{DEFAULT_TEXT_SIZE + DEFAULT_TEXT_SIZE / 2};
     constexpr static sf::FloatRect BOARD_DRAW_AREA = {
         {300.0f, 60.0f},
@@ -88,6 +92,7 @@ public:
     std::string userInputIP;
     std::string serverAddress;
     std::string serverPort;
+    uint32_t roomId = DEFAULT_ROOM_ID;
     bool hosting = false;
 
     //The player
@@ -103,6 +108,8 @@ public:
     std::vector<Player> players;
     std::vector<Move> moves;
     Move lastMove;
+    uint32_t boardSequence = 0; //Sequence number of the last move applied to `boardData`
+    bool resyncRequested = false; //Sent a RESYNC_REQ, the moves until the keyframe arrives are ignored
     bool isMyTurn = false;
     FinishReason finishReason;
     Player gameEndPlayer;
@@ -211,7 +218,16 @@ private:
      *
      * @param packet The parsed BoardStateUpdatePacket packet
      */
-    bool handleBoardStateUpdatePacket(const BoardStateUpdatePacket *packet);
+    void handleBoardStateUpdatePacket(const BoardStateUpdatePacket *packet);
+
+    /**
+     * @brief Processes the MOVE_APPLIED packet.
+     * <br> Applies the move to the local board. If a move was missed it asks the server for a keyframe with a
+     * RESYNC_REQ instead, and ignores the moves until the BOARD_STATE_UPDATE arrives.
+     *
+     * @param packet The parsed MoveAppliedPacket packet
+     */
+    void handleMoveAppliedPacket(const MoveAppliedPacket *packet);
 
     /**
      * @brief Processes the GAME_END packet.
@@ -220,6 +236,26 @@ private:
      */
     void handleGameEndPacket(const GameEndPacket *packet);
 
+    /**
+     * @brief Processes the BACK_TO_GAME_ROOM packet.
+     *
+     * @param packet The parsed BackToGameRoomPacket packet
+     */
+    void handleBackToGameRoomPacket(const BackToGameRoomPacket *packet);
+
+    // S2C packets, one handler per type
+    using ServerPacketDispatcher = PacketDispatcher<void(GameClient &),
+        PacketRoute<PacketType::SERVER_HELLO, &GameClient::handleServerHelloPacket>,
+        PacketRoute<PacketType::SETUP_ACK, &GameClient::handleSetupAckPacket>,
+        PacketRoute<PacketType::NEW_PLAYER_JOIN, &GameClient::handleNewPlayerJoinPacket>,
+        PacketRoute<PacketType::SETTINGS_UPDATE, &GameClient::handleSettingsUpdatePacket>,
+        PacketRoute<PacketType::PLAYER_DISCONNECTED, &GameClient::handlePlayerDisconnectedPacket>,
+        PacketRoute<PacketType::GAME_START, &GameClient::handleGameStartPacket>,
+        PacketRoute<PacketType::BOARD_STATE_UPDATE, &GameClient::handleBoardStateUpdatePacket>,
+        PacketRoute<PacketType::MOVE_APPLIED, &GameClient::handleMoveAppliedPacket>,
+        PacketRoute<PacketType::BACK_TO_GAME_ROOM, &GameClient::handleBackToGameRoomPacket>,
+        PacketRoute<PacketType::GAME_END, &GameClient::handleGameEndPacket>>;
+
     void renderMenu();
 
     void renderGameRoom();
@@ -244,16 +280,22 @@ private:
 
     /**
      * @brief Initiates connection to the server (local or remote).
-     * <br> Transitions SetupPhase from DISCONNECTED to SETTING_UP.
+     * <br> Returns right away, the connection is established in the background while the game room shows the progress.
+     * <br> Transitions SetupPhase from DISCONNECTED to SETTING_UP once the server greets us.
      */
     void connectAndSetup();
 
     /**
-     * @brief Attempts to parse the text from the server address TextFieldWidget as Server IP and Port.
+     * @brief Attempts to parse the text from the server address TextFieldWidget as Server IP, Port and optional Room ID.
      *
-     * @return An optional that may contain a pair of server address and port.
+     * @return An optional that may contain the server address, port and room ID.
+     */
+    std::optional<std::tuple<std::string, std::string, uint32_t>> parseServerAddrAndPortFromTextField() const;
+
+    /**
+     * @brief Checks if an address points at the server this client is hosting, which can be joined in-process.
      */
-    std::optional<std::pair<std::string, std::string>> parseServerAddrAndPortFromTextField() const;
+    bool isOwnServer(const std::string &address, const std::string &port) const;
 
     /**
      * @brief Disconnects from the server and resets networking state.
@@ -0,0 +1,68 @@
+#include "LoopbackTransport.h"
+
+#include <cstdio>
+
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+LoopbackTransport::LoopbackTransport(std::shared_ptr<LoopbackChannel> channel) : channel(std::move(channel)) {
+}
+
+LoopbackTransport::~LoopbackTransport() {
+    this->close();
+}
+
+bool LoopbackTransport::receiveFrame(SharedFrame &outFrame) {
+    if (!connected) {
+        return false;
+    }
+
+    // Checked first, everything the server sent before closing is still delivered
+    const bool closed = channel->isClosedByServer();
+    if (!channel->receiveFromServer(outFrame)) {
+        connected = !closed;
+        return false;
+    }
+    return true;
+}
+
+void LoopbackTransport::waitForData(bool) {
+    if (!connected) {
+        return;
+    }
+    channel->waitForServer();
+}
+
+void LoopbackTransport::wakeup() {
+    if (channel != nullptr) {
+        channel->wakeClient();
+    }
+}
+
+bool LoopbackTransport::send(std::vector<char> &&frame) {
+    if (!connected) {
+        return false;
+    }
+
+    // A dropped frame would leave the server missing a packet, the connection is broken from here on
+    if (!channel->sendToServer(std::make_shared<const std::vector<char>>(std::move(frame)))) {
+        LOG_ERROR(NETWORK, ANSI_RED "[SockClient] Error sending data!\n" ANSI_RESET);
+        connected = false;
+        return false;
+    }
+    return true;
+}
+
+bool LoopbackTransport::isConnected() const {
+    return connected;
+}
+
+void LoopbackTransport::close() {
+    if (channel == nullptr) {
+        return;
+    }
+
+    channel->closeFromClient();
+    channel.reset();
+    connected = false;
+}
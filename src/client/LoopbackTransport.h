@@ -0,0 +1,41 @@
+#ifndef TICTACTOEOVERLAN_LOOPBACKTRANSPORT_H
+#define TICTACTOEOVERLAN_LOOPBACKTRANSPORT_H
+
+#include <memory>
+
+#include "Transport.h"
+#include "../server/LoopbackChannel.h"
+
+/**
+ * @brief `Transport` to the InternalGameServer hosted by this client, without going through a socket.
+ * <br> Frames are exchanged by reference over a `LoopbackChannel`, each one holds exactly one packet,
+ * so the server's frames are handed out as they are.
+ */
+class LoopbackTransport final : public Transport {
+    std::shared_ptr<LoopbackChannel> channel;
+    bool connected = true;
+
+public:
+    explicit LoopbackTransport(std::shared_ptr<LoopbackChannel> channel);
+
+    ~LoopbackTransport() override;
+
+    bool receiveFrame(SharedFrame &outFrame) override;
+
+    /**
+     * @brief Waits on the channel, which the server signals with every frame it sends.
+     * <br> Frames the server sends while `watchData` is false still end the next wait early.
+     */
+    void waitForData(bool watchData) override;
+
+    void wakeup() override;
+
+    bool send(std::vector<char> &&frame) override;
+
+    bool isConnected() const override;
+
+    void close() override;
+};
+
+
+#endif //TICTACTOEOVERLAN_LOOPBACKTRANSPORT_H
@@ -1,111 +1,174 @@
 #include "NetworkManager.h"
 
-int NetworkManager::connectToServer(const std::string &address, const std::string &port = "27015") {
-    conPhase = ConnectionPhase::DISCONNECTED;
+#include <cstring>
 
-    //Prepare the Windows socket api
-    startResult = WSAStartup(REQ_SOCK_VERSION, &wsadata);
-    if (startResult != 0) {
-        printf(ANSI_RED "[SockServer] WSAStartup failed with error: %d\n" ANSI_RESET, startResult);
-        return startResult;
-    }
+#include "LoopbackTransport.h"
+#include "TcpTransport.h"
+
+NetworkManager::~NetworkManager() {
+    this->disconnect();
+}
+
+void NetworkManager::connectToServer(const std::string &address, const std::string &port = "27015") {
+    this->disconnect();
+
+    auto tcpTransport = std::make_unique<TcpTransport>();
+    TcpTransport *connecting = tcpTransport.get();
+    transport = std::move(tcpTransport);
 
     conPhase = ConnectionPhase::ESTABLISHING;
+    linkPhase = ConnectionPhase::ESTABLISHING;
+    ioRunning = true;
+
+    // Resolving and connecting can take seconds, the UI thread only watches `linkPhase`
+    ioThread = std::thread([this, connecting, address, port, timeoutMs = connectTimeoutMs]() {
+        if (!connecting->connect(address, port, timeoutMs, ioRunning)) {
+            linkPhase = ConnectionPhase::DISCONNECTED;
+            return;
+        }
 
-    //Websocket configuration
-    struct addrinfo *result = nullptr, *ptr = nullptr, requested{};
+        LOG_INFO(NETWORK, ANSI_GREEN "[SockClient] Connection established" ANSI_RESET "\n");
+        linkPhase = ConnectionPhase::ESTABLISHED;
+        this->runIo();
+    });
+}
 
-    ZeroMemory(&requested, sizeof(requested));
-    requested.ai_family = AF_INET;
-    requested.ai_socktype = SOCK_STREAM;
-    requested.ai_protocol = IPPROTO_TCP;
+void NetworkManager::connectLoopback(std::shared_ptr<LoopbackChannel> channel) {
+    this->disconnect();
 
-    startResult = getaddrinfo(address.c_str(), port.c_str(), &requested, &result);
-    if (startResult != 0) {
-        printf(ANSI_RED "[SockClient] getaddrinfo failed with error: %d\n" ANSI_RESET, startResult);
-        WSACleanup();
-        return startResult;
-    }
+    transport = std::make_unique<LoopbackTransport>(std::move(channel));
+    conPhase = ConnectionPhase::ESTABLISHED;
+    linkPhase = ConnectionPhase::ESTABLISHED;
+    ioRunning = true;
+    ioThread = std::thread(&NetworkManager::runIo, this);
+    LOG_INFO(NETWORK, ANSI_GREEN "[SockClient] Connection established (in-process)" ANSI_RESET "\n");
+}
 
-    printf(ANSI_CYAN "[SockClient] Result %p" ANSI_RESET "\n", result->ai_addr);
+void NetworkManager::setConnectTimeout(const int timeoutMs) {
+    connectTimeoutMs = timeoutMs;
+}
 
-    //Create the socket
-    clientSocket = INVALID_SOCKET;
-    clientSocket = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
-    if (clientSocket == INVALID_SOCKET) {
-        printf("[SockClient] socket failed with error: %d\n", WSAGetLastError());
-        freeaddrinfo(result);
-        WSACleanup();
-        return startResult;
+void NetworkManager::disconnect() {
+    ioRunning = false;
+    if (ioThread.joinable()) {
+        transport->wakeup();
+        ioThread.join();
     }
 
-    //Connect to the server
-    startResult = connect(clientSocket, result->ai_addr, static_cast<int>(result->ai_addrlen));
-    if (startResult != 0) {
-        printf(ANSI_RED "[SockClient] connect failed with error: %d" ANSI_RESET "\n", startResult);
-        freeaddrinfo(result);
-        WSACleanup();
-        return startResult;
+    if (transport != nullptr) {
+        transport->close();
+        transport.reset();
     }
 
-    //Make the socket non-blocking
-    u_long mode = 1;
-    ioctlsocket(clientSocket, FIONBIO, &mode);
+    // The I/O thread is gone, whatever it left behind belongs to no connection anymore
+    SharedFrame droppedPacket;
+    while (inbound.tryPop(droppedPacket)) {
+    }
+    std::vector<char> droppedFrame;
+    while (outbound.tryPop(droppedFrame)) {
+    }
+    currentPacket.reset();
 
-    //Free the address configuration
-    freeaddrinfo(result);
-    conPhase = ConnectionPhase::ESTABLISHED;
-    printf(ANSI_GREEN "[SockClient] Connection established" ANSI_RESET "\n");
-    return startResult;
-}
+    lastRttUs = 0;
+    medianRttUs = 0;
+    p99RttUs = 0;
+    heartbeatCount = 0;
 
-void NetworkManager::disconnect() {
-    shutdown(clientSocket, SD_SEND);
-    closesocket(clientSocket);
-    clientSocket = INVALID_SOCKET;
-    WSACleanup();
+    linkPhase = ConnectionPhase::DISCONNECTED;
+    conPhase = ConnectionPhase::DISCONNECTED;
 }
 
-bool NetworkManager::pollPacket(PacketHeader &outHeader, std::vector<char> &outPayload) {
-    char tempBuffer[DEFAULT_BUFFER_LEN];
-
-    const int bytesReceived = recv(clientSocket, tempBuffer, sizeof(tempBuffer), 0);
+bool NetworkManager::pollPacket(PacketView &outPacket) {
+    // The packet handed out by the previous call has been processed by now
+    currentPacket.reset();
 
-    if (bytesReceived > 0) {
-        receiveBuffer.insert(receiveBuffer.end(), tempBuffer, tempBuffer + bytesReceived);
-    } else if (bytesReceived == 0) {
-        conPhase = ConnectionPhase::DISCONNECTED;
-        return false;
-    } else {
-        const int error = WSAGetLastError();
-        if (error != WSAEWOULDBLOCK) {
-            //
+    // Read before popping, everything received before the connection dropped is still handed out
+    const ConnectionPhase phase = linkPhase;
+    if (inbound.tryPop(currentPacket)) {
+        // The I/O thread is holding a packet back until there's room for it
+        if (ioWaitingForRoom.exchange(false)) {
+            transport->wakeup();
         }
-    }
 
-    if (receiveBuffer.size() < sizeof(PacketHeader)) {
-        // We don't have enough for a full header, wait for more bytes
-        return false;
+        conPhase = ConnectionPhase::ESTABLISHED;
+        std::memcpy(&outPacket.header, currentPacket->data(), sizeof(PacketHeader));
+        outPacket.payload = currentPacket->data() + sizeof(PacketHeader);
+        return true;
     }
 
-    const auto *pendingHeader = reinterpret_cast<PacketHeader *>(receiveBuffer.data());
+    conPhase = phase;
+    return false;
+}
 
-    const size_t totalPacketSize = sizeof(PacketHeader) + pendingHeader->payloadSize;
+LatencyReport NetworkManager::getLatencyReport() const {
+    return {lastRttUs, medianRttUs, p99RttUs, heartbeatCount};
+}
 
-    if (receiveBuffer.size() < totalPacketSize) {
-        // We have the header, but not the full data
+bool NetworkManager::answerHeartbeat(const SharedFrame &frame) {
+    PacketHeader header;
+    std::memcpy(&header, frame->data(), sizeof(PacketHeader));
+    if (header.type != PacketType::PING) {
         return false;
     }
 
-    outHeader = *pendingHeader;
-    outPayload.clear();
-    if (outHeader.payloadSize > 0) {
-        outPayload.insert(
-            outPayload.end(),
-            receiveBuffer.begin() + sizeof(PacketHeader),
-            receiveBuffer.begin() + totalPacketSize);
+    if (!PacketSpec<PacketType::PING>::hasValidSize(frame->data() + sizeof(PacketHeader), header.payloadSize)) {
+        LOG_WARN(NETWORK, ANSI_RED "[SockClient] Server sent a malformed PING, ignoring it\n" ANSI_RESET);
+        return true;
     }
 
-    receiveBuffer.erase(receiveBuffer.begin(), receiveBuffer.begin() + totalPacketSize);
+    PingPacket ping;
+    std::memcpy(&ping, frame->data() + sizeof(PacketHeader), sizeof(PingPacket));
+
+    PongPacket pong{};
+    pong.sequence = ping.sequence;
+    pong.sentAtUs = ping.sentAtUs;
+    transport->send(encodePacket(PacketType::PONG, pong));
+
+    lastRttUs = ping.lastRttUs;
+    medianRttUs = ping.medianRttUs;
+    p99RttUs = ping.p99RttUs;
+    ++heartbeatCount;
     return true;
 }
+
+void NetworkManager::runIo() {
+    SharedFrame pendingPacket; //Received, but the UI thread hasn't made room for it yet
+
+    while (ioRunning) {
+        // A failed send broke the connection, the rest is dropped once the I/O thread ends
+        std::vector<char> frame;
+        while (outbound.tryPop(frame) && transport->send(std::move(frame))) {
+        }
+
+        // Drain everything that arrived, a packet that doesn't fit waits in `pendingPacket`
+        while (pendingPacket != nullptr || transport->receiveFrame(pendingPacket)) {
+            if (this->answerHeartbeat(pendingPacket)) {
+                pendingPacket.reset();
+                continue;
+            }
+            if (!inbound.tryPush(std::move(pendingPacket))) {
+                ioWaitingForRoom = true;
+                // The UI thread may have made room between the failed push and setting the flag
+                if (!inbound.tryPush(std::move(pendingPacket))) {
+                    break;
+                }
+                ioWaitingForRoom = false;
+            }
+            pendingPacket.reset();
+        }
+
+        if (!transport->isConnected() && pendingPacket == nullptr) {
+            linkPhase = ConnectionPhase::DISCONNECTED;
+            return;
+        }
+
+        // With a packet held back the socket may still be readable, waiting on it would spin until the UI
+        // thread catches up. Outgoing packets, room in the inbound queue and disconnecting all call `wakeup`
+        transport->waitForData(pendingPacket == nullptr);
+    }
+
+    // Whatever the UI thread queued right before disconnecting still goes out
+    std::vector<char> frame;
+    while (outbound.tryPop(frame) && transport->send(std::move(frame))) {
+    }
+}
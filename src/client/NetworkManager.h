@@ -1,12 +1,18 @@
 #ifndef TICTACTOEOVERLAN_NETWORKMANAGER_H
 #define TICTACTOEOVERLAN_NETWORKMANAGER_H
+#include <atomic>
+#include <memory>
 #include <string>
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include <thread>
+#include <vector>
+
+#include "Transport.h"
 #include "../common/NetworkProtocol.h"
+#include "../common/PacketFramer.h"
+#include "../common/SpscQueue.h"
+#include "../common/Logger.h"
 #include "../common/Utils.h"
-
-#pragma comment(lib, "Ws2_32.lib")
+#include "../server/LoopbackChannel.h"
 
 /**
  * @brief Represents the state of the raw socket connection.
@@ -18,49 +24,101 @@ enum class ConnectionPhase : uint8_t {
 };
 
 /**
- * @brief Manages low-level TCP network communication.
- * <br> Wraps the Winsock API to provide a cleaner interface
- * for connecting, disconnecting, and exchanging structured packets.
+ * @brief Round trip times the server measured for this client, as reported in its last PING.
+ */
+struct LatencyReport {
+    uint32_t lastRttUs;
+    uint32_t medianRttUs;
+    uint32_t p99RttUs;
+    uint32_t heartbeatCount; //PINGs answered on this connection
+};
+
+/**
+ * @brief Manages the client's connection to a server.
+ * <br> Provides a clean interface for connecting, disconnecting, and exchanging structured packets,
+ * over whichever `Transport` the connection uses: TCP for remote servers, or an in-process
+ * `LoopbackChannel` when talking to the server this client hosts.
  * <br> Handles packet framing (Header + Payload) and ensures data integrity during sends.
+ * <br> Once connected, the transport is driven by a dedicated I/O thread that drains it as soon as data arrives
+ * and hands complete packets to the UI thread through a lock-free queue, so reception isn't tied to the frame rate.
+ * Outgoing packets take the same way back and wake the I/O thread, which otherwise blocks on the transport.
  */
 class NetworkManager {
 public:
-    ConnectionPhase conPhase = ConnectionPhase::DISCONNECTED;
-    int startResult = -1;
-    WSADATA wsadata = {};
-    SOCKET clientSocket;
-    std::vector<char> receiveBuffer;
+    constexpr static size_t INBOUND_QUEUE_CAPACITY = 256; //Packets received but not yet polled by the UI thread
+    constexpr static size_t OUTBOUND_QUEUE_CAPACITY = 64; //Packets queued by the UI thread but not yet sent
+    constexpr static int DEFAULT_CONNECT_TIMEOUT_MS = 5000;
+
+    ConnectionPhase conPhase = ConnectionPhase::DISCONNECTED; //As last seen by the UI thread
+
+private:
+    std::unique_ptr<Transport> transport; //Owned by the I/O thread while it runs
+    int connectTimeoutMs = DEFAULT_CONNECT_TIMEOUT_MS;
+
+    std::thread ioThread;
+    std::atomic<bool> ioRunning = false;
+    std::atomic<ConnectionPhase> linkPhase = ConnectionPhase::DISCONNECTED; //Advanced by the I/O thread
+    std::atomic<bool> ioWaitingForRoom = false; //The inbound queue was full, wake the I/O thread once it's polled
+
+    SpscQueue<SharedFrame, INBOUND_QUEUE_CAPACITY> inbound;
+    SpscQueue<std::vector<char>, OUTBOUND_QUEUE_CAPACITY> outbound;
+    SharedFrame currentPacket; //Backs the packet last returned by `pollPacket`
+
+    // Written by the I/O thread when it answers a PING
+    std::atomic<uint32_t> lastRttUs = 0;
+    std::atomic<uint32_t> medianRttUs = 0;
+    std::atomic<uint32_t> p99RttUs = 0;
+    std::atomic<uint32_t> heartbeatCount = 0;
+
+public:
+    NetworkManager() = default;
+
+    ~NetworkManager();
+
+    NetworkManager(const NetworkManager &) = delete;
+
+    NetworkManager &operator=(const NetworkManager &) = delete;
 
     /**
-     * @brief Attempts to establish a TCP connection to a server.
-     * <br> Initializes Winsock, creates a socket, and attempts to connect to the specified end point.
+     * @brief Starts establishing a TCP connection to a server, without blocking the caller.
+     * <br> Resolving and connecting happen on the I/O thread, `conPhase` stays `ESTABLISHING` meanwhile and turns
+     * `ESTABLISHED` or `DISCONNECTED` once `pollPacket` sees the outcome.
+     * Packets sent in the meantime go out once connected.
      *
      * @param address The IP address (IPv4) or hostname of the server.
      * @param port The port number as a string.
-     * @return 0 on success, non-zero error code on failure.
      */
-    int connectToServer(const std::string &address, const std::string &port);
+    void connectToServer(const std::string &address, const std::string &port);
 
     /**
-     * @brief Closes the socket and cleans up Winsock resources.
+     * @brief Connects to the server hosted by this client, in-process instead of over TCP.
+     *
+     * @param channel The channel returned by `InternalGameServer::connectLoopback`.
+     */
+    void connectLoopback(std::shared_ptr<LoopbackChannel> channel);
+
+    /**
+     * @brief Sets how long resolving and connecting may take together, applies to the next `connectToServer`.
+     */
+    void setConnectTimeout(int timeoutMs);
+
+    /**
+     * @brief Stops the I/O thread, closes the connection and cleans up the transport.
      */
     void disconnect();
 
     /**
-     * @brief Checks the socket for incoming data and attempts to extract a single complete packet.
-     * <br> This function handles TCP stream fragmentation. If enough data has arrived to form
-     * a full packet (Header + defined Payload size), it extracts it.
+     * @brief Takes the next packet the I/O thread received, and updates `conPhase`.
+     * <br> The payload stays valid until the next call.
      *
-     * * @param outHeader Output parameter to store the parsed packet header.
-     * @param outPayload Output parameter to store the raw byte payload.
+     * @param outPacket Output parameter to store the parsed packet.
      * @return True if a complete packet was successfully retrieved, False if there is insufficient data yet.
      */
-    bool pollPacket(PacketHeader &outHeader, std::vector<char> &outPayload);
+    bool pollPacket(PacketView &outPacket);
 
     /**
      * @brief Serializes and sends a structured packet to the server.
-     * <br> Encapsulates the payload with a standard `PacketHeader` containing the type and size.
-     * <br> Includes a loop to handle partial sends, ensuring the entire buffer is transmitted.
+     * <br> Encapsulates the payload with a standard `PacketHeader` containing the type and size, and queues it for the I/O thread.
      *
      * @tparam T The type of the data structure being sent.
      * @param type The PacketType enum identifier.
@@ -68,11 +126,31 @@ public:
      */
     template<typename T>
     void sendPacket(const PacketType type, const T &data) {
-        if (conPhase != ConnectionPhase::ESTABLISHED) {
-            printf(ANSI_RED "[SockClient] Attempting to send packet before a connection was made \n" ANSI_RESET);
+        if (conPhase == ConnectionPhase::DISCONNECTED) {
+            LOG_ERROR(NETWORK,
+                      ANSI_RED "[SockClient] Attempting to send packet before a connection was made \n" ANSI_RESET);
+            return;
+        }
+
+        if (!outbound.tryPush(encodePacket(type, data))) {
+            LOG_WARN(NETWORK, ANSI_RED "[SockClient] Send queue is full, dropping packet of type %d\n" ANSI_RESET,
+                     static_cast<int>(type));
             return;
         }
+        transport->wakeup();
+    }
 
+    /**
+     * @return The latency the server reported in its last heartbeat, all zero until the first one arrived.
+     */
+    LatencyReport getLatencyReport() const;
+
+private:
+    /**
+     * @brief Encodes a packet (Header + Payload) into a frame ready for the transport.
+     */
+    template<typename T>
+    static std::vector<char> encodePacket(const PacketType type, const T &data) {
         std::vector<char> buffer;
         buffer.reserve(sizeof(PacketHeader) + sizeof(T));
 
@@ -85,23 +163,22 @@ public:
 
         const auto dataPtr = reinterpret_cast<const char *>(&data);
         buffer.insert(buffer.end(), dataPtr, dataPtr + sizeof(T));
+        return buffer;
+    }
 
-        int totalSent = 0;
-        int bytesLeft = static_cast<int>(buffer.size());
-
-        while (totalSent < buffer.size()) {
-            const int sent = send(clientSocket, buffer.data() + totalSent, bytesLeft, 0);
-
-            if (sent == -1) {
-                // Error handling (connection lost?)
-                printf(ANSI_RED "[SockClient] Error sending data!\n" ANSI_RESET);
-                return;
-            }
+    /**
+     * @brief Answers a PING with a PONG straight from the I/O thread, so the round trip doesn't include
+     * the time the packet would wait for the next frame.
+     *
+     * @return True if the frame was a PING, it isn't passed on to the UI thread.
+     */
+    bool answerHeartbeat(const SharedFrame &frame);
 
-            totalSent += sent;
-            bytesLeft -= sent;
-        }
-    }
+    /**
+     * @brief Body of the I/O thread: sends what the UI thread queued, receives everything that arrived
+     * and waits on the transport until the next round.
+     */
+    void runIo();
 };
 
 #endif //TICTACTOEOVERLAN_NETWORKMANAGER_H
@@ -0,0 +1,324 @@
+#include "TcpTransport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "AddressResolver.h"
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+TcpTransport::TcpTransport() {
+    //Held until destruction, `wakeup` may be called before connecting and after closing
+    if (!SocketLayer::startup()) {
+        return;
+    }
+
+    wakeSocket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (wakeSocket == INVALID_SOCKET) {
+        return;
+    }
+
+    // Bound to a free loopback port and connected to itself, so `wakeup` can just send to it
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+
+    if (bind(wakeSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR
+        || getsockname(wakeSocket, reinterpret_cast<sockaddr *>(&address), &addressLength) == SOCKET_ERROR
+        || ::connect(wakeSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR
+        || !SocketLayer::setNonBlocking(wakeSocket)) {
+        SocketLayer::close(wakeSocket);
+        wakeSocket = INVALID_SOCKET;
+    }
+}
+
+TcpTransport::~TcpTransport() {
+    this->close();
+
+    if (wakeSocket != INVALID_SOCKET) {
+        SocketLayer::close(wakeSocket);
+    }
+    SocketLayer::cleanup();
+}
+
+bool TcpTransport::connect(const std::string &address, const std::string &port, const int timeoutMs,
+                           const std::atomic<bool> &keepWaiting) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    //Prepare the socket api
+    if (!SocketLayer::startup()) {
+        LOG_ERROR(NETWORK,
+                  ANSI_RED "[SockClient] Socket startup failed with error: %d\n" ANSI_RESET, SocketLayer::lastError());
+        return false;
+    }
+
+    ResolvedAddress resolved;
+    if (AddressResolver::resolve(address, port, deadline, keepWaiting, resolved) != ResolveStatus::RESOLVED) {
+        SocketLayer::cleanup();
+        return false;
+    }
+
+    //Create the socket
+    socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (socket == INVALID_SOCKET) {
+        LOG_ERROR(NETWORK, "[SockClient] socket failed with error: %d\n", SocketLayer::lastError());
+        SocketLayer::cleanup();
+        return false;
+    }
+
+    //Non-blocking before connecting, so an unreachable address can't hold us past the deadline
+    SocketLayer::setNonBlocking(socket);
+
+    //Moves are tiny and latency bound, don't let Nagle hold them back
+    SocketLayer::setNoDelay(socket);
+
+    //Connect to the server
+    if (::connect(socket, reinterpret_cast<const sockaddr *>(&resolved.address), resolved.length) != 0) {
+        const int error = SocketLayer::lastErrorConnectInProgress() ? this->awaitConnect(deadline, keepWaiting)
+                                                                    : SocketLayer::lastError();
+        if (error != 0) {
+            if (keepWaiting) {
+                LOG_ERROR(NETWORK, ANSI_RED "[SockClient] connect failed with error: %d" ANSI_RESET "\n", error);
+            }
+            // The server may have moved, resolve it again next time
+            AddressResolver::forget(address, port);
+            SocketLayer::close(socket);
+            socket = INVALID_SOCKET;
+            SocketLayer::cleanup();
+            return false;
+        }
+    }
+
+    connected = true;
+    return true;
+}
+
+int TcpTransport::awaitConnect(const std::chrono::steady_clock::time_point deadline,
+                               const std::atomic<bool> &keepWaiting) const {
+    while (true) {
+        if (!keepWaiting) {
+            return CONNECT_CANCELLED;
+        }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            LOG_WARN(NETWORK, ANSI_RED "[SockClient] connect timed out" ANSI_RESET "\n");
+            return CONNECT_TIMED_OUT;
+        }
+
+        // Windows reports a refused connect through the except set instead of the write set
+        fd_set writeSet;
+        fd_set errorSet;
+        FD_ZERO(&writeSet);
+        FD_ZERO(&errorSet);
+        FD_SET(socket, &writeSet);
+        FD_SET(socket, &errorSet);
+
+        const long sliceMs = std::min<long>(remaining, CONNECT_POLL_INTERVAL_MS);
+        timeval timeout{};
+        timeout.tv_usec = sliceMs * 1000;
+
+        const int ready = select(static_cast<int>(socket) + 1, nullptr, &writeSet, &errorSet, &timeout);
+        if (ready < 0) {
+            return SocketLayer::lastError();
+        }
+        if (ready > 0) {
+            return SocketLayer::pendingError(socket);
+        }
+    }
+}
+
+bool TcpTransport::receiveFrame(SharedFrame &outFrame) {
+    // Read until the socket has nothing more or the framer is full
+    while (connected) {
+        size_t writable;
+        char *buffer = receiveBuffer.writableSpan(writable);
+        if (writable == 0) {
+            break;
+        }
+
+        const int bytesReceived = recv(socket, buffer, static_cast<int>(writable), 0);
+
+        if (bytesReceived > 0) {
+            receiveBuffer.commit(bytesReceived);
+            continue;
+        }
+
+        if (bytesReceived == 0 || !SocketLayer::lastErrorWouldBlock()) {
+            connected = false;
+        }
+        break;
+    }
+
+    PacketView packet{};
+    const FrameResult result = receiveBuffer.peek(packet);
+
+    if (result == FrameResult::OVERSIZED) {
+        LOG_WARN(NETWORK,
+                 ANSI_RED "[SockClient] Server sent an oversized packet, dropping the connection\n" ANSI_RESET);
+        connected = false;
+        return false;
+    }
+
+    if (result != FrameResult::READY) {
+        // We don't have the full packet yet, wait for more bytes
+        return false;
+    }
+
+    // Copied out, the packet is handed to another thread and the framer has to move on
+    auto frame = std::make_shared<std::vector<char>>(sizeof(PacketHeader) + packet.header.payloadSize);
+    std::memcpy(frame->data(), &packet.header, sizeof(PacketHeader));
+    std::memcpy(frame->data() + sizeof(PacketHeader), packet.payload, packet.header.payloadSize);
+    receiveBuffer.pop();
+
+    outFrame = std::move(frame);
+    return true;
+}
+
+void TcpTransport::waitForData(const bool watchData) {
+    if (!connected) {
+        return;
+    }
+
+    const bool watchWritable = !sendQueue.empty();
+
+    // Winsock refuses a select without any socket in it
+    if (!watchData && !watchWritable && wakeSocket == INVALID_SOCKET) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(FALLBACK_WAIT_TIMEOUT_MS));
+        return;
+    }
+
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    SOCKET maxSocket = 0;
+    if (watchData) {
+        FD_SET(socket, &readSet);
+        maxSocket = socket;
+    }
+    if (watchWritable) {
+        FD_SET(socket, &writeSet);
+        maxSocket = socket;
+    }
+    if (wakeSocket != INVALID_SOCKET) {
+        FD_SET(wakeSocket, &readSet);
+        maxSocket = std::max(maxSocket, wakeSocket);
+    }
+
+    timeval timeout{};
+    timeout.tv_usec = FALLBACK_WAIT_TIMEOUT_MS * 1000;
+
+    // The first argument is ignored by Winsock, but POSIX needs the highest descriptor + 1
+    const int ready = select(static_cast<int>(maxSocket) + 1, &readSet, watchWritable ? &writeSet : nullptr, nullptr,
+                             wakeSocket != INVALID_SOCKET ? nullptr : &timeout);
+
+    if (ready > 0 && watchWritable && FD_ISSET(socket, &writeSet)) {
+        this->flushSendQueue();
+    }
+
+    if (ready > 0 && wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &readSet)) {
+        // Several wakeups can pile up before we get here, one pass handles all of them
+        char drain[64];
+        while (::recv(wakeSocket, drain, sizeof(drain), 0) > 0) {
+        }
+    }
+}
+
+void TcpTransport::wakeup() {
+    if (wakeSocket == INVALID_SOCKET) {
+        return; //The waits are polled instead
+    }
+
+    constexpr char signal = 1;
+    ::send(wakeSocket, &signal, sizeof(signal), 0);
+}
+
+bool TcpTransport::send(std::vector<char> &&frame) {
+    if (!connected) {
+        return false;
+    }
+
+    // Nothing may overtake the bytes already waiting, the server would read a torn stream
+    size_t sent = 0;
+    if (sendQueue.empty()) {
+        if (!this->sendBytes(frame.data(), frame.size(), sent)) {
+            return false;
+        }
+        if (sent == frame.size()) {
+            return true;
+        }
+    }
+
+    sendQueue.push(std::make_shared<const std::vector<char>>(std::move(frame)), sent);
+    if (sendQueue.size() > SEND_QUEUE_HIGH_WATER_MARK) {
+        LOG_ERROR(NETWORK,
+                  ANSI_RED "[SockClient] Server stopped reading (%zu bytes unsent), dropping the connection\n"
+                  ANSI_RESET, sendQueue.size());
+        connected = false;
+        return false;
+    }
+    return this->flushSendQueue();
+}
+
+bool TcpTransport::sendBytes(const char *data, const size_t length, size_t &outSent) {
+    outSent = 0;
+
+    while (outSent < length) {
+        const int sent = ::send(socket, data + outSent, static_cast<int>(length - outSent), 0);
+
+        if (sent == SOCKET_ERROR) {
+            if (SocketLayer::lastErrorWouldBlock()) {
+                return true;
+            }
+            LOG_ERROR(NETWORK, ANSI_RED "[SockClient] Error sending data: %d\n" ANSI_RESET, SocketLayer::lastError());
+            connected = false;
+            return false;
+        }
+
+        outSent += sent;
+    }
+    return true;
+}
+
+bool TcpTransport::flushSendQueue() {
+    while (!sendQueue.empty()) {
+        IoSlice slice{};
+        sendQueue.gather(&slice, 1);
+
+        size_t sent;
+        const bool ok = this->sendBytes(slice.data, slice.length, sent);
+        sendQueue.consume(sent);
+        if (!ok) {
+            return false;
+        }
+        if (sent < slice.length) {
+            break; //Would block, `waitForData` picks it up once the socket is writable
+        }
+    }
+    return true;
+}
+
+bool TcpTransport::isConnected() const {
+    return connected;
+}
+
+void TcpTransport::close() {
+    if (socket == INVALID_SOCKET) {
+        return;
+    }
+
+    SocketLayer::shutdownSend(socket);
+    SocketLayer::close(socket);
+    socket = INVALID_SOCKET;
+    connected = false;
+    receiveBuffer = PacketFramer();
+    sendQueue = OutboundQueue();
+    SocketLayer::cleanup();
+}
@@ -0,0 +1,103 @@
+#ifndef TICTACTOEOVERLAN_TCPTRANSPORT_H
+#define TICTACTOEOVERLAN_TCPTRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "Transport.h"
+#include "../common/PacketFramer.h"
+#include "../common/SocketLayer.h"
+
+/**
+ * @brief `Transport` over a TCP socket.
+ * <br> Handles the stream fragmentation with a `PacketFramer`, each complete packet is copied out of it
+ * so it can be handed to another thread.
+ * <br> `wakeup` sends a datagram to a UDP socket bound to loopback, which is part of every wait.
+ * <br> Whatever the socket can't take right away waits in `sendQueue`, `waitForData` sends it once it's writable.
+ */
+class TcpTransport final : public Transport {
+    SOCKET socket = INVALID_SOCKET;
+    SOCKET wakeSocket = INVALID_SOCKET; //Connected to itself, `wakeup` makes it readable
+    PacketFramer receiveBuffer;
+    OutboundQueue sendQueue; //Unsent bytes, always ahead of the frames sent after them
+    bool connected = false;
+
+public:
+    TcpTransport();
+
+    ~TcpTransport() override;
+
+    constexpr static int CONNECT_POLL_INTERVAL_MS = 20; //How often a pending connect checks if it got cancelled
+    constexpr static int CONNECT_TIMED_OUT = -1;
+    constexpr static int CONNECT_CANCELLED = -2;
+    constexpr static int FALLBACK_WAIT_TIMEOUT_MS = 1; //Polling interval if the wake socket couldn't be created
+    constexpr static size_t SEND_QUEUE_HIGH_WATER_MARK = 64 * 1024; //Unsent bytes before the server counts as gone
+
+    /**
+     * @brief Resolves the address through the `AddressResolver` and connects to it without blocking past the timeout.
+     * <br> The connect itself is non-blocking, the wait for it is split into short slices so the caller can cancel it.
+     *
+     * @param address The IP address (IPv4) or hostname of the server.
+     * @param port The port number as a string.
+     * @param timeoutMs Time budget for resolving and connecting together.
+     * @param keepWaiting Cleared by the owner to give up on the attempt.
+     * @return True once connected.
+     */
+    bool connect(const std::string &address, const std::string &port, int timeoutMs,
+                 const std::atomic<bool> &keepWaiting);
+
+    /**
+     * @brief Drains the socket into the framer, then copies the next complete packet out of it.
+     */
+    bool receiveFrame(SharedFrame &outFrame) override;
+
+    /**
+     * @brief Waits for the socket or the wake socket to become readable.
+     * <br> While bytes are waiting in `sendQueue` it also waits for the socket to become writable, and sends them.
+     */
+    void waitForData(bool watchData) override;
+
+    /**
+     * @brief Sends a datagram to the wake socket, like `SelectEventLoop::wakeup`.
+     */
+    void wakeup() override;
+
+    /**
+     * @brief Sends as much of the frame as the socket takes, the rest is queued behind the bytes still waiting.
+     * <br> Marks the connection as broken if the socket fails or the server stops reading for too long.
+     */
+    bool send(std::vector<char> &&frame) override;
+
+    bool isConnected() const override;
+
+    void close() override;
+
+private:
+    /**
+     * @brief Waits for the pending non-blocking connect to finish.
+     *
+     * @return 0 once connected, the socket error, `CONNECT_TIMED_OUT` or `CONNECT_CANCELLED`.
+     */
+    int awaitConnect(std::chrono::steady_clock::time_point deadline, const std::atomic<bool> &keepWaiting) const;
+
+    /**
+     * @brief Sends bytes until they're all sent or the socket would block.
+     *
+     * @param data The bytes to send.
+     * @param length Number of bytes.
+     * @param outSent Output parameter for the number of bytes sent.
+     * @return False if the socket failed, the connection is marked as broken then.
+     */
+    bool sendBytes(const char *data, size_t length, size_t &outSent);
+
+    /**
+     * @brief Sends the bytes waiting in `sendQueue` until it's empty or the socket would block.
+     *
+     * @return False if the socket failed.
+     */
+    bool flushSendQueue();
+};
+
+
+#endif //TICTACTOEOVERLAN_TCPTRANSPORT_H
@@ -0,0 +1,54 @@
+#ifndef TICTACTOEOVERLAN_TRANSPORT_H
+#define TICTACTOEOVERLAN_TRANSPORT_H
+
+#include <vector>
+
+#include "../server/OutboundQueue.h"
+
+/**
+ * @brief A connection to a server, as seen by the NetworkManager.
+ * <br> `TcpTransport` talks to remote servers, `LoopbackTransport` to the InternalGameServer hosted by this client.
+ * <br> Only ever used by the NetworkManager's I/O thread once the connection is up, except for `wakeup`.
+ */
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Takes the next complete packet, if one arrived.
+     *
+     * @param outFrame Output parameter for the packet (Header + Payload).
+     * @return True if a complete packet was retrieved.
+     */
+    virtual bool receiveFrame(SharedFrame &outFrame) = 0;
+
+    /**
+     * @brief Blocks until new data may have arrived or `wakeup` was called.
+     *
+     * @param watchData False to only wait for `wakeup`, while nothing received could be handed on anyway.
+     */
+    virtual void waitForData(bool watchData) = 0;
+
+    /**
+     * @brief Interrupts a blocking `waitForData` from another thread, or makes the next one return right away.
+     */
+    virtual void wakeup() = 0;
+
+    /**
+     * @brief Sends one encoded packet (Header + Payload).
+     *
+     * @param frame The encoded packet, the transport may keep it instead of copying.
+     * @return False if the packet couldn't be sent, the connection counts as broken from then on.
+     */
+    virtual bool send(std::vector<char> &&frame) = 0;
+
+    /**
+     * @return False once the server closed the connection or it broke.
+     */
+    virtual bool isConnected() const = 0;
+
+    virtual void close() = 0;
+};
+
+
+#endif //TICTACTOEOVERLAN_TRANSPORT_H
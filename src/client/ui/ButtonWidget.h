@@ -5,6 +5,7 @@
 #include <cmath>
 
 #include "Widget.h"
+#include "../../common/Logger.h"
 #include "../../common/Utils.h"
 #include "SFML/Graphics/Font.hpp"
 #include "SFML/Graphics/RectangleShape.hpp"
@@ -58,7 +59,7 @@ public:
         sharedFont = font;
         prevPosX = 0;
         prevPosY = 0;
-        printf(ANSI_GREEN "[UI] Font and defaults for ButtonBuilder have been loaded!\n" ANSI_RESET);
+        LOG_INFO(UI, ANSI_GREEN "[UI] Font and defaults for ButtonBuilder have been loaded!\n" ANSI_RESET);
     }
 
     /**
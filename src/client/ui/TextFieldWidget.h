@@ -3,6 +3,7 @@
 #include <functional>
 
 #include "Widget.h"
+#include "../../common/Logger.h"
 #include "../../common/Utils.h"
 #include "SFML/Graphics/RectangleShape.hpp"
 #include "SFML/Graphics/Text.hpp"
@@ -55,7 +56,7 @@ public:
     static void initFont(const sf::Font &font) {
         sharedFont = font;
         prevPosX = 0, prevPosY = 0;
-        printf(ANSI_GREEN "[UI] Font and defaults for TextFieldBuilder have been loaded!\n" ANSI_RESET);
+        LOG_INFO(UI, ANSI_GREEN "[UI] Font and defaults for TextFieldBuilder have been loaded!\n" ANSI_RESET);
     }
 
     /**
@@ -0,0 +1,158 @@
+#include "BoardSnapshot.h"
+
+namespace {
+    constexpr uint32_t PIECE_BITS = 3;
+    constexpr uint32_t RUN_GROUP_BITS = 3;
+    constexpr uint32_t RUN_CONTINUE_FLAG = 1 << RUN_GROUP_BITS;
+
+    /**
+     * @brief Appends bit fields to a byte buffer, least significant bit first.
+     */
+    class BitWriter {
+        uint8_t *output;
+        size_t capacity;
+        size_t written = 0;
+        uint32_t pending = 0;
+        uint32_t pendingBits = 0;
+        bool overflowed = false;
+
+    public:
+        BitWriter(uint8_t *output, const size_t capacity) : output(output), capacity(capacity) {
+        }
+
+        void write(const uint32_t value, const uint32_t bits) {
+            pending |= value << pendingBits;
+            pendingBits += bits;
+            while (pendingBits >= 8) {
+                this->emit(static_cast<uint8_t>(pending));
+                pending >>= 8;
+                pendingBits -= 8;
+            }
+        }
+
+        /**
+         * @return Total bytes written, 0 if the buffer overflowed.
+         */
+        size_t finish() {
+            if (pendingBits > 0) {
+                this->emit(static_cast<uint8_t>(pending));
+                pendingBits = 0;
+            }
+            return overflowed ? 0 : written;
+        }
+
+    private:
+        void emit(const uint8_t byte) {
+            if (written == capacity) {
+                overflowed = true;
+                return;
+            }
+            output[written++] = byte;
+        }
+    };
+
+    /**
+     * @brief Reads the bit fields written by `BitWriter`.
+     */
+    class BitReader {
+        const uint8_t *input;
+        size_t length;
+        size_t consumed = 0;
+        uint32_t pending = 0;
+        uint32_t pendingBits = 0;
+
+    public:
+        BitReader(const uint8_t *input, const size_t length) : input(input), length(length) {
+        }
+
+        bool read(const uint32_t bits, uint32_t &outValue) {
+            while (pendingBits < bits) {
+                if (consumed == length) return false;
+                pending |= static_cast<uint32_t>(input[consumed++]) << pendingBits;
+                pendingBits += 8;
+            }
+            outValue = pending & ((1u << bits) - 1);
+            pending >>= bits;
+            pendingBits -= bits;
+            return true;
+        }
+    };
+}
+
+size_t BoardSnapshot::encode(const BoardData &board, uint8_t *output, const size_t capacity) {
+    BitWriter writer(output, capacity);
+    const size_t size = board.boardSize;
+    const size_t totalSquares = size * size;
+
+    size_t index = 0;
+    while (index < totalSquares) {
+        const PieceType piece = board.grid[index / size][index % size].piece;
+        if (piece != PieceType::EMPTY) {
+            writer.write(static_cast<uint32_t>(piece), PIECE_BITS);
+            ++index;
+            continue;
+        }
+
+        size_t runEnd = index + 1;
+        while (runEnd < totalSquares && board.grid[runEnd / size][runEnd % size].piece == PieceType::EMPTY) {
+            ++runEnd;
+        }
+
+        writer.write(static_cast<uint32_t>(PieceType::EMPTY), PIECE_BITS);
+        auto remaining = static_cast<uint32_t>(runEnd - index - 1);
+        do {
+            const uint32_t group = remaining & (RUN_CONTINUE_FLAG - 1);
+            remaining >>= RUN_GROUP_BITS;
+            writer.write(group | (remaining > 0 ? RUN_CONTINUE_FLAG : 0), RUN_GROUP_BITS + 1);
+        } while (remaining > 0);
+
+        index = runEnd;
+    }
+
+    return writer.finish();
+}
+
+bool BoardSnapshot::decode(const uint8_t *input, const size_t length, BoardData &board) {
+    BitReader reader(input, length);
+    const size_t size = board.boardSize;
+    const size_t totalSquares = size * size;
+
+    if (board.grid.size() < size) {
+        return false;
+    }
+
+    size_t index = 0;
+    while (index < totalSquares) {
+        uint32_t pieceValue;
+        if (!reader.read(PIECE_BITS, pieceValue) || pieceValue > static_cast<uint32_t>(PieceType::HEXAGON)) {
+            return false;
+        }
+
+        size_t runLength = 1;
+        if (static_cast<PieceType>(pieceValue) == PieceType::EMPTY) {
+            uint32_t encodedRun = 0;
+            uint32_t shift = 0;
+            uint32_t group;
+            do {
+                if (!reader.read(RUN_GROUP_BITS + 1, group) || shift > 12) return false;
+                encodedRun |= (group & (RUN_CONTINUE_FLAG - 1)) << shift;
+                shift += RUN_GROUP_BITS;
+            } while (group & RUN_CONTINUE_FLAG);
+            runLength = static_cast<size_t>(encodedRun) + 1;
+        }
+
+        if (index + runLength > totalSquares) {
+            return false;
+        }
+
+        BoardSquare square{};
+        square.piece = static_cast<PieceType>(pieceValue);
+        for (const size_t runEnd = index + runLength; index < runEnd; ++index) {
+            auto &row = board.grid[index / size];
+            if (row.size() < size) return false;
+            row[index % size] = square;
+        }
+    }
+
+    return true;
+}
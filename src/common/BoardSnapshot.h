@@ -0,0 +1,41 @@
+#ifndef TICTACTOEOVERLAN_BOARDSNAPSHOT_H
+#define TICTACTOEOVERLAN_BOARDSNAPSHOT_H
+#include <cstddef>
+#include <cstdint>
+
+#include "GameDefinitions.h"
+
+/**
+ * @brief Compact, variable-length encoding of the pieces on a board, used by the snapshot packets.
+ * <br> Only the `boardSize * boardSize` cells in play are encoded, row by row (`index = y * width + x`).
+ * <br> Every cell is a 3-bit piece type. An EMPTY code covers a whole run of empty cells and is followed by
+ * the run length minus one, in 4-bit groups of 3 value bits and a continuation bit.
+ * <br> A full 32x32 board takes 384 bytes, an empty one 3. No board needs more than `MAX_BOARD_SNAPSHOT_SIZE`.
+ * <br> The square's owner and placement turn aren't carried, the owner follows from the piece
+ * and the turn from the move history.
+ */
+class BoardSnapshot {
+public:
+    /**
+     * @brief Encodes the pieces of a board.
+     *
+     * @param board The board to encode, its `grid` must match `boardSize`.
+     * @param output Destination buffer.
+     * @param capacity Size of the destination buffer.
+     * @return Number of bytes written, 0 if the buffer is too small.
+     */
+    static size_t encode(const BoardData &board, uint8_t *output, size_t capacity);
+
+    /**
+     * @brief Decodes a snapshot into a board, replacing every cell in play.
+     *
+     * @param input The encoded snapshot.
+     * @param length Size of the encoded snapshot.
+     * @param board The board to decode into, `boardSize` and `grid` must already match the encoded board.
+     * @return False if the snapshot is malformed, the board may be partially updated in that case.
+     */
+    static bool decode(const uint8_t *input, size_t length, BoardData &board);
+};
+
+
+#endif //TICTACTOEOVERLAN_BOARDSNAPSHOT_H
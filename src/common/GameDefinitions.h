@@ -5,6 +5,8 @@
 
 constexpr static uint8_t MAX_BOARD_SIZE = 32;
 constexpr static uint16_t TOTAL_BOARD_AREA = MAX_BOARD_SIZE * MAX_BOARD_SIZE;
+//Worst case of the `BoardSnapshot` encoding, single empty cells between pieces average 5 bits per cell
+constexpr static uint16_t MAX_BOARD_SNAPSHOT_SIZE = (TOTAL_BOARD_AREA * 5 + 7) / 8;
 constexpr static uint8_t MAX_WIN_CONDITION_LENGTH = 32;
 
 /**
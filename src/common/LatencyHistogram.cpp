@@ -0,0 +1,70 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+void LatencyHistogram::record(const uint32_t latencyUs) {
+    size_t bucket = 0;
+    while (bucket + 1 < BUCKET_COUNT && latencyUs >= bucketLimitUs(bucket)) {
+        ++bucket;
+    }
+
+    ++buckets[bucket];
+    ++sampleCount;
+    lastUs = latencyUs;
+    maxUs = std::max(maxUs, latencyUs);
+    totalUs += latencyUs;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        buckets[bucket] += other.buckets[bucket];
+    }
+    sampleCount += other.sampleCount;
+    lastUs = other.sampleCount > 0 ? other.lastUs : lastUs;
+    maxUs = std::max(maxUs, other.maxUs);
+    totalUs += other.totalUs;
+}
+
+uint32_t LatencyHistogram::percentileUs(const double percentile) const {
+    if (sampleCount == 0) {
+        return 0;
+    }
+
+    // The rank of the sample the percentile points at, counted from 1
+    const auto rank = static_cast<uint32_t>(std::max(1.0, std::ceil(percentile / 100.0 * sampleCount)));
+
+    uint32_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            // The max is a tighter limit than the bucket's, and the only one for the last bucket
+            return std::min(bucketLimitUs(bucket), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+uint32_t LatencyHistogram::count() const {
+    return sampleCount;
+}
+
+uint32_t LatencyHistogram::lastSampleUs() const {
+    return lastUs;
+}
+
+uint32_t LatencyHistogram::maxSampleUs() const {
+    return maxUs;
+}
+
+uint32_t LatencyHistogram::meanUs() const {
+    return sampleCount > 0 ? static_cast<uint32_t>(totalUs / sampleCount) : 0;
+}
+
+uint32_t LatencyHistogram::bucketLimitUs(const size_t bucket) {
+    if (bucket + 1 >= BUCKET_COUNT) {
+        return UINT32_MAX;
+    }
+    return FIRST_BUCKET_LIMIT_US << bucket;
+}
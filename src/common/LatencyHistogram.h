@@ -0,0 +1,57 @@
+#ifndef TICTACTOEOVERLAN_LATENCYHISTOGRAM_H
+#define TICTACTOEOVERLAN_LATENCYHISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Fixed-bucket histogram of latencies in microseconds, e.g. heartbeat round trip times.
+ * <br> Bucket `i` counts the samples below `FIRST_BUCKET_LIMIT_US << i`, the last bucket everything above.
+ * Recording is O(1) and the memory never grows, so every client can keep its own.
+ * <br> Not thread-safe, the owner copies it out under its own lock if another thread wants to read it.
+ */
+class LatencyHistogram {
+public:
+    constexpr static size_t BUCKET_COUNT = 16;
+    constexpr static uint32_t FIRST_BUCKET_LIMIT_US = 250; //Bucket limits double from 0.25ms up to ~4s
+
+private:
+    std::array<uint32_t, BUCKET_COUNT> buckets{};
+    uint32_t sampleCount = 0;
+    uint32_t lastUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+
+public:
+    void record(uint32_t latencyUs);
+
+    /**
+     * @brief Adds another histogram's samples to this one, e.g. to sum up all clients of a server.
+     */
+    void merge(const LatencyHistogram &other);
+
+    /**
+     * @brief Estimates a percentile from the buckets.
+     *
+     * @param percentile Between 0 and 100.
+     * @return The upper limit of the bucket the percentile falls into (the max for the last bucket), 0 without samples.
+     */
+    uint32_t percentileUs(double percentile) const;
+
+    uint32_t count() const;
+
+    uint32_t lastSampleUs() const;
+
+    uint32_t maxSampleUs() const;
+
+    uint32_t meanUs() const;
+
+    /**
+     * @return The exclusive upper limit of a bucket, UINT32_MAX for the last one.
+     */
+    static uint32_t bucketLimitUs(size_t bucket);
+};
+
+
+#endif //TICTACTOEOVERLAN_LATENCYHISTOGRAM_H
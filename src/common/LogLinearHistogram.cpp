@@ -0,0 +1,158 @@
+#include "LogLinearHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+LogLinearHistogram::LogLinearHistogram(const int sampleSize)
+    : windowSampleSize(std::max<uint32_t>(1, static_cast<uint32_t>(std::max(sampleSize, 1)) / WINDOW_COUNT)) {
+}
+
+void LogLinearHistogram::add(long long value) {
+    value = std::max(value, 0LL);
+
+    Window &window = windows[currentWindow.load(std::memory_order_relaxed)];
+    window.buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    window.total.fetch_add(value, std::memory_order_relaxed);
+    // Only one thread records, so a plain compare is enough
+    if (value < window.min.load(std::memory_order_relaxed)) window.min.store(value, std::memory_order_relaxed);
+    if (value > window.max.load(std::memory_order_relaxed)) window.max.store(value, std::memory_order_relaxed);
+
+    if (window.count.fetch_add(1, std::memory_order_release) + 1 >= windowSampleSize) {
+        this->rotate();
+    }
+}
+
+void LogLinearHistogram::rotate() {
+    const size_t next = (currentWindow.load(std::memory_order_relaxed) + 1) % WINDOW_COUNT;
+
+    Window &window = windows[next];
+    window.count.store(0, std::memory_order_relaxed);
+    for (auto &bucket: window.buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    window.total.store(0, std::memory_order_relaxed);
+    window.min.store(LLONG_MAX, std::memory_order_relaxed);
+    window.max.store(0, std::memory_order_relaxed);
+
+    currentWindow.store(next, std::memory_order_release);
+}
+
+double LogLinearHistogram::average() {
+    uint64_t sampleCount;
+    return this->summarize(sampleCount).average;
+}
+
+double LogLinearHistogram::min() {
+    uint64_t sampleCount;
+    return this->summarize(sampleCount).min;
+}
+
+double LogLinearHistogram::max() {
+    uint64_t sampleCount;
+    return this->summarize(sampleCount).max;
+}
+
+double LogLinearHistogram::percentile(const double percentile) {
+    uint64_t sampleCount;
+    const PackagedValues summary = this->summarize(sampleCount);
+
+    double value = 0.0;
+    this->resolvePercentiles(&percentile, &value, 1, sampleCount, summary.min, summary.max);
+    return value;
+}
+
+PackagedValues LogLinearHistogram::getPackagedValues() {
+    uint64_t sampleCount;
+    PackagedValues values = this->summarize(sampleCount);
+
+    constexpr double percentiles[] = {50.0, 99.0, 99.9};
+    double resolved[3] = {};
+    this->resolvePercentiles(percentiles, resolved, 3, sampleCount, values.min, values.max);
+    values.p50 = resolved[0];
+    values.p99 = resolved[1];
+    values.p999 = resolved[2];
+    return values;
+}
+
+uint32_t LogLinearHistogram::count() const {
+    uint32_t sampleCount = 0;
+    for (const auto &window: windows) {
+        sampleCount += window.count.load(std::memory_order_acquire);
+    }
+    return sampleCount;
+}
+
+size_t LogLinearHistogram::bucketIndex(const long long value) {
+    const auto unsignedValue = static_cast<uint64_t>(value);
+    if (unsignedValue < SUB_BUCKET_COUNT) {
+        return unsignedValue;
+    }
+
+    // The highest set bit picks the power of two, the next `SUB_BUCKET_BITS` bits the bucket within it
+    const size_t magnitude = std::bit_width(unsignedValue) - 1;
+    const size_t shift = magnitude - SUB_BUCKET_BITS;
+    const size_t subBucket = (unsignedValue >> shift) - SUB_BUCKET_COUNT;
+    return SUB_BUCKET_COUNT + shift * SUB_BUCKET_COUNT + subBucket;
+}
+
+long long LogLinearHistogram::bucketHighestValue(const size_t bucket) {
+    if (bucket < SUB_BUCKET_COUNT) {
+        return static_cast<long long>(bucket);
+    }
+
+    const size_t shift = (bucket - SUB_BUCKET_COUNT) / SUB_BUCKET_COUNT;
+    const uint64_t subBucket = SUB_BUCKET_COUNT + (bucket - SUB_BUCKET_COUNT) % SUB_BUCKET_COUNT;
+    const uint64_t highest = ((subBucket + 1) << shift) - 1;
+    return static_cast<long long>(std::min<uint64_t>(highest, LLONG_MAX));
+}
+
+PackagedValues LogLinearHistogram::summarize(uint64_t &outCount) const {
+    outCount = 0;
+    long long total = 0;
+    long long minValue = LLONG_MAX;
+    long long maxValue = 0;
+
+    for (const auto &window: windows) {
+        const uint32_t windowCount = window.count.load(std::memory_order_acquire);
+        if (windowCount == 0) continue;
+
+        outCount += windowCount;
+        total += window.total.load(std::memory_order_relaxed);
+        minValue = std::min(minValue, window.min.load(std::memory_order_relaxed));
+        maxValue = std::max(maxValue, window.max.load(std::memory_order_relaxed));
+    }
+
+    if (outCount == 0) {
+        return {};
+    }
+    return {static_cast<double>(total) / static_cast<double>(outCount), static_cast<double>(minValue),
+            static_cast<double>(maxValue)};
+}
+
+void LogLinearHistogram::resolvePercentiles(const double *percentiles, double *outValues, const size_t count,
+                                            const uint64_t sampleCount, const double minValue,
+                                            const double maxValue) const {
+    if (sampleCount == 0) {
+        std::fill_n(outValues, count, 0.0);
+        return;
+    }
+
+    size_t resolved = 0;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < BUCKET_COUNT && resolved < count; ++bucket) {
+        for (const auto &window: windows) {
+            seen += window.buckets[bucket].load(std::memory_order_relaxed);
+        }
+
+        // The rank of the sample the percentile points at, counted from 1
+        while (resolved < count && seen >= static_cast<uint64_t>(
+                   std::max(1.0, std::ceil(percentiles[resolved] / 100.0 * static_cast<double>(sampleCount))))) {
+            const auto highest = static_cast<double>(bucketHighestValue(bucket));
+            outValues[resolved++] = std::clamp(highest, minValue, maxValue);
+        }
+    }
+
+    // A sample recorded while we walked can leave the buckets a bit short of the count
+    std::fill(outValues + resolved, outValues + count, maxValue);
+}
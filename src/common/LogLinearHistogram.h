@@ -0,0 +1,129 @@
+#ifndef TICTACTOEOVERLAN_LOGLINEARHISTOGRAM_H
+#define TICTACTOEOVERLAN_LOGLINEARHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "RollingAverage.h"
+
+/**
+ * @brief Lock-free, fixed-memory implementation of RollingAverage, in the style of an HDR histogram.
+ * <br> Values are counted in log-linear buckets: every power of two is split into `SUB_BUCKET_COUNT` equal buckets,
+ * so a reported percentile is within 1/16 (6.25%) of the real sample, from nanoseconds up to the whole `long long` range.
+ * <br> The window is split into `WINDOW_COUNT` slices. Once the newest slice holds its share of `sampleSize` samples,
+ * the oldest one gets cleared and takes over, so queries cover roughly the last `sampleSize` samples.
+ * <br> Recording is a handful of relaxed atomic operations and never allocates. One thread records at a time,
+ * any number of threads may query concurrently. A query racing a rotation may miss the samples of the cleared slice.
+ */
+class LogLinearHistogram final : public RollingAverage {
+public:
+    constexpr static size_t SUB_BUCKET_BITS = 4;
+    constexpr static size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    // Values below `SUB_BUCKET_COUNT` are exact, then `SUB_BUCKET_COUNT` buckets per power of two up to LLONG_MAX
+    constexpr static size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (62 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+    constexpr static size_t WINDOW_COUNT = 4;
+
+private:
+    struct Window {
+        std::array<std::atomic<uint32_t>, BUCKET_COUNT> buckets{};
+        std::atomic<uint32_t> count = 0;
+        std::atomic<long long> total = 0;
+        std::atomic<long long> min = LLONG_MAX;
+        std::atomic<long long> max = 0;
+    };
+
+    std::array<Window, WINDOW_COUNT> windows;
+    std::atomic<size_t> currentWindow = 0;
+    uint32_t windowSampleSize;
+
+public:
+    /**
+     * @brief Constructs an empty histogram.
+     *
+     * @param sampleSize Roughly how many of the latest samples the queries cover.
+     * Tail percentiles need enough samples to mean anything, the p99.9 at least a thousand.
+     */
+    explicit LogLinearHistogram(int sampleSize);
+
+    /**
+     * @brief Records a sample, negative values count as 0.
+     * <br> Rotates to the next slice of the window if the current one is full.
+     *
+     * @param value The new data point, e.g. a duration in nanoseconds.
+     */
+    void add(long long value);
+
+    /**
+     * @return The mean of the samples in the window, 0 if there are none.
+     */
+    double average() override;
+
+    /**
+     * @return The smallest sample in the window, 0 if there are none.
+     */
+    double min() override;
+
+    /**
+     * @return The largest sample in the window, 0 if there are none.
+     */
+    double max() override;
+
+    /**
+     * @brief Estimates a percentile of the samples in the window.
+     *
+     * @param percentile Between 0 and 100.
+     * @return The highest value of the bucket the percentile falls into, clamped to the window's min and max.
+     * 0 if there are no samples.
+     */
+    double percentile(double percentile) override;
+
+    /**
+     * @brief Computes every statistic in one walk over the buckets.
+     */
+    PackagedValues getPackagedValues() override;
+
+    /**
+     * @return How many samples the window currently covers.
+     */
+    uint32_t count() const;
+
+    /**
+     * @return The bucket a value is counted in.
+     */
+    static size_t bucketIndex(long long value);
+
+    /**
+     * @return The highest value that is counted in the bucket.
+     */
+    static long long bucketHighestValue(size_t bucket);
+
+private:
+    /**
+     * @brief Clears the oldest slice and makes it the one samples are recorded into.
+     */
+    void rotate();
+
+    /**
+     * @brief Sums up the slices' counters, without the buckets.
+     */
+    PackagedValues summarize(uint64_t &outCount) const;
+
+    /**
+     * @brief Walks the buckets of all slices once, resolving several percentiles at the same time.
+     *
+     * @param percentiles Ascending, between 0 and 100.
+     * @param outValues Receives the values, in the same order.
+     * @param count The number of `percentiles`.
+     * @param sampleCount The samples in the window, from `summarize`.
+     * @param minValue The window's min, from `summarize`.
+     * @param maxValue The window's max, from `summarize`.
+     */
+    void resolvePercentiles(const double *percentiles, double *outValues, size_t count, uint64_t sampleCount,
+                            double minValue, double maxValue) const;
+};
+
+
+#endif //TICTACTOEOVERLAN_LOGLINEARHISTOGRAM_H
@@ -0,0 +1,63 @@
+#include "Logger.h"
+
+#include <chrono>
+
+#include "Utils.h"
+
+Logger::Logger() : queue(std::make_unique<MpscQueue<LogRecord, QUEUE_CAPACITY>>()) {
+    writer = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    keepRunning = false;
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+void Logger::flush() {
+    const uint64_t target = queuedRecords.load(std::memory_order_acquire);
+    while (writtenRecords.load(std::memory_order_acquire) < target && writer.joinable()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_POLL_INTERVAL_MS));
+    }
+}
+
+void Logger::run() {
+    while (keepRunning) {
+        if (!this->drain()) {
+            // Polling keeps the producers free of syscalls, nobody has to wake us up
+            std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_POLL_INTERVAL_MS));
+        }
+    }
+
+    // Whatever was logged until the very end
+    this->drain();
+}
+
+bool Logger::drain() {
+    LogRecord record;
+    uint64_t written = 0;
+    while (queue->tryPop(record)) {
+        record.write(record, stdout);
+        ++written;
+    }
+
+    if (const uint64_t dropped = droppedRecords.exchange(0, std::memory_order_relaxed); dropped > 0) {
+        std::fprintf(stdout, ANSI_YELLOW "[Logger] The log queue was full, dropped %llu record(s).\n" ANSI_RESET,
+                     static_cast<unsigned long long>(dropped));
+    }
+
+    if (written == 0) {
+        return false;
+    }
+
+    // One flush per batch instead of one per line
+    std::fflush(stdout);
+    writtenRecords.fetch_add(written, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,236 @@
+#ifndef TICTACTOEOVERLAN_LOGGER_H
+#define TICTACTOEOVERLAN_LOGGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+
+#include "MpscQueue.h"
+
+/**
+ * @brief Severity of a log record, records below their subsystem's threshold are compiled out.
+ */
+enum class LogLevel : uint8_t {
+    TRACE,
+    DEBUG, // Per packet chatter
+    INFO, // Lifecycle: connections, games, server start and stop
+    WARN, // A peer misbehaved or something was dropped, we carry on
+    ERR, // Something of ours failed. Not ERROR, windows.h defines that as a macro
+    OFF
+};
+
+/**
+ * @brief The part of the program a log record comes from, each one has its own compile-time threshold.
+ */
+enum class LogSubsystem : uint8_t {
+    SERVER, // InternalGameServer, its shards and event loops
+    NETWORK, // The client's connection to the server
+    CLIENT, // GameClient
+    UI // Widgets
+};
+
+// Compile-time thresholds as `LogLevel` values, e.g. -DTICTACTOE_LOG_LEVEL=3 keeps warnings and errors only.
+// Every subsystem defaults to TICTACTOE_LOG_LEVEL, which defaults to DEBUG in debug builds and INFO otherwise.
+#ifndef TICTACTOE_LOG_LEVEL
+#ifdef NDEBUG
+#define TICTACTOE_LOG_LEVEL 2
+#else
+#define TICTACTOE_LOG_LEVEL 1
+#endif
+#endif
+#ifndef TICTACTOE_LOG_LEVEL_SERVER
+#define TICTACTOE_LOG_LEVEL_SERVER TICTACTOE_LOG_LEVEL
+#endif
+#ifndef TICTACTOE_LOG_LEVEL_NETWORK
+#define TICTACTOE_LOG_LEVEL_NETWORK TICTACTOE_LOG_LEVEL
+#endif
+#ifndef TICTACTOE_LOG_LEVEL_CLIENT
+#define TICTACTOE_LOG_LEVEL_CLIENT TICTACTOE_LOG_LEVEL
+#endif
+#ifndef TICTACTOE_LOG_LEVEL_UI
+#define TICTACTOE_LOG_LEVEL_UI TICTACTOE_LOG_LEVEL
+#endif
+
+/**
+ * @return True if records of this level and subsystem are compiled in.
+ */
+constexpr bool isLogEnabled(const LogLevel level, const LogSubsystem subsystem) {
+    constexpr int thresholds[] = {
+        TICTACTOE_LOG_LEVEL_SERVER,
+        TICTACTOE_LOG_LEVEL_NETWORK,
+        TICTACTOE_LOG_LEVEL_CLIENT,
+        TICTACTOE_LOG_LEVEL_UI
+    };
+    return static_cast<int>(level) >= thresholds[static_cast<size_t>(subsystem)];
+}
+
+// printf-style logging, e.g. LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] Room %u is full\n" ANSI_RESET, roomId).
+// The format has to be a string literal, it's only formatted later on the writer thread.
+// A disabled record compiles to nothing, its arguments aren't even evaluated.
+// The dead printf call is only there so the compiler still checks the format against the arguments.
+#define TICTACTOE_LOG(level, subsystem, ...) \
+    do { \
+        if constexpr (isLogEnabled(LogLevel::level, LogSubsystem::subsystem)) { \
+            if (false) std::printf(__VA_ARGS__); \
+            Logger::instance().log(__VA_ARGS__); \
+        } \
+    } while (false)
+
+#define LOG_TRACE(subsystem, ...) TICTACTOE_LOG(TRACE, subsystem, __VA_ARGS__)
+#define LOG_DEBUG(subsystem, ...) TICTACTOE_LOG(DEBUG, subsystem, __VA_ARGS__)
+#define LOG_INFO(subsystem, ...) TICTACTOE_LOG(INFO, subsystem, __VA_ARGS__)
+#define LOG_WARN(subsystem, ...) TICTACTOE_LOG(WARN, subsystem, __VA_ARGS__)
+#define LOG_ERROR(subsystem, ...) TICTACTOE_LOG(ERR, subsystem, __VA_ARGS__)
+
+/**
+ * @brief A string argument copied into a log record, the original may be gone by the time it's formatted.
+ */
+struct LogText {
+    constexpr static size_t CAPACITY = 64; //Longer strings get cut off
+
+    char text[CAPACITY];
+
+    explicit LogText(const char *source) {
+        if (source == nullptr) source = "(null)";
+        const size_t length = std::min(std::strlen(source), CAPACITY - 1);
+        std::memcpy(text, source, length);
+        text[length] = '\0';
+    }
+};
+
+/**
+ * @brief One queued log line: its format, its captured arguments and how to format them.
+ */
+struct LogRecord {
+    constexpr static size_t ARGUMENT_CAPACITY = 240;
+
+    void (*write)(const LogRecord &record, std::FILE *out) = nullptr;
+    const char *format = nullptr;
+    alignas(8) unsigned char arguments[ARGUMENT_CAPACITY];
+};
+
+/**
+ * @brief Asynchronous logger, the threads that log never touch the console.
+ * <br> A record keeps the format string and a copy of the arguments, and goes through a lock-free `MpscQueue`
+ * to a background writer thread which formats and prints it. Logging costs a copy of the arguments and a
+ * compare-and-swap, no formatting and no I/O.
+ * <br> If the writer falls behind and the queue fills up, records are dropped and counted instead of blocking.
+ * <br> Everything queued is written before the process exits normally.
+ */
+class Logger {
+public:
+    constexpr static size_t QUEUE_CAPACITY = 4096;
+    constexpr static int IDLE_POLL_INTERVAL_MS = 2; // How long the writer sleeps once the queue is empty
+
+private:
+    std::unique_ptr<MpscQueue<LogRecord, QUEUE_CAPACITY>> queue;
+    std::atomic<bool> keepRunning = true;
+    std::atomic<uint64_t> droppedRecords = 0;
+    std::atomic<uint64_t> queuedRecords = 0; //Counts pushes and writes, so `flush` knows when it's caught up
+    std::atomic<uint64_t> writtenRecords = 0;
+    std::thread writer;
+
+    Logger();
+
+public:
+    ~Logger();
+
+    Logger(const Logger &) = delete;
+
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * @return The process-wide logger, its writer thread starts with the first record.
+     */
+    static Logger &instance();
+
+    /**
+     * @brief Queues a record, use the LOG_* macros instead so disabled levels compile out.
+     *
+     * @param format printf-style format, has to outlive the process (a string literal).
+     * @param args Numbers, enums, pointers or C strings. Strings are copied, up to `LogText::CAPACITY` characters.
+     * Taken by value, packet fields are often packed and can't be bound to a reference.
+     */
+    template<typename... Args>
+    void log(const char *format, const Args... args) {
+        using Captured = std::tuple<decltype(capture(args))...>;
+        static_assert(sizeof(Captured) <= LogRecord::ARGUMENT_CAPACITY, "Too many arguments for one log record");
+        // Records are copied around as raw bytes, so everything captured has to survive that
+        static_assert((std::is_trivially_copyable_v<decltype(capture(args))> && ...) &&
+                      std::is_trivially_destructible_v<Captured>, "Log arguments have to be trivially copyable");
+
+        LogRecord record;
+        record.write = &writeRecord<Captured>;
+        record.format = format;
+        ::new(static_cast<void *>(record.arguments)) Captured(capture(args)...);
+
+        if (!queue->tryPush(std::move(record))) {
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        queuedRecords.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Blocks until every record queued before the call has been written.
+     */
+    void flush();
+
+private:
+    /**
+     * @brief The writer thread: prints records until the logger is destroyed, then drains the queue.
+     */
+    void run();
+
+    /**
+     * @brief Prints everything currently queued.
+     *
+     * @return True if there was anything.
+     */
+    bool drain();
+
+    template<typename T>
+    static auto capture(const T value) {
+        using Value = std::remove_cv_t<T>;
+        if constexpr (std::is_same_v<Value, char *> || std::is_same_v<Value, const char *>) {
+            return LogText(value);
+        } else if constexpr (std::is_enum_v<Value>) {
+            return static_cast<std::underlying_type_t<Value>>(value);
+        } else {
+            static_assert(std::is_arithmetic_v<Value> || std::is_pointer_v<Value>, "Unsupported log argument");
+            return static_cast<Value>(value);
+        }
+    }
+
+    template<typename T>
+    static auto release(const T &value) {
+        if constexpr (std::is_same_v<T, LogText>) {
+            return value.text;
+        } else {
+            return value;
+        }
+    }
+
+    template<typename Captured>
+    static void writeRecord(const LogRecord &record, std::FILE *out) {
+        if constexpr (std::tuple_size_v<Captured> == 0) {
+            std::fputs(record.format, out);
+        } else {
+            const auto &arguments = *std::launder(reinterpret_cast<const Captured *>(record.arguments));
+            std::apply([&](const auto &... values) {
+                std::fprintf(out, record.format, release(values)...);
+            }, arguments);
+        }
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_LOGGER_H
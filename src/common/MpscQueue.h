@@ -0,0 +1,92 @@
+#ifndef TICTACTOEOVERLAN_MPSCQUEUE_H
+#define TICTACTOEOVERLAN_MPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free queue for any number of producer threads and exactly one consumer thread.
+ * <br> Every slot carries a sequence number telling whose turn it is, producers claim slots by advancing
+ * `tail` with a compare-and-swap. Nobody ever blocks, a producer that finds the queue full just gives up.
+ *
+ * @tparam T The element type, moved in and out.
+ * @tparam Capacity Number of slots, a power of two.
+ */
+template<typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+    constexpr static size_t MASK = Capacity - 1;
+
+    struct Slot {
+        // Equals the position a producer may fill the slot at, that position + 1 once it's ready to be popped
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Slot, Capacity> slots;
+    alignas(64) std::atomic<size_t> tail = 0; //Next position to push, claimed by the producers
+    alignas(64) size_t head = 0; //Next position to pop, only touched by the consumer
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Appends an element, from any thread.
+     *
+     * @param value The element, left untouched if the queue is full.
+     * @return False if the queue is full.
+     */
+    bool tryPush(T &&value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[position & MASK];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const auto distance = static_cast<std::ptrdiff_t>(sequence - position);
+
+            if (distance == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (distance < 0) {
+                // The consumer hasn't freed this slot yet, a whole lap behind
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->value = std::move(value);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, consumer side only.
+     * <br> Elements are popped in the order their producers claimed a slot. A producer that claimed a slot
+     * but hasn't filled it yet holds back the ones behind it for that long.
+     *
+     * @param outValue Receives the element.
+     * @return False if the queue is empty.
+     */
+    bool tryPop(T &outValue) {
+        Slot &slot = slots[head & MASK];
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+
+        outValue = std::move(slot.value);
+        slot.sequence.store(head + Capacity, std::memory_order_release);
+        ++head;
+        return true;
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_MPSCQUEUE_H
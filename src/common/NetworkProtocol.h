@@ -1,12 +1,16 @@
 #ifndef TICTACTOEOVERLAN_NETWORKPROTOCOL_H
 #define TICTACTOEOVERLAN_NETWORKPROTOCOL_H
+#include <cstddef>
 #include <cstdint>
-#include <winsock2.h>
 
-#include "../common/GameDefinitions.h"
+#include "GameDefinitions.h"
+#include "SocketLayer.h"
 
+#ifdef _WIN32
 //The websocket version to use, windows requires it to be specified before creating sockets
 constexpr static WORD REQ_SOCK_VERSION = MAKEWORD(2, 2);
+#endif
+constexpr static int DEFAULT_SERVER_PORT = 27015;
 constexpr static int DEFAULT_BUFFER_LEN = 4096;
 constexpr static int MAX_PLAYER_NAME_LENGTH = 32;
 constexpr static int MAX_PLAYERS = 6;
@@ -28,7 +32,11 @@ enum class PacketType : uint8_t {
   MOVE_REQ,
   BOARD_STATE_UPDATE,
   BACK_TO_GAME_ROOM,
-  GAME_END
+  GAME_END,
+  MOVE_APPLIED,
+  PING,
+  PONG,
+  RESYNC_REQ
 };
 
 // This is so the compiler doesn't mess with the padding in the network logic
@@ -63,11 +71,13 @@ struct SetupReqPacket {
   int32_t initialToken; //A client generated token, for later validating moves;
   char playerName[MAX_PLAYER_NAME_LENGTH];
   bool isHost;
+  uint32_t roomId; //The room to join, created on the server if it doesn't exist yet
 };
 
 /**
  * @brief Login acknowledgement.
  * <br> Contains the "Snapshot" of the current lobby state so the new client catches up.
+ * <br> `playerId` is the final, room scoped ID and replaces the one from SERVER_HELLO.
  */
 struct SetupAckPacket {
   int32_t generatedAuthToken;
@@ -129,7 +139,6 @@ struct GameStartRequestPacket {
  * @brief Signal to switch UI to the Board view and initialize grid.
  */
 struct GameStartPacket {
-  BoardSquare grid[TOTAL_BOARD_AREA];
   uint8_t requestedByPlayerId;
   uint8_t finalBoardSize;
   uint8_t finalWinConditionLength;
@@ -137,15 +146,17 @@ struct GameStartPacket {
   uint8_t turn;
   uint8_t startingPlayerId;
   uint8_t playerCount;
+  uint16_t snapshotSize;
+  uint8_t snapshot[MAX_BOARD_SNAPSHOT_SIZE]; //`BoardSnapshot` encoded grid, only `snapshotSize` bytes are sent
 };
 
 /**
- * @brief Event-based full state synchronization.
+ * @brief Event-based full state synchronization (keyframe).
  * <br> Sent by the server to ensure all clients have the exact same board data.
- * <br> Sent typically after a valid move is processed.
+ * <br> Sent in place of a MOVE_APPLIED every few moves, and to a single client that fell out of sync.
  */
 struct BoardStateUpdatePacket {
-  BoardSquare grid[TOTAL_BOARD_AREA];
+  uint32_t sequence; //The move sequence number this snapshot is at
   uint8_t boardSize;
   uint8_t winConditionLength;
   uint16_t round;
@@ -154,6 +165,20 @@ struct BoardStateUpdatePacket {
   Move lastMove;
   uint8_t playerCount;
   Player players[MAX_PLAYERS];
+  uint16_t snapshotSize;
+  uint8_t snapshot[MAX_BOARD_SNAPSHOT_SIZE]; //`BoardSnapshot` encoded grid, only `snapshotSize` bytes are sent
+};
+
+/**
+ * @brief A single validated move (delta), applied by the clients to their local board.
+ * <br> Sent after every move that doesn't get a full BOARD_STATE_UPDATE.
+ */
+struct MoveAppliedPacket {
+  uint32_t sequence; //Counts the moves since GAME_START, a gap means the client is out of sync
+  Move move;
+  uint16_t round;
+  uint16_t turn;
+  uint8_t actingPlayerId;
 };
 
 /**
@@ -182,7 +207,113 @@ struct GameEndPacket {
   Player player;
 };
 
+/**
+ * @brief Heartbeat, sent by the server to every client every few seconds.
+ * <br> The client answers with a PONG right away, a client that stops answering gets dropped.
+ * <br> Also carries the round trip times the server measured for this client, so the client can show them.
+ */
+struct PingPacket {
+  uint32_t sequence;
+  uint64_t sentAtUs; //Server's monotonic clock, only meaningful to the server
+  uint32_t lastRttUs; //0 until the first PONG came back
+  uint32_t medianRttUs;
+  uint32_t p99RttUs;
+};
+
+/**
+ * @brief Answer to a PING, echoes its `sequence` and `sentAtUs`.
+ */
+struct PongPacket {
+  uint32_t sequence;
+  uint64_t sentAtUs;
+};
+
+/**
+ * @brief Request for a keyframe, sent by a client that noticed a gap in the MOVE_APPLIED sequence.
+ * <br> The server answers with a BOARD_STATE_UPDATE to this client only.
+ */
+struct ResyncRequestPacket {
+  uint8_t playerId;
+  uint32_t sequence; //The last sequence the client applied
+};
+
 // Restore default compiler structure packing.
 #pragma pack(pop)
 
+/**
+ * @brief The number of payload bytes a snapshot packet actually needs on the wire.
+ * <br> Snapshot packets end with a variable-length `snapshot`, the unused rest of the array isn't sent.
+ *
+ * @param packet A packet with a trailing `snapshotSize` and `snapshot`.
+ * @return The payload size to send.
+ */
+template<typename T>
+constexpr uint32_t snapshotPayloadSize(const T &packet) {
+  return static_cast<uint32_t>(offsetof(T, snapshot) + packet.snapshotSize);
+}
+
+/**
+ * @brief Checks that a received snapshot packet is as long as the snapshot it announces.
+ *
+ * @param packet The received packet.
+ * @param payloadSize The payload size from the packet header.
+ * @return True if the whole snapshot was received.
+ */
+template<typename T>
+bool isSnapshotPayloadComplete(const T &packet, const uint32_t payloadSize) {
+  return payloadSize >= offsetof(T, snapshot)
+         && packet.snapshotSize <= MAX_BOARD_SNAPSHOT_SIZE
+         && snapshotPayloadSize(packet) <= payloadSize;
+}
+
+/**
+ * @brief Size rule of a payload that is always sent whole.
+ */
+template<typename T>
+struct FixedPayload {
+  using Payload = T;
+
+  static bool hasValidSize(const char *, const uint32_t payloadSize) {
+    return payloadSize == sizeof(T);
+  }
+};
+
+/**
+ * @brief Size rule of a snapshot payload, only as long as the snapshot it announces.
+ */
+template<typename T>
+struct SnapshotPayload {
+  using Payload = T;
+
+  static bool hasValidSize(const char *payload, const uint32_t payloadSize) {
+    return payloadSize <= sizeof(T)
+           && isSnapshotPayloadComplete(*reinterpret_cast<const T *>(payload), payloadSize);
+  }
+};
+
+/**
+ * @brief Maps every `PacketType` to its payload struct and the size rule its payload has to pass.
+ * <br> A new packet type needs one line here, `PacketDispatcher` rejects types without one at compile time.
+ */
+template<PacketType Type>
+struct PacketSpec;
+
+template<> struct PacketSpec<PacketType::SERVER_HELLO> : FixedPayload<ServerHelloPacket> {};
+template<> struct PacketSpec<PacketType::SETUP_REQ> : FixedPayload<SetupReqPacket> {};
+template<> struct PacketSpec<PacketType::SETUP_ACK> : FixedPayload<SetupAckPacket> {};
+template<> struct PacketSpec<PacketType::NEW_PLAYER_JOIN> : FixedPayload<NewPlayerJoinPacket> {};
+template<> struct PacketSpec<PacketType::PLAYER_DISCONNECTED> : FixedPayload<PlayerDisconnectedPacket> {};
+template<> struct PacketSpec<PacketType::SETTINGS_CHANGE_REQ> : FixedPayload<SettingsChangeReqPacket> {};
+template<> struct PacketSpec<PacketType::SETTINGS_UPDATE> : FixedPayload<SettingsUpdatePacket> {};
+template<> struct PacketSpec<PacketType::GAME_START_REQ> : FixedPayload<GameStartRequestPacket> {};
+template<> struct PacketSpec<PacketType::GAME_START> : SnapshotPayload<GameStartPacket> {};
+template<> struct PacketSpec<PacketType::MOVE_REQ> : FixedPayload<MoveRequestPacket> {};
+template<> struct PacketSpec<PacketType::BOARD_STATE_UPDATE> : SnapshotPayload<BoardStateUpdatePacket> {};
+template<> struct PacketSpec<PacketType::BACK_TO_GAME_ROOM> : FixedPayload<BackToGameRoomPacket> {};
+template<> struct PacketSpec<PacketType::GAME_END> : FixedPayload<GameEndPacket> {};
+template<> struct PacketSpec<PacketType::MOVE_APPLIED> : FixedPayload<MoveAppliedPacket> {};
+template<> struct PacketSpec<PacketType::PING> : FixedPayload<PingPacket> {};
+template<> struct PacketSpec<PacketType::PONG> : FixedPayload<PongPacket> {};
+template<> struct PacketSpec<PacketType::RESYNC_REQ> : FixedPayload<ResyncRequestPacket> {};
+
 #endif //TICTACTOEOVERLAN_NETWORKPROTOCOL_H
@@ -0,0 +1,109 @@
+#ifndef TICTACTOEOVERLAN_PACKETDISPATCHER_H
+#define TICTACTOEOVERLAN_PACKETDISPATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+
+#include "NetworkProtocol.h"
+#include "PacketFramer.h"
+
+/**
+ * @brief Outcome of handing a packet to a `PacketDispatcher`.
+ */
+enum class DispatchResult : uint8_t {
+    HANDLED,
+    UNROUTED, // No handler is registered for this packet type
+    MALFORMED // The payload size doesn't match the type's `PacketSpec`, the handler didn't run
+};
+
+/**
+ * @brief Registers `Handler` for the packets of type `Type`.
+ * <br> The handler is a member function whose last parameter is a pointer to the type's payload struct,
+ * the parameters before it are the dispatcher's context.
+ */
+template<PacketType Type, auto Handler>
+struct PacketRoute {
+    constexpr static PacketType TYPE = Type;
+    constexpr static auto HANDLER = Handler;
+};
+
+/**
+ * @brief Turns a list of `PacketRoute`s into a table of handlers indexed by `PacketType`, built at compile time.
+ * <br> Dispatching is one bounds-free table lookup and one indirect call. The payload is checked against
+ * the type's `PacketSpec` before the handler sees it, so handlers can trust the struct they get.
+ *
+ * @tparam Signature `void(Owner &, Context...)`, the object owning the handlers and what they get before the payload.
+ * @tparam Routes The `PacketRoute`s, at most one per packet type.
+ */
+template<typename Signature, typename... Routes>
+class PacketDispatcher;
+
+template<typename Owner, typename... Context, typename... Routes>
+class PacketDispatcher<void(Owner &, Context...), Routes...> {
+    using Entry = DispatchResult (*)(Owner &, const PacketView &, Context...);
+
+    constexpr static size_t TABLE_SIZE = std::numeric_limits<std::underlying_type_t<PacketType>>::max() + 1;
+
+    template<typename Handler>
+    struct HandlerTraits;
+
+    template<typename Result, typename... Args>
+    struct HandlerTraits<Result (Owner::*)(Args...)> {
+        using Payload = std::remove_cv_t<std::remove_pointer_t<std::tuple_element_t<sizeof...(Args) - 1,
+            std::tuple<Args...>>>>;
+    };
+
+    template<typename Route>
+    static DispatchResult invoke(Owner &owner, const PacketView &packet, Context... context) {
+        using Spec = PacketSpec<Route::TYPE>;
+        using Payload = typename Spec::Payload;
+        using Handler = std::remove_const_t<decltype(Route::HANDLER)>;
+        static_assert(std::is_same_v<typename HandlerTraits<Handler>::Payload, Payload>,
+                      "The handler takes a different payload than the PacketSpec of its type");
+
+        if (!Spec::hasValidSize(packet.payload, packet.header.payloadSize)) {
+            return DispatchResult::MALFORMED;
+        }
+
+        (owner.*Route::HANDLER)(context..., reinterpret_cast<const Payload *>(packet.payload));
+        return DispatchResult::HANDLED;
+    }
+
+    constexpr static std::array<Entry, TABLE_SIZE> TABLE = [] {
+        std::array<Entry, TABLE_SIZE> table{};
+        ((table[static_cast<size_t>(Routes::TYPE)] = &invoke<Routes>), ...);
+        return table;
+    }();
+
+    static_assert([] {
+        std::array<bool, TABLE_SIZE> routed{};
+        for (const PacketType type: {Routes::TYPE...}) {
+            if (routed[static_cast<size_t>(type)]) return false;
+            routed[static_cast<size_t>(type)] = true;
+        }
+        return true;
+    }(), "A packet type is routed more than once");
+
+public:
+    /**
+     * @brief Validates the packet and runs the handler registered for its type.
+     *
+     * @param owner The object the handler is called on.
+     * @param packet The received packet.
+     * @param context Passed to the handler in front of the payload.
+     * @return Whether the handler ran, and why not if it didn't.
+     */
+    static DispatchResult dispatch(Owner &owner, const PacketView &packet, Context... context) {
+        const Entry entry = TABLE[static_cast<size_t>(packet.header.type)];
+        if (entry == nullptr) {
+            return DispatchResult::UNROUTED;
+        }
+        return entry(owner, packet, context...);
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_PACKETDISPATCHER_H
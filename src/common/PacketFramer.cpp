@@ -0,0 +1,123 @@
+#include "PacketFramer.h"
+
+#include <algorithm>
+#include <cstring>
+
+PacketFramer::PacketFramer(PacketFramer &&other) noexcept : storage(std::move(other.storage)),
+    readPosition(other.readPosition),
+    writePosition(other.writePosition) {
+    other.storage.clear();
+    other.readPosition = 0;
+    other.writePosition = 0;
+}
+
+PacketFramer &PacketFramer::operator=(PacketFramer &&other) noexcept {
+    if (this != &other) {
+        storage = std::move(other.storage);
+        readPosition = other.readPosition;
+        writePosition = other.writePosition;
+        other.storage.clear();
+        other.readPosition = 0;
+        other.writePosition = 0;
+    }
+    return *this;
+}
+
+char *PacketFramer::writableSpan(size_t &outLength) {
+    if (storage.empty()) {
+        storage.resize(CAPACITY + MAX_FRAME_SIZE);
+    }
+
+    const size_t offset = writePosition & (CAPACITY - 1);
+    outLength = std::min(CAPACITY - this->size(), CAPACITY - offset);
+    return storage.data() + offset;
+}
+
+void PacketFramer::commit(const size_t count) {
+    writePosition += count;
+}
+
+bool PacketFramer::append(const char *data, size_t length) {
+    if (length > CAPACITY - this->size()) {
+        return false;
+    }
+
+    // At most two spans, before and after the end of the ring
+    while (length > 0) {
+        size_t writable;
+        char *destination = this->writableSpan(writable);
+        const size_t count = std::min(writable, length);
+        std::memcpy(destination, data, count);
+        this->commit(count);
+        data += count;
+        length -= count;
+    }
+    return true;
+}
+
+FrameResult PacketFramer::peek(PacketView &outPacket) {
+    const size_t buffered = this->size();
+    if (buffered < sizeof(PacketHeader)) {
+        return FrameResult::INCOMPLETE;
+    }
+
+    const size_t offset = readPosition & (CAPACITY - 1);
+    this->mirrorWrapped(offset, sizeof(PacketHeader));
+
+    PacketHeader header{};
+    std::memcpy(&header, storage.data() + offset, sizeof(PacketHeader));
+
+    const size_t totalPacketSize = sizeof(PacketHeader) + header.payloadSize;
+    if (totalPacketSize > MAX_FRAME_SIZE) {
+        return FrameResult::OVERSIZED;
+    }
+    if (buffered < totalPacketSize) {
+        return FrameResult::INCOMPLETE;
+    }
+
+    this->mirrorWrapped(offset, totalPacketSize);
+
+    outPacket.header = header;
+    outPacket.payload = storage.data() + offset + sizeof(PacketHeader);
+    return FrameResult::READY;
+}
+
+void PacketFramer::pop() {
+    const size_t buffered = this->size();
+    if (buffered < sizeof(PacketHeader)) {
+        return;
+    }
+
+    const size_t offset = readPosition & (CAPACITY - 1);
+    this->mirrorWrapped(offset, sizeof(PacketHeader));
+
+    PacketHeader header{};
+    std::memcpy(&header, storage.data() + offset, sizeof(PacketHeader));
+
+    const size_t totalPacketSize = sizeof(PacketHeader) + header.payloadSize;
+    if (totalPacketSize > MAX_FRAME_SIZE || buffered < totalPacketSize) {
+        return;
+    }
+    readPosition += totalPacketSize;
+
+    // Start over at the beginning of the ring when drained, so the next packets are less likely to wrap
+    if (readPosition == writePosition) {
+        readPosition = 0;
+        writePosition = 0;
+    }
+}
+
+size_t PacketFramer::size() const {
+    return writePosition - readPosition;
+}
+
+bool PacketFramer::empty() const {
+    return readPosition == writePosition;
+}
+
+void PacketFramer::mirrorWrapped(const size_t offset, const size_t length) {
+    if (offset + length <= CAPACITY) {
+        return;
+    }
+    std::memcpy(storage.data() + CAPACITY, storage.data(), offset + length - CAPACITY);
+}
@@ -0,0 +1,119 @@
+#ifndef TICTACTOEOVERLAN_PACKETFRAMER_H
+#define TICTACTOEOVERLAN_PACKETFRAMER_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "NetworkProtocol.h"
+
+/**
+ * @brief A complete packet sitting in a `PacketFramer`.
+ * <br> `payload` points straight into the framer's storage and stays valid until the packet is popped
+ * or more data is written into the framer.
+ */
+struct PacketView {
+    PacketHeader header;
+    const char *payload;
+};
+
+/**
+ * @brief Outcome of looking for the next packet in a `PacketFramer`.
+ */
+enum class FrameResult : uint8_t {
+    INCOMPLETE, // Not enough data for the whole packet yet
+    READY,
+    OVERSIZED // The header announces a packet that can never fit, the stream can't be recovered
+};
+
+/**
+ * @brief Splits a TCP byte stream into packets (Header + Payload) on top of a fixed-capacity ring buffer.
+ * <br> Incoming data is received straight into the free space of the ring, and complete packets are handed out
+ * as views into it, so neither side copies the bytes or shifts the remaining buffer after every packet.
+ * <br> A packet that wraps around the end of the ring gets its wrapped part mirrored into a spare area
+ * right behind the ring, so every view is contiguous. Only that part is ever copied.
+ * <br> The storage is allocated on the first write, so idle framers stay cheap to copy.
+ */
+class PacketFramer {
+public:
+    constexpr static size_t CAPACITY = 16384; //Must be a power of two
+    constexpr static size_t MAX_FRAME_SIZE = 8192; //Biggest header + payload accepted, also the mirror area size
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    static_assert(MAX_FRAME_SIZE <= CAPACITY, "A frame has to fit in the ring");
+    static_assert(sizeof(PacketHeader) + sizeof(BoardStateUpdatePacket) <= MAX_FRAME_SIZE,
+                  "The biggest packet has to fit in a frame");
+
+private:
+    std::vector<char> storage;
+    uint64_t readPosition = 0;
+    uint64_t writePosition = 0;
+
+public:
+    PacketFramer() = default;
+
+    PacketFramer(const PacketFramer &other) = default;
+
+    PacketFramer &operator=(const PacketFramer &other) = default;
+
+    /**
+     * @brief Takes over the other framer's data, leaving it empty.
+     */
+    PacketFramer(PacketFramer &&other) noexcept;
+
+    PacketFramer &operator=(PacketFramer &&other) noexcept;
+
+    /**
+     * @brief Returns the contiguous free space data can be received into.
+     * <br> Call `commit` with the number of bytes actually written.
+     *
+     * @param outLength Output parameter for the size of the returned space, 0 if the ring is full.
+     * @return Pointer to the start of the free space.
+     */
+    char *writableSpan(size_t &outLength);
+
+    /**
+     * @brief Marks bytes written into the `writableSpan` as received.
+     *
+     * @param count Number of bytes written, at most the length reported by `writableSpan`.
+     */
+    void commit(size_t count);
+
+    /**
+     * @brief Copies data into the ring, for bytes that were already received elsewhere.
+     *
+     * @param data The bytes to append.
+     * @param length Number of bytes.
+     * @return False if they don't fit, nothing is appended in that case.
+     */
+    bool append(const char *data, size_t length);
+
+    /**
+     * @brief Looks at the packet at the front of the stream without consuming it.
+     *
+     * @param outPacket Output parameter, filled only when `READY` is returned.
+     * @return Whether a complete packet is available.
+     */
+    FrameResult peek(PacketView &outPacket);
+
+    /**
+     * @brief Consumes the packet at the front of the stream. Does nothing if it isn't complete.
+     */
+    void pop();
+
+    /**
+     * @return Number of buffered bytes, including unfinished packets.
+     */
+    size_t size() const;
+
+    bool empty() const;
+
+private:
+    /**
+     * @brief Copies the part of `[offset, offset + length)` that wrapped to the start of the ring
+     * into the mirror area, making the range contiguous.
+     */
+    void mirrorWrapped(size_t offset, size_t length);
+};
+
+
+#endif //TICTACTOEOVERLAN_PACKETFRAMER_H
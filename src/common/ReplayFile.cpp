@@ -0,0 +1,331 @@
+#include "ReplayFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include "BoardSnapshot.h"
+
+namespace {
+    constexpr uint32_t VARINT_GROUP_BITS = 7;
+    constexpr uint8_t VARINT_CONTINUE_FLAG = 1 << VARINT_GROUP_BITS;
+    constexpr size_t MAX_VARINT_SIZE = 5;
+
+    void writeVarint(std::vector<uint8_t> &output, uint32_t value) {
+        while (value >= VARINT_CONTINUE_FLAG) {
+            output.push_back(static_cast<uint8_t>(value | VARINT_CONTINUE_FLAG));
+            value >>= VARINT_GROUP_BITS;
+        }
+        output.push_back(static_cast<uint8_t>(value));
+    }
+
+    /**
+     * @return False if the varint runs past `end` or is longer than a uint32_t.
+     */
+    bool readVarint(const uint8_t *&input, const uint8_t *end, uint32_t &value) {
+        value = 0;
+        for (size_t i = 0; i < MAX_VARINT_SIZE && input < end; ++i) {
+            const uint8_t byte = *input++;
+            value |= static_cast<uint32_t>(byte & ~VARINT_CONTINUE_FLAG) << (i * VARINT_GROUP_BITS);
+            if ((byte & VARINT_CONTINUE_FLAG) == 0) return true;
+        }
+        return false;
+    }
+
+    uint32_t zigzag(const int32_t value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    int32_t unzigzag(const uint32_t value) {
+        return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+    }
+
+    template<typename T>
+    void appendStruct(std::vector<uint8_t> &output, const T &value) {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        output.insert(output.end(), bytes, bytes + sizeof(T));
+    }
+
+    /**
+     * @brief Sizes the grid to the board and empties it.
+     */
+    void resetBoard(BoardData &board) {
+        const std::vector<BoardSquare> emptyRow(board.boardSize, BoardSquare{PieceType::EMPTY, 0, 0});
+        board.grid.assign(board.boardSize, emptyRow);
+    }
+}
+
+std::vector<uint8_t> ReplayFile::encode(const ReplayMatch &match, uint16_t keyframeInterval) {
+    if (match.boardSize == 0 || match.boardSize > MAX_BOARD_SIZE) return {};
+    if (keyframeInterval == 0) keyframeInterval = 1;
+
+    const uint32_t moveCount = static_cast<uint32_t>(match.moves.size());
+    const int32_t width = match.boardSize;
+
+    BoardData board{};
+    board.boardSize = match.boardSize;
+    board.winConditionLength = match.winConditionLength;
+    resetBoard(board);
+
+    std::vector<uint8_t> stream;
+    std::vector<uint8_t> snapshots;
+    std::vector<ReplayKeyframe> keyframes;
+    stream.reserve(moveCount * 2);
+    int32_t previousCell = 0;
+
+    for (uint32_t i = 0; i <= moveCount; ++i) {
+        if (i % keyframeInterval == 0) {
+            uint8_t snapshot[MAX_BOARD_SNAPSHOT_SIZE];
+            const size_t snapshotSize = BoardSnapshot::encode(board, snapshot, sizeof(snapshot));
+            if (snapshotSize == 0) return {};
+
+            keyframes.push_back(ReplayKeyframe{
+                i, static_cast<uint32_t>(stream.size()), static_cast<uint32_t>(snapshots.size()),
+                static_cast<uint16_t>(snapshotSize), static_cast<uint16_t>(previousCell)
+            });
+            snapshots.insert(snapshots.end(), snapshot, snapshot + snapshotSize);
+        }
+        if (i == moveCount) break;
+
+        const Move &move = match.moves[i];
+        if (move.posX >= width || move.posY >= width) return {};
+
+        // Moves that match their seat only need the roster index, anything else is kept as it was
+        uint8_t rosterIndex = ESCAPED_PLAYER;
+        for (size_t p = 0; p < match.players.size() && p < ESCAPED_PLAYER; ++p) {
+            if (match.players[p].playerId == move.playerId && match.players[p].piece == move.piece) {
+                rosterIndex = static_cast<uint8_t>(p);
+                break;
+            }
+        }
+
+        const int32_t cell = move.posY * width + move.posX;
+        writeVarint(stream, zigzag(cell - previousCell) << ROSTER_BITS | rosterIndex);
+        if (rosterIndex == ESCAPED_PLAYER) {
+            stream.push_back(move.playerId);
+            stream.push_back(static_cast<uint8_t>(move.piece));
+        }
+        previousCell = cell;
+
+        board.grid[move.posY][move.posX] = BoardSquare{move.piece, move.playerId, move.turnPlaced};
+    }
+
+    ReplayHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.boardSize = match.boardSize;
+    header.winConditionLength = match.winConditionLength;
+    header.roomId = match.roomId;
+    header.round = match.round;
+    header.firstTurn = match.moves.empty() ? 0 : match.moves.front().turnPlaced;
+    header.startedAtMs = match.startedAtMs;
+    header.finishReason = match.finishReason;
+    header.finishPlayerId = match.finishPlayerId;
+    header.playerCount = static_cast<uint8_t>(std::min<size_t>(match.players.size(), UINT8_MAX));
+    header.keyframeInterval = keyframeInterval;
+    header.moveCount = moveCount;
+    header.keyframeCount = static_cast<uint32_t>(keyframes.size());
+    header.moveStreamSize = static_cast<uint32_t>(stream.size());
+    header.snapshotDataSize = static_cast<uint32_t>(snapshots.size());
+
+    std::vector<uint8_t> output;
+    output.reserve(sizeof(ReplayHeader) + header.playerCount * sizeof(ReplayPlayer)
+                   + keyframes.size() * sizeof(ReplayKeyframe) + stream.size() + snapshots.size());
+    appendStruct(output, header);
+    for (size_t p = 0; p < header.playerCount; ++p) {
+        appendStruct(output, match.players[p]);
+    }
+    for (const auto &keyframe: keyframes) {
+        appendStruct(output, keyframe);
+    }
+    output.insert(output.end(), stream.begin(), stream.end());
+    output.insert(output.end(), snapshots.begin(), snapshots.end());
+    return output;
+}
+
+bool ReplayFile::save(const std::string &path, const ReplayMatch &match, const uint16_t keyframeInterval) {
+    const std::vector<uint8_t> bytes = encode(match, keyframeInterval);
+    return !bytes.empty() && write(path, bytes);
+}
+
+bool ReplayFile::write(const std::string &path, const std::vector<uint8_t> &bytes) {
+    // Written next to the target and renamed over it, an archive never holds half a replay
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file) return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+bool ReplayReader::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return this->parse(std::move(bytes));
+}
+
+bool ReplayReader::parse(std::vector<uint8_t> bytes) {
+    data = std::move(bytes);
+    players.clear();
+    keyframes.clear();
+    header = ReplayHeader{};
+
+    if (data.size() < sizeof(ReplayHeader)) return false;
+    ReplayHeader parsed{};
+    std::memcpy(&parsed, data.data(), sizeof(ReplayHeader));
+    if (parsed.magic != ReplayFile::MAGIC || parsed.version != ReplayFile::VERSION) return false;
+    if (parsed.boardSize == 0 || parsed.boardSize > MAX_BOARD_SIZE || parsed.keyframeInterval == 0) return false;
+    if (parsed.keyframeCount != parsed.moveCount / parsed.keyframeInterval + 1) return false;
+
+    // The sections have to add up to the file exactly
+    const uint64_t playersOffset = sizeof(ReplayHeader);
+    const uint64_t keyframesOffset = playersOffset + uint64_t{parsed.playerCount} * sizeof(ReplayPlayer);
+    const uint64_t streamOffset = keyframesOffset + uint64_t{parsed.keyframeCount} * sizeof(ReplayKeyframe);
+    const uint64_t snapshotOffset = streamOffset + parsed.moveStreamSize;
+    if (snapshotOffset + parsed.snapshotDataSize != data.size()) return false;
+
+    players.resize(parsed.playerCount);
+    if (!players.empty()) {
+        std::memcpy(players.data(), data.data() + playersOffset, players.size() * sizeof(ReplayPlayer));
+    }
+    for (auto &player: players) {
+        player.playerName[MAX_PLAYER_NAME_LENGTH - 1] = '\0';
+    }
+
+    keyframes.resize(parsed.keyframeCount);
+    std::memcpy(keyframes.data(), data.data() + keyframesOffset, keyframes.size() * sizeof(ReplayKeyframe));
+
+    // The index has to be sorted and inside the file, `findKeyframe` and `decodeFrom` rely on it
+    const uint32_t cellCount = uint32_t{parsed.boardSize} * parsed.boardSize;
+    for (size_t k = 0; k < keyframes.size(); ++k) {
+        const ReplayKeyframe &keyframe = keyframes[k];
+        if (keyframe.moveIndex != k * parsed.keyframeInterval
+            || keyframe.streamOffset > parsed.moveStreamSize
+            || uint64_t{keyframe.snapshotOffset} + keyframe.snapshotSize > parsed.snapshotDataSize
+            || keyframe.previousCell >= cellCount
+            || (k > 0 && keyframe.streamOffset < keyframes[k - 1].streamOffset)) {
+            keyframes.clear();
+            players.clear();
+            return false;
+        }
+    }
+
+    header = parsed;
+    moveStreamOffset = streamOffset;
+    snapshotDataOffset = snapshotOffset;
+    return true;
+}
+
+size_t ReplayReader::findKeyframe(const uint32_t moveIndex) const {
+    const auto next = std::upper_bound(keyframes.begin(), keyframes.end(), moveIndex,
+                                       [](const uint32_t index, const ReplayKeyframe &keyframe) {
+                                           return index < keyframe.moveIndex;
+                                       });
+    return static_cast<size_t>(next - keyframes.begin()) - 1;
+}
+
+template<typename Visitor>
+bool ReplayReader::decodeFrom(const ReplayKeyframe &keyframe, const uint32_t count, Visitor &&visit) const {
+    const uint8_t *input = data.data() + moveStreamOffset + keyframe.streamOffset;
+    const uint8_t *end = data.data() + moveStreamOffset + header.moveStreamSize;
+    const int32_t width = header.boardSize;
+    int32_t previousCell = keyframe.previousCell;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t value;
+        if (!readVarint(input, end, value)) return false;
+
+        const int32_t cell = previousCell + unzigzag(value >> ReplayFile::ROSTER_BITS);
+        if (cell < 0 || cell >= width * width) return false;
+        previousCell = cell;
+
+        Move move{};
+        move.posX = static_cast<uint8_t>(cell % width);
+        move.posY = static_cast<uint8_t>(cell / width);
+        move.turnPlaced = static_cast<uint16_t>(header.firstTurn + keyframe.moveIndex + i);
+
+        const uint8_t rosterIndex = value & ((1 << ReplayFile::ROSTER_BITS) - 1);
+        if (rosterIndex == ReplayFile::ESCAPED_PLAYER) {
+            if (end - input < 2) return false;
+            move.playerId = input[0];
+            move.piece = static_cast<PieceType>(input[1]);
+            input += 2;
+        } else {
+            if (rosterIndex >= players.size()) return false;
+            move.playerId = players[rosterIndex].playerId;
+            move.piece = players[rosterIndex].piece;
+        }
+
+        visit(move);
+    }
+    return true;
+}
+
+bool ReplayReader::readMoves(const uint32_t first, const uint32_t count, std::vector<Move> &outMoves) const {
+    outMoves.clear();
+    if (keyframes.empty() || first > header.moveCount || count > header.moveCount - first) return false;
+
+    const ReplayKeyframe &keyframe = keyframes[this->findKeyframe(first)];
+    outMoves.reserve(count);
+    uint32_t index = keyframe.moveIndex;
+    return this->decodeFrom(keyframe, first - keyframe.moveIndex + count, [&](const Move &move) {
+        if (index++ >= first) outMoves.push_back(move);
+    });
+}
+
+bool ReplayReader::loadKeyframe(const ReplayKeyframe &keyframe, BoardData &outBoard) const {
+    if (keyframes.empty()) return false;
+
+    outBoard.boardSize = header.boardSize;
+    outBoard.winConditionLength = header.winConditionLength;
+    outBoard.round = header.round;
+    outBoard.turn = static_cast<uint16_t>(header.firstTurn + keyframe.moveIndex);
+    outBoard.actingPlayerId = 0;
+    resetBoard(outBoard);
+
+    if (!BoardSnapshot::decode(data.data() + snapshotDataOffset + keyframe.snapshotOffset, keyframe.snapshotSize,
+                               outBoard)) {
+        return false;
+    }
+
+    // Snapshots only carry pieces, the owner comes from the roster
+    for (auto &row: outBoard.grid) {
+        for (auto &square: row) {
+            if (square.piece == PieceType::EMPTY) continue;
+            for (const auto &player: players) {
+                if (player.piece == square.piece) {
+                    square.playerId = player.playerId;
+                    break;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool ReplayReader::seek(uint32_t moveCount, BoardData &outBoard) const {
+    if (keyframes.empty()) return false;
+    const uint32_t totalMoves = header.moveCount; //Packed, std::min would bind a misaligned reference
+    moveCount = std::min(moveCount, totalMoves);
+
+    const ReplayKeyframe &keyframe = keyframes[this->findKeyframe(moveCount)];
+    if (!this->loadKeyframe(keyframe, outBoard)) return false;
+
+    const bool decoded = this->decodeFrom(keyframe, moveCount - keyframe.moveIndex, [&](const Move &move) {
+        outBoard.grid[move.posY][move.posX] = BoardSquare{move.piece, move.playerId, move.turnPlaced};
+    });
+    outBoard.turn = static_cast<uint16_t>(header.firstTurn + moveCount);
+    return decoded;
+}
@@ -0,0 +1,211 @@
+#ifndef TICTACTOEOVERLAN_REPLAYFILE_H
+#define TICTACTOEOVERLAN_REPLAYFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameDefinitions.h"
+#include "NetworkProtocol.h"
+
+#pragma pack(push, 1)
+
+/**
+ * @brief The start of a replay file.
+ * <br> A file is laid out as: header, `playerCount` ReplayPlayers, `keyframeCount` ReplayKeyframes,
+ * the move stream (`moveStreamSize` bytes) and the keyframes' board snapshots (`snapshotDataSize` bytes).
+ */
+struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t boardSize;
+    uint8_t winConditionLength;
+    uint32_t roomId;
+    uint16_t round;
+    uint16_t firstTurn; //Turn of the first move, every further move is one turn later
+    uint64_t startedAtMs; //Unix time of the GAME_START
+    FinishReason finishReason;
+    uint8_t finishPlayerId; //The winner, or the player who left
+    uint8_t playerCount;
+    uint16_t keyframeInterval;
+    uint32_t moveCount;
+    uint32_t keyframeCount;
+    uint32_t moveStreamSize;
+    uint32_t snapshotDataSize;
+};
+
+/**
+ * @brief A seat of the roster, moves refer to it by index.
+ */
+struct ReplayPlayer {
+    uint8_t playerId;
+    PieceType piece;
+    uint8_t isHost;
+    char playerName[MAX_PLAYER_NAME_LENGTH];
+};
+
+/**
+ * @brief Where decoding can start without the moves before: the board as it was after `moveIndex` moves,
+ * and the position of the next move in the stream.
+ */
+struct ReplayKeyframe {
+    uint32_t moveIndex;
+    uint32_t streamOffset;
+    uint32_t snapshotOffset; //Into the snapshot data, a `BoardSnapshot`
+    uint16_t snapshotSize;
+    uint16_t previousCell; //The cell of move `moveIndex - 1`, the base of the next delta
+};
+
+#pragma pack(pop)
+
+/**
+ * @brief One finished game, what a replay file stores.
+ */
+struct ReplayMatch {
+    uint32_t roomId = 0;
+    uint8_t boardSize = 3;
+    uint8_t winConditionLength = 3;
+    uint16_t round = 1;
+    uint64_t startedAtMs = 0;
+    FinishReason finishReason = FinishReason::NONE;
+    uint8_t finishPlayerId = 0;
+    std::vector<ReplayPlayer> players;
+    std::vector<Move> moves; //In turn order, consecutive turns
+};
+
+/**
+ * @brief Compact archive format of a finished game, for auditing it later without the server.
+ * <br> Moves are delta-encoded: a move is a single varint of the distance to the previous move's cell
+ * (`y * boardSize + x`, zigzag encoded) and the mover's index in the roster, 1-2 bytes for most moves.
+ * The turn follows from the position in the stream and the piece from the roster. A move that doesn't match
+ * its roster entry, e.g. a client that sent someone else's piece, is escaped and stored in full.
+ * <br> Every `keyframeInterval` moves a keyframe stores the whole board as a `BoardSnapshot`. The keyframes
+ * form a sorted, fixed size index, so `ReplayReader::seek` finds the nearest one with a binary search and decodes
+ * at most `keyframeInterval - 1` moves from there: O(log n) for any turn of any game.
+ * <br> Integers are stored little-endian, like the network protocol.
+ */
+class ReplayFile {
+public:
+    constexpr static uint32_t MAGIC = 0x52545454; //"TTTR"
+    constexpr static uint16_t VERSION = 1;
+    constexpr static uint16_t DEFAULT_KEYFRAME_INTERVAL = 64;
+    constexpr static auto FILE_EXTENSION = ".replay";
+
+    constexpr static uint8_t ESCAPED_PLAYER = 7; // Roster index of a move stored in full
+    constexpr static size_t ROSTER_BITS = 3;
+
+    /**
+     * @brief Encodes a finished game.
+     *
+     * @param match The game, its moves on a board of `boardSize`.
+     * @param keyframeInterval Moves between two keyframes, at least 1.
+     * @return The file contents, empty if a move lies outside the board.
+     */
+    static std::vector<uint8_t> encode(const ReplayMatch &match,
+                                       uint16_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+    /**
+     * @brief Encodes a finished game and writes it to a file.
+     *
+     * @return False if it couldn't be encoded or written.
+     */
+    static bool save(const std::string &path, const ReplayMatch &match,
+                     uint16_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
+
+    /**
+     * @brief Writes an encoded game to a file, through a temporary file renamed over the target.
+     *
+     * @param bytes The file contents, as returned by `encode`.
+     * @return False if it couldn't be written.
+     */
+    static bool write(const std::string &path, const std::vector<uint8_t> &bytes);
+};
+
+/**
+ * @brief Reads a replay file, validating its layout once and seeking in it without decoding the whole game.
+ */
+class ReplayReader {
+    std::vector<uint8_t> data;
+    ReplayHeader header{};
+    std::vector<ReplayPlayer> players;
+    std::vector<ReplayKeyframe> keyframes;
+    size_t moveStreamOffset = 0;
+    size_t snapshotDataOffset = 0;
+
+public:
+    /**
+     * @brief Reads and parses a replay file.
+     *
+     * @return False if it can't be read or isn't a valid replay.
+     */
+    bool load(const std::string &path);
+
+    /**
+     * @brief Parses a replay from memory.
+     *
+     * @param bytes The file contents, kept by the reader.
+     * @return False if it isn't a valid replay.
+     */
+    bool parse(std::vector<uint8_t> bytes);
+
+    const ReplayHeader &getHeader() const {
+        return header;
+    }
+
+    const std::vector<ReplayPlayer> &getPlayers() const {
+        return players;
+    }
+
+    const std::vector<ReplayKeyframe> &getKeyframes() const {
+        return keyframes;
+    }
+
+    /**
+     * @brief Decodes moves `[first, first + count)`, starting from the keyframe at or before `first`.
+     *
+     * @param outMoves Receives the moves.
+     * @return False if the range is out of bounds or the stream is corrupt.
+     */
+    bool readMoves(uint32_t first, uint32_t count, std::vector<Move> &outMoves) const;
+
+    /**
+     * @brief Rebuilds the board as it was after the first `moveCount` moves.
+     * <br> Loads the nearest keyframe at or before it (binary search) and applies the moves after it.
+     * <br> Squares keep their piece, owner and, for the moves after the keyframe, the turn they were placed on.
+     *
+     * @param moveCount How many moves to apply, clamped to the game's length.
+     * @param outBoard Receives the board, with the replay's size and rules.
+     * @return False if the replay is corrupt.
+     */
+    bool seek(uint32_t moveCount, BoardData &outBoard) const;
+
+    /**
+     * @brief Decodes the board snapshot a keyframe holds.
+     *
+     * @param keyframe One of `getKeyframes`.
+     * @param outBoard Receives the board, with the replay's size and rules.
+     * @return False if the snapshot is corrupt.
+     */
+    bool loadKeyframe(const ReplayKeyframe &keyframe, BoardData &outBoard) const;
+
+private:
+    /**
+     * @return The index of the last keyframe at or before the move, the first keyframe always starts at move 0.
+     */
+    size_t findKeyframe(uint32_t moveIndex) const;
+
+    /**
+     * @brief Decodes moves from the stream, starting at a keyframe.
+     *
+     * @param keyframe Where to start.
+     * @param count How many moves to decode.
+     * @param visit Called with every decoded move.
+     * @return False if the stream ends early or holds an invalid move.
+     */
+    template<typename Visitor>
+    bool decodeFrom(const ReplayKeyframe &keyframe, uint32_t count, Visitor &&visit) const;
+};
+
+
+#endif //TICTACTOEOVERLAN_REPLAYFILE_H
@@ -6,9 +6,12 @@
  * <br> Used to retrieve a snapshot of the current performance metrics in a single call.
  */
 struct PackagedValues {
-    double average;
-    double min;
-    double max;
+    double average = 0;
+    double min = 0;
+    double max = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double p999 = 0; //99.9th percentile, the tail an average hides
 };
 
 /**
@@ -42,13 +45,21 @@ public:
      */
     virtual double max() = 0;
 
+    /**
+     * @brief Estimates a percentile of the values currently in the rolling window.
+     *
+     * @param percentile Between 0 and 100, e.g. 99 for the value 99% of the samples are at or below.
+     * @return The value at that percentile.
+     */
+    virtual double percentile(double percentile) = 0;
+
     /**
      * @brief Retrieves all statistical metrics in a single structure.
      * <br> This is preferred over calling average/min/max individually if you need
      * to display all of them (e.g., in a debug overlay), as it ensures the values
      * come from the exact same calculation state.
      *
-     * @return A PackagedValues struct containing average, min, and max.
+     * @return A PackagedValues struct containing average, min, max and the p50, p99 and p99.9 percentiles.
      */
     virtual PackagedValues getPackagedValues() = 0;
 };
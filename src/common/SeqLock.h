@@ -0,0 +1,87 @@
+#ifndef TICTACTOEOVERLAN_SEQLOCK_H
+#define TICTACTOEOVERLAN_SEQLOCK_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+/**
+ * @brief Publishes a value from exactly one writer thread to any number of reader threads, without locks.
+ * <br> The writer never waits: it bumps `sequence` to an odd number, stores the value and bumps it again.
+ * A reader copies the value out and retries if the sequence was odd or changed meanwhile, so it only ever
+ * sees a complete value.
+ * <br> The value is stored as relaxed atomic words, a torn read is detected instead of being a data race.
+ *
+ * @tparam T The published type, has to be trivially copyable.
+ */
+template<typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock copies the value bytewise");
+
+    constexpr static size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint64_t> sequence = 0; //Odd while a store is in progress
+    std::array<std::atomic<uint64_t>, WORD_COUNT> words{};
+
+public:
+    /**
+     * @brief Starts out publishing a value-initialized `T`.
+     */
+    SeqLock() {
+        this->store(T{});
+    }
+
+    /**
+     * @brief Replaces the published value, writer side only.
+     */
+    void store(const T &value) {
+        std::array<uint64_t, WORD_COUNT> buffer{};
+        std::memcpy(buffer.data(), &value, sizeof(T));
+
+        const uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < WORD_COUNT; ++i) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copies out the latest complete value, from any thread.
+     * <br> Only retries while a store overlaps the copy, which takes as long as the copy itself.
+     *
+     * @return The value.
+     */
+    T load() const {
+        std::array<uint64_t, WORD_COUNT> buffer;
+        while (true) {
+            const uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (size_t i = 0; i < WORD_COUNT; ++i) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+
+        T value;
+        std::memcpy(static_cast<void *>(&value), buffer.data(), sizeof(T));
+        return value;
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_SEQLOCK_H
@@ -0,0 +1,193 @@
+#ifndef TICTACTOEOVERLAN_SOCKETLAYER_H
+#define TICTACTOEOVERLAN_SOCKETLAYER_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+// The Winsock names the rest of the code is written against
+using SOCKET = int;
+constexpr static SOCKET INVALID_SOCKET = -1;
+constexpr static int SOCKET_ERROR = -1;
+#endif
+
+/**
+ * @brief Thin wrapper over the few socket calls that differ between Winsock and POSIX sockets.
+ * <br> On Windows it maps to Winsock, everywhere else to the BSD socket API, so the server builds on both.
+ * <br> Everything else (socket, bind, listen, accept, recv, ...) has the same shape on both and is called directly.
+ */
+class SocketLayer {
+public:
+    /**
+     * @brief Initializes the socket library for this process, call once before creating sockets.
+     * <br> On POSIX this ignores SIGPIPE instead, writing to a closed connection must not kill the server.
+     *
+     * @return True on success.
+     */
+    static bool startup() {
+#ifdef _WIN32
+        WSADATA wsadata;
+        return WSAStartup(MAKEWORD(2, 2), &wsadata) == 0;
+#else
+        std::signal(SIGPIPE, SIG_IGN);
+        return true;
+#endif
+    }
+
+    /**
+     * @brief Releases the socket library, pairs with `startup`.
+     */
+    static void cleanup() {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    static void close(const SOCKET socket) {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        ::close(socket);
+#endif
+    }
+
+    /**
+     * @brief Stops both directions of a connection without releasing the socket.
+     */
+    static void shutdownBoth(const SOCKET socket) {
+#ifdef _WIN32
+        shutdown(socket, SD_BOTH);
+#else
+        shutdown(socket, SHUT_RDWR);
+#endif
+    }
+
+    /**
+     * @brief Tells the peer no more data is coming, receiving still works.
+     */
+    static void shutdownSend(const SOCKET socket) {
+#ifdef _WIN32
+        shutdown(socket, SD_SEND);
+#else
+        shutdown(socket, SHUT_WR);
+#endif
+    }
+
+    static bool setNonBlocking(const SOCKET socket) {
+#ifdef _WIN32
+        u_long mode = 1;
+        return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+        const int flags = fcntl(socket, F_GETFL, 0);
+        return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    }
+
+    /**
+     * @brief Disables Nagle's algorithm, small packets leave right away instead of waiting to be merged.
+     */
+    static bool setNoDelay(const SOCKET socket) {
+        constexpr int noDelay = 1;
+        return setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay),
+                          sizeof(noDelay)) == 0;
+    }
+
+    /**
+     * @brief Lets a restarted server bind its port again while old connections are still in TIME_WAIT.
+     * <br> No-op on Windows, where SO_REUSEADDR would allow stealing a port that's in use.
+     */
+    static bool setReuseAddress(const SOCKET socket) {
+#ifdef _WIN32
+        return true;
+#else
+        constexpr int reuse = 1;
+        return setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == 0;
+#endif
+    }
+
+    /**
+     * @return True if several listeners can share a port and the kernel balances new connections across them.
+     */
+    static bool supportsReusePort() {
+#ifdef __linux__
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Lets every listener that sets this option bind the same port, see `supportsReusePort`.
+     * <br> Fails everywhere but Linux, the BSDs only hand connections to the last listener instead of spreading them.
+     */
+    static bool setReusePort(const SOCKET socket) {
+#ifdef __linux__
+        constexpr int reuse = 1;
+        return setsockopt(socket, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) == 0;
+#else
+        (void) socket;
+        return false;
+#endif
+    }
+
+    /**
+     * @return The error code of the last failed socket call on this thread.
+     */
+    static int lastError() {
+#ifdef _WIN32
+        return WSAGetLastError();
+#else
+        return errno;
+#endif
+    }
+
+    /**
+     * @return True if the last `connect` on a non-blocking socket failed only because it is still in progress.
+     */
+    static bool lastErrorConnectInProgress() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EINPROGRESS;
+#endif
+    }
+
+    /**
+     * @return The error a non-blocking `connect` finished with, 0 if it succeeded.
+     */
+    static int pendingError(const SOCKET socket) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length) != 0) {
+            return lastError();
+        }
+        return error;
+    }
+
+    /**
+     * @return True if the last failed call only failed because the non-blocking socket wasn't ready.
+     */
+    static bool lastErrorWouldBlock() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EWOULDBLOCK || errno == EAGAIN;
+#endif
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_SOCKETLAYER_H
@@ -0,0 +1,71 @@
+#ifndef TICTACTOEOVERLAN_SPSCQUEUE_H
+#define TICTACTOEOVERLAN_SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * <br> The producer only writes `tail` and the consumer only writes `head`, each on its own cache line,
+ * so neither side ever waits for the other.
+ *
+ * @tparam T The element type, moved in and out.
+ * @tparam Capacity Number of slots, a power of two.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+    constexpr static size_t MASK = Capacity - 1;
+
+    std::array<T, Capacity> slots{};
+    alignas(64) std::atomic<size_t> head = 0; //Next slot to pop, written by the consumer
+    alignas(64) std::atomic<size_t> tail = 0; //Next slot to push, written by the producer
+
+public:
+    /**
+     * @brief Appends an element, producer side only.
+     *
+     * @param value The element, left untouched if the queue is full.
+     * @return False if the queue is full.
+     */
+    bool tryPush(T &&value) {
+        const size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+
+        slots[currentTail & MASK] = std::move(value);
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, consumer side only.
+     *
+     * @param outValue Receives the element.
+     * @return False if the queue is empty.
+     */
+    bool tryPop(T &outValue) {
+        const size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        outValue = std::move(slots[currentHead & MASK]);
+        slots[currentHead & MASK] = T{}; //Don't keep a reference to the popped element alive
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @return True if nothing is queued, exact only on the consumer side.
+     */
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_SPSCQUEUE_H
@@ -0,0 +1,161 @@
+#include "Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "Logger.h"
+#include "Utils.h"
+
+namespace {
+    /**
+     * @brief Owns the calling thread's buffer, flags it once the thread exits.
+     */
+    struct ThreadBufferHandle {
+        std::shared_ptr<TraceBuffer> buffer;
+        std::string threadName; //Until the buffer exists
+
+        ~ThreadBufferHandle() {
+            if (buffer != nullptr) buffer->threadAlive = false;
+        }
+    };
+
+    thread_local ThreadBufferHandle threadBufferHandle;
+}
+
+TraceBuffer::TraceBuffer(const uint32_t threadId) : slots(std::make_unique<Slot[]>(CAPACITY)),
+                                                    threadId(threadId) {
+}
+
+void TraceBuffer::record(const char *name, const uint64_t startNs, const uint64_t durationNs) {
+    const uint64_t index = claimed.load(std::memory_order_relaxed);
+    // Claimed before the slot is touched, a reader that sees any of the new fields also sees the claim
+    claimed.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Slot &slot = slots[index & MASK];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(durationNs, std::memory_order_relaxed);
+    published.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TraceBuffer::Event> TraceBuffer::snapshot() const {
+    const uint64_t end = published.load(std::memory_order_acquire);
+    const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+    std::vector<Event> events;
+    events.reserve(end - begin);
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot &slot = slots[index & MASK];
+        events.push_back({
+            slot.name.load(std::memory_order_relaxed),
+            slot.startNs.load(std::memory_order_relaxed),
+            slot.durationNs.load(std::memory_order_relaxed)
+        });
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // Whatever the writer claimed meanwhile may have overwritten the oldest events we copied
+    const uint64_t claimedNow = claimed.load(std::memory_order_relaxed);
+    const uint64_t firstIntact = claimedNow > CAPACITY ? claimedNow - CAPACITY : 0;
+    if (firstIntact > begin) {
+        events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(
+                         std::min<uint64_t>(firstIntact - begin, events.size())));
+    }
+    return events;
+}
+
+void Tracer::setEnabled(const bool enable) {
+    if (enable) {
+        std::lock_guard lock(registryMutex);
+        std::erase_if(buffers, [](const std::shared_ptr<TraceBuffer> &buffer) {
+            return !buffer->threadAlive.load();
+        });
+    }
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const std::string &name) {
+    std::lock_guard lock(registryMutex);
+    threadBufferHandle.threadName = name;
+    if (threadBufferHandle.buffer != nullptr) {
+        threadBufferHandle.buffer->threadName = name;
+    }
+}
+
+uint64_t Tracer::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *name, const uint64_t startNs, const uint64_t durationNs) {
+    if (!isEnabled()) {
+        return;
+    }
+    threadBuffer().record(name, startNs, durationNs);
+}
+
+TraceBuffer &Tracer::threadBuffer() {
+    if (threadBufferHandle.buffer == nullptr) {
+        std::lock_guard lock(registryMutex);
+        threadBufferHandle.buffer = std::make_shared<TraceBuffer>(nextThreadId++);
+        threadBufferHandle.buffer->threadName = threadBufferHandle.threadName;
+        buffers.push_back(threadBufferHandle.buffer);
+    }
+    return *threadBufferHandle.buffer;
+}
+
+bool Tracer::exportChromeTrace(const std::string &path) {
+    std::vector<std::shared_ptr<TraceBuffer>> tracedBuffers;
+    std::vector<std::string> threadNames;
+    {
+        std::lock_guard lock(registryMutex);
+        tracedBuffers = buffers;
+        for (const auto &buffer: buffers) {
+            threadNames.push_back(buffer->threadName);
+        }
+    }
+
+    std::vector<std::vector<TraceBuffer::Event>> events;
+    uint64_t originNs = UINT64_MAX;
+    for (const auto &buffer: tracedBuffers) {
+        events.push_back(buffer->snapshot());
+        if (!events.back().empty()) {
+            originNs = std::min(originNs, events.back().front().startNs);
+        }
+    }
+
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        LOG_ERROR(SERVER, ANSI_RED "[Tracer] Failed to open %s for the trace\n" ANSI_RESET, path.c_str());
+        return false;
+    }
+
+    // Timestamps are in microseconds, relative to the oldest span so they stay readable
+    size_t spanCount = 0;
+    bool first = true;
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+    for (size_t i = 0; i < tracedBuffers.size(); ++i) {
+        const uint32_t threadId = tracedBuffers[i]->threadId;
+        const std::string name = threadNames[i].empty() ? "Thread " + std::to_string(threadId) : threadNames[i];
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     first ? "" : ",\n", threadId, name.c_str());
+        first = false;
+
+        for (const auto &event: events[i]) {
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         event.name, threadId, static_cast<double>(event.startNs - originNs) / 1000.0,
+                         static_cast<double>(event.durationNs) / 1000.0);
+            ++spanCount;
+        }
+    }
+    std::fputs("\n]}\n", file);
+
+    const bool written = std::fclose(file) == 0;
+    if (written) {
+        LOG_INFO(SERVER, ANSI_GREEN "[Tracer] Wrote %zu span(s) of %zu thread(s) to %s\n" ANSI_RESET,
+                 spanCount, tracedBuffers.size(), path.c_str());
+    }
+    return written;
+}
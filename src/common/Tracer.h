@@ -0,0 +1,155 @@
+#ifndef TICTACTOEOVERLAN_TRACER_H
+#define TICTACTOEOVERLAN_TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Spans compile to nothing with -DTICTACTOE_TRACING=0, otherwise they cost one relaxed load while tracing is off
+#ifndef TICTACTOE_TRACING
+#define TICTACTOE_TRACING 1
+#endif
+
+#define TICTACTOE_TRACE_CONCAT_INNER(a, b) a##b
+#define TICTACTOE_TRACE_CONCAT(a, b) TICTACTOE_TRACE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope, e.g. TRACE_SPAN("recv"). The name has to point to a string literal.
+#if TICTACTOE_TRACING
+#define TRACE_SPAN(name) const TraceSpan TICTACTOE_TRACE_CONCAT(traceSpan, __LINE__)(name)
+#else
+#define TRACE_SPAN(name) do {} while (false)
+#endif
+
+/**
+ * @brief The spans one thread recorded, a ring that keeps the latest `CAPACITY` of them.
+ * <br> Only the owning thread writes, `Tracer::exportChromeTrace` reads it from any thread. Like `SeqLock`,
+ * the writer never waits: the reader copies the events out and drops the ones overwritten meanwhile.
+ */
+class TraceBuffer {
+public:
+    constexpr static size_t CAPACITY = 1 << 15;
+
+    struct Event {
+        const char *name;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+private:
+    constexpr static size_t MASK = CAPACITY - 1;
+
+    struct Slot {
+        std::atomic<const char *> name = nullptr;
+        std::atomic<uint64_t> startNs = 0;
+        std::atomic<uint64_t> durationNs = 0;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> claimed = 0; //Events the writer started writing
+    std::atomic<uint64_t> published = 0; //Events completely written, trails `claimed` by at most one
+
+public:
+    const uint32_t threadId;
+    std::string threadName; //Guarded by the tracer's registry mutex
+    std::atomic<bool> threadAlive = true;
+
+    explicit TraceBuffer(uint32_t threadId);
+
+    /**
+     * @brief Appends a finished span, owning thread only. Overwrites the oldest one once the ring is full.
+     */
+    void record(const char *name, uint64_t startNs, uint64_t durationNs);
+
+    /**
+     * @brief Copies out every event that is still in the ring, oldest first, from any thread.
+     */
+    std::vector<Event> snapshot() const;
+};
+
+/**
+ * @brief Records timed spans of the server's work and exports them in the Chrome trace event format.
+ * <br> Every thread that records gets its own `TraceBuffer` on its first span, past that recording never locks or
+ * allocates. Tracing is off until `setEnabled(true)`, a span then costs two clock reads and a few relaxed stores.
+ * <br> The export opens in chrome://tracing or https://ui.perfetto.dev, one row per thread with the spans nested.
+ */
+class Tracer {
+    inline static std::atomic<bool> enabled = false;
+
+    inline static std::mutex registryMutex;
+    inline static std::vector<std::shared_ptr<TraceBuffer>> buffers; //Kept after their thread exits, for the export
+    inline static uint32_t nextThreadId = 1;
+
+public:
+    /**
+     * @brief Starts or stops recording spans.
+     * <br> Starting drops the buffers of threads that have exited since, so a long running client that hosts
+     * many games doesn't pile them up.
+     */
+    static void setEnabled(bool enable);
+
+    static bool isEnabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Names the calling thread's row in the export, e.g. "Shard 0".
+     * <br> Doesn't allocate a buffer, a thread that never records while tracing is on doesn't cost anything.
+     */
+    static void setThreadName(const std::string &name);
+
+    /**
+     * @return Nanoseconds on the steady clock, the clock every span is measured with.
+     */
+    static uint64_t nowNs();
+
+    /**
+     * @brief Appends a finished span to the calling thread's buffer, ignored while tracing is off.
+     *
+     * @param name A string literal, it's only read at export time.
+     */
+    static void record(const char *name, uint64_t startNs, uint64_t durationNs);
+
+    /**
+     * @brief Writes every buffered span of every thread as Chrome trace event JSON.
+     * <br> Safe while the threads keep recording, it doesn't stop them.
+     *
+     * @param path The file to (over)write.
+     * @return False if the file couldn't be written.
+     */
+    static bool exportChromeTrace(const std::string &path);
+
+private:
+    /**
+     * @return The calling thread's buffer, registered on first use.
+     */
+    static TraceBuffer &threadBuffer();
+};
+
+/**
+ * @brief Times its own lifetime and records it as a span, use the TRACE_SPAN macro.
+ */
+class TraceSpan {
+    const char *name;
+    uint64_t startNs; //0 if tracing was off when the span began
+
+public:
+    explicit TraceSpan(const char *name) : name(name), startNs(Tracer::isEnabled() ? Tracer::nowNs() : 0) {
+    }
+
+    ~TraceSpan() {
+        if (startNs != 0) {
+            Tracer::record(name, startNs, Tracer::nowNs() - startNs);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+
+    TraceSpan &operator=(const TraceSpan &) = delete;
+};
+
+
+#endif //TICTACTOEOVERLAN_TRACER_H
@@ -17,6 +17,9 @@
 #define ACCENT_COLOR {142, 166, 165}
 #define INACTIVE_COLOR {150, 150, 150}
 
+#include <algorithm>
+
+#include "BoardSnapshot.h"
 #include "GameDefinitions.h"
 #include "string"
 
@@ -79,7 +82,7 @@ public:
     /**
      * @brief Flattens the 2D dynamic grid into a 1D static array for networking.
      * <br> Converts the logical `std::vector<std::vector<...>>` structure into a continuous
-     * block of memory suitable for packet structs.
+     * block of memory suitable for packet structs, copying whole rows at once.
      * <br> Mapping: `index = y * width + x`
      *
      * @param inputBoard The source logical board containing the 2D vector grid.
@@ -87,39 +90,56 @@ public:
      * @param bufferSize The maximum size of the output buffer to prevent overflows.
      */
     static void serializeBoard(const BoardData &inputBoard, BoardSquare *outputBoard, int bufferSize) {
-        int totalSquares = inputBoard.boardSize * inputBoard.boardSize;
-        int limit = std::min(totalSquares, bufferSize);
-
-        for (int y = 0; y < inputBoard.boardSize; ++y) {
-            for (int x = 0; x < inputBoard.boardSize; ++x) {
-                int flatIndex = y * inputBoard.boardSize + x;
+        const int width = inputBoard.boardSize;
+        const int limit = std::min(width * width, bufferSize);
 
-                if (flatIndex >= limit) return;
+        for (int y = 0; y < width; ++y) {
+            const int rowStart = y * width;
+            if (rowStart >= limit) return;
 
-                outputBoard[flatIndex] = inputBoard.getSquareAt(x, y);
-            }
+            std::copy_n(inputBoard.grid[y].begin(), std::min(width, limit - rowStart), outputBoard + rowStart);
         }
     }
 
     /**
      * @brief Reconstructs the 2D grid from a received 1D network array.
-     * <br> Reverses the serialization process, mapping the linear index back to X/Y coordinates
-     * and updating the local `BoardData` state.
+     * <br> Reverses the serialization process, copying whole rows back into the local `BoardData` state.
      * <br> Mapping: `x = index % width`, `y = index / width`
      *
      * @param inputBoard Pointer to the source flat array from a received Packet.
      * @param outputBoard Reference to the local BoardData to update.
      */
     static void deserializeBoard(const BoardSquare *inputBoard, BoardData &outputBoard) {
-        int totalSquares = outputBoard.boardSize * outputBoard.boardSize;
-
-        for (int i = 0; i < totalSquares; ++i) {
-            int x = i % outputBoard.boardSize;
-            int y = i / outputBoard.boardSize;
+        const int width = outputBoard.boardSize;
 
-            outputBoard.setSquareAt(x, y, inputBoard[i]);
+        for (int y = 0; y < width; ++y) {
+            std::copy_n(inputBoard + y * width, width, outputBoard.grid.at(y).begin());
         }
     }
+
+    /**
+     * @brief Encodes the board as a compact `BoardSnapshot` for the snapshot packets.
+     *
+     * @param inputBoard The source logical board containing the 2D vector grid.
+     * @param outputSnapshot Destination buffer, `MAX_BOARD_SNAPSHOT_SIZE` bytes always suffice.
+     * @param bufferSize The size of the destination buffer.
+     * @return The encoded size in bytes, 0 if the buffer was too small.
+     */
+    static uint16_t serializeBoard(const BoardData &inputBoard, uint8_t *outputSnapshot, const size_t bufferSize) {
+        return static_cast<uint16_t>(BoardSnapshot::encode(inputBoard, outputSnapshot, bufferSize));
+    }
+
+    /**
+     * @brief Decodes a received `BoardSnapshot` into the local board.
+     *
+     * @param inputSnapshot The encoded snapshot from a received Packet.
+     * @param snapshotSize The size of the encoded snapshot.
+     * @param outputBoard Reference to the local BoardData to update, its grid must match `boardSize`.
+     * @return False if the snapshot is malformed.
+     */
+    static bool deserializeBoard(const uint8_t *inputSnapshot, const size_t snapshotSize, BoardData &outputBoard) {
+        return BoardSnapshot::decode(inputSnapshot, snapshotSize, outputBoard);
+    }
 };
 
 #endif //TICTACTOEOVERLAN_UTILS_H
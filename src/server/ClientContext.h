@@ -2,13 +2,18 @@
 #define TICTACTOEOVERLAN_CLIENTCONTEXT_H
 
 #include <cstdint>
+#include <memory>
 #include <vector>
-#include <winsock2.h>
 
 #include "../common/GameDefinitions.h"
+#include "../common/LatencyHistogram.h"
 #include "../common/NetworkProtocol.h"
-
-#pragma comment(lib, "Ws2_32.lib")
+#include "LoopbackChannel.h"
+#include "OutboundQueue.h"
+#include "SlotMap.h"
+#include "TimerWheel.h"
+#include "../common/PacketFramer.h"
+#include "../common/SocketLayer.h"
 
 /**
  * @brief Tracks the handshake progress of a client on the Server side.
@@ -20,24 +25,58 @@ enum class ClientSetupPhase {
     SET_UP
 };
 
+/**
+ * @brief A client's place in its shard's `SlotMap`, only meaningful on that shard.
+ */
+using ClientHandle = SlotHandle;
+
+/**
+ * @brief The cold part of a `ClientContext`: player data only needed on joins, game ends and heartbeats.
+ * <br> Kept out of line, so the fields the shard touches every tick stay small and densely packed.
+ */
+struct ClientProfile {
+    int32_t playerToken = 0;
+    PieceType pieceType = PieceType::EMPTY;
+    char playerName[MAX_PLAYER_NAME_LENGTH] = {};
+    int32_t playerWins = 0;
+    bool isHost = false;
+    LatencyHistogram roundTripTimes;
+};
+
 /**
  * @brief Represents a connected client within the InternalGameServer.
- * <br> Holds the raw socket, buffering for network streams, and player-specific metadata.
+ * <br> Holds the raw socket, buffering for network streams, and the connection state read every tick.
+ * The player-specific metadata lives in its `profile`.
  * <br> Unlike the `Player` struct, this struct manages the connection lifecycle and server-specific state.
+ * <br> Move only, it is handed between shards as a whole.
  */
 struct ClientContext {
-    SOCKET socket;
+    SOCKET socket; //The channel's synthetic handle for a loopback client
+    ClientHandle handle; //Set by the shard that currently holds the client
+    std::shared_ptr<LoopbackChannel> loopback; //Set if the client is connected in-process instead of over TCP
+    std::unique_ptr<ClientProfile> profile = std::make_unique<ClientProfile>();
     uint8_t playerId;
-    mutable int32_t playerToken;
-    mutable PieceType pieceType;
-    mutable char playerName[MAX_PLAYER_NAME_LENGTH];
-    mutable int32_t playerWins;
-    mutable bool isHost;
-    mutable bool myTurn;
+    mutable bool myTurn = false;
 
     mutable ClientSetupPhase setupPhase;
+    mutable TimerId handshakeTimer = TimerWheel::NO_TIMER; //Drops the client if the handshake takes too long
+    mutable uint64_t handshakeDeadlineMs = 0; //Monotonic, the timer is scheduled for it again on every shard
+
+    // Heartbeat, see `ServerShard::sendHeartbeat`
+    mutable TimerId heartbeatTimer = TimerWheel::NO_TIMER;
+    mutable uint64_t nextHeartbeatAtMs = 0; //Monotonic, the next PING is due then on whichever shard holds the client
+    mutable uint64_t lastPongAtMs = 0; //Last sign of life, 0 until a shard adopted the client
+    mutable uint32_t pingSequence = 0;
+
+    // Set once the SETUP_REQ handshake placed the client in a room
+    mutable bool inRoom = false;
+    mutable uint32_t roomId = 0;
 
-    mutable std::vector<char> receiveBuffer {};
+    mutable PacketFramer receiveBuffer {};
+    mutable OutboundQueue sendQueue {}; //Frames queued this tick, or what the socket couldn't take yet
+    mutable bool flushScheduled = false; //Already listed for the end-of-tick flush
+    mutable bool waitingForWrite = false; //Registered for write readiness because the socket was full
+    mutable bool disconnectPending = false; //Set when sending failed or the client fell too far behind
 
     mutable bool markedForDeletion = false;
 };
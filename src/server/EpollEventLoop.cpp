@@ -0,0 +1,92 @@
+#include "EpollEventLoop.h"
+
+#ifdef __linux__
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+EpollEventLoop::EpollEventLoop() : events{} {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (epollFd == -1 || wakeupFd == -1) {
+        LOG_ERROR(SERVER, ANSI_RED "[EpollEventLoop] Failed to create the epoll instance!\n" ANSI_RESET);
+        return;
+    }
+
+    epoll_event wakeupEvent{};
+    wakeupEvent.events = EPOLLIN;
+    wakeupEvent.data.fd = wakeupFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeupFd, &wakeupEvent);
+}
+
+EpollEventLoop::~EpollEventLoop() {
+    if (wakeupFd != -1) close(wakeupFd);
+    if (epollFd != -1) close(epollFd);
+}
+
+bool EpollEventLoop::add(const SOCKET socket, const uint8_t events) {
+    epoll_event event{};
+    event.events = toEpollEvents(events);
+    event.data.fd = socket;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+bool EpollEventLoop::modify(const SOCKET socket, const uint8_t events) {
+    epoll_event event{};
+    event.events = toEpollEvents(events);
+    event.data.fd = socket;
+    return epoll_ctl(epollFd, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+void EpollEventLoop::remove(const SOCKET socket) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, nullptr);
+}
+
+int EpollEventLoop::wait(std::vector<ReadyEvent> &outEvents, const int timeoutMs) {
+    outEvents.clear();
+
+    const int eventCount = epoll_wait(epollFd, events, MAX_EVENTS_PER_WAIT, timeoutMs);
+    if (eventCount <= 0) {
+        return eventCount;
+    }
+
+    for (int i = 0; i < eventCount; ++i) {
+        if (events[i].data.fd == wakeupFd) {
+            uint64_t counter;
+            read(wakeupFd, &counter, sizeof(counter));
+            continue;
+        }
+
+        uint8_t ready = IoEvent::NONE;
+        // Errors and hang-ups are reported as readable, the following recv returns the actual condition
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) ready |= IoEvent::READ;
+        if (events[i].events & EPOLLOUT) ready |= IoEvent::WRITE;
+
+        outEvents.push_back({events[i].data.fd, ready});
+    }
+
+    return static_cast<int>(outEvents.size());
+}
+
+void EpollEventLoop::wakeup() {
+    constexpr uint64_t one = 1;
+    write(wakeupFd, &one, sizeof(one));
+}
+
+int EpollEventLoop::idleTimeoutMs() const {
+    return -1;
+}
+
+uint32_t EpollEventLoop::toEpollEvents(const uint8_t events) {
+    uint32_t epollEvents = 0;
+    if (events & IoEvent::READ) epollEvents |= EPOLLIN;
+    if (events & IoEvent::WRITE) epollEvents |= EPOLLOUT;
+    return epollEvents;
+}
+
+#endif //__linux__
@@ -0,0 +1,49 @@
+#ifndef TICTACTOEOVERLAN_EPOLLEVENTLOOP_H
+#define TICTACTOEOVERLAN_EPOLLEVENTLOOP_H
+
+#ifdef __linux__
+
+#include <vector>
+#include <sys/epoll.h>
+
+#include "EventLoop.h"
+
+/**
+ * @brief Linux `EventLoop` backed by epoll.
+ * <br> The kernel keeps the interest list, so `wait` only costs time proportional to the number of ready sockets.
+ * <br> An eventfd is registered alongside the sockets so `wakeup` can interrupt an indefinite wait.
+ */
+class EpollEventLoop final : public EventLoop {
+    constexpr static int MAX_EVENTS_PER_WAIT = 256;
+
+    int epollFd;
+    int wakeupFd;
+    epoll_event events[MAX_EVENTS_PER_WAIT];
+
+public:
+    EpollEventLoop();
+
+    ~EpollEventLoop() override;
+
+    bool add(SOCKET socket, uint8_t events) override;
+
+    bool modify(SOCKET socket, uint8_t events) override;
+
+    void remove(SOCKET socket) override;
+
+    int wait(std::vector<ReadyEvent> &outEvents, int timeoutMs) override;
+
+    void wakeup() override;
+
+    int idleTimeoutMs() const override;
+
+private:
+    /**
+     * @brief Translates `IoEvent` flags into the epoll event mask.
+     */
+    static uint32_t toEpollEvents(uint8_t events);
+};
+
+#endif //__linux__
+
+#endif //TICTACTOEOVERLAN_EPOLLEVENTLOOP_H
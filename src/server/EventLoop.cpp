@@ -0,0 +1,78 @@
+#include "EventLoop.h"
+
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
+
+#include "EpollEventLoop.h"
+#include "IoUringEventLoop.h"
+#include "SelectEventLoop.h"
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+void EventLoop::detach(const SOCKET socket, std::vector<char> &, std::vector<char> &) {
+    this->remove(socket);
+}
+
+bool EventLoop::canDetach(SOCKET) const {
+    return true;
+}
+
+int EventLoop::receive(const SOCKET socket, char *buffer, const int length) {
+    const int received = recv(socket, buffer, length, 0);
+    if (received == SOCKET_ERROR && SocketLayer::lastErrorWouldBlock()) {
+        return WOULD_BLOCK;
+    }
+    return received;
+}
+
+int EventLoop::send(const SOCKET socket, const IoSlice *slices, const size_t count) {
+#ifdef _WIN32
+    WSABUF buffers[MAX_SEND_SLICES];
+    for (size_t i = 0; i < count; ++i) {
+        buffers[i].buf = const_cast<char *>(slices[i].data);
+        buffers[i].len = static_cast<ULONG>(slices[i].length);
+    }
+
+    DWORD sent = 0;
+    if (WSASend(socket, buffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) == SOCKET_ERROR) {
+        return SocketLayer::lastErrorWouldBlock() ? 0 : -1;
+    }
+    return static_cast<int>(sent);
+#else
+    iovec buffers[MAX_SEND_SLICES];
+    for (size_t i = 0; i < count; ++i) {
+        buffers[i].iov_base = const_cast<char *>(slices[i].data);
+        buffers[i].iov_len = slices[i].length;
+    }
+
+    msghdr message{};
+    message.msg_iov = buffers;
+    message.msg_iovlen = count;
+
+    const ssize_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    if (sent == SOCKET_ERROR) {
+        return SocketLayer::lastErrorWouldBlock() ? 0 : -1;
+    }
+    return static_cast<int>(sent);
+#endif
+}
+
+void EventLoop::flush() {
+}
+
+std::unique_ptr<EventLoop> EventLoop::createDefault() {
+#if defined(__linux__) && defined(TICTACTOE_IO_URING)
+    if (auto ioUring = std::make_unique<IoUringEventLoop>(); ioUring->isValid()) {
+        return ioUring;
+    }
+    LOG_WARN(SERVER, ANSI_RED "[EventLoop] io_uring is unavailable, falling back to epoll.\n" ANSI_RESET);
+#endif
+
+#ifdef __linux__
+    return std::make_unique<EpollEventLoop>();
+#else
+    return std::make_unique<SelectEventLoop>();
+#endif
+}
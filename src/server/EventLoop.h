@@ -0,0 +1,167 @@
+#ifndef TICTACTOEOVERLAN_EVENTLOOP_H
+#define TICTACTOEOVERLAN_EVENTLOOP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../common/SocketLayer.h"
+
+/**
+ * @brief Bit flags describing which kind of readiness a socket is interested in, or has reported.
+ */
+namespace IoEvent {
+    constexpr static uint8_t NONE = 0;
+    constexpr static uint8_t READ = 1 << 0;
+    constexpr static uint8_t WRITE = 1 << 1;
+}
+
+/**
+ * @brief A single readiness notification returned from `EventLoop::wait`.
+ */
+struct ReadyEvent {
+    SOCKET socket;
+    uint8_t events;
+};
+
+/**
+ * @brief A fully encoded packet (Header + Payload), immutable once created.
+ * <br> A broadcast encodes its packet once and every recipient's queue holds a reference to the same frame.
+ */
+using SharedFrame = std::shared_ptr<const std::vector<char>>;
+
+/**
+ * @brief A contiguous run of bytes, one element of a gathered write.
+ */
+struct IoSlice {
+    const char *data;
+    size_t length;
+    const SharedFrame *frame; //The frame the bytes are part of, backends that send later keep a reference to it
+};
+
+/**
+ * @brief Interface for the socket readiness backend used by the InternalGameServer.
+ * <br> Sockets are registered once and stay registered until removed, so the server
+ * no longer rebuilds its watch set on every tick.
+ * <br> The loop also carries the socket I/O itself, readiness based backends simply call `recv` and `send`.
+ * <br> Implementations: `SelectEventLoop` (portable, capped at FD_SETSIZE), `EpollEventLoop` (Linux)
+ * and `IoUringEventLoop` (Linux, opt-in with the `TICTACTOE_IO_URING` CMake option).
+ */
+class EventLoop {
+public:
+    constexpr static int WOULD_BLOCK = -2; //Returned by `receive` when the socket has nothing to read right now
+    constexpr static size_t MAX_SEND_SLICES = 64;
+
+    EventLoop() = default;
+
+    virtual ~EventLoop() = default;
+
+    /**
+     * @brief Starts watching a socket.
+     *
+     * @param socket The socket to watch.
+     * @param events A combination of `IoEvent` flags.
+     * @return True if the socket was registered.
+     */
+    virtual bool add(SOCKET socket, uint8_t events) = 0;
+
+    /**
+     * @brief Changes the set of events a registered socket is watched for.
+     *
+     * @param socket The already registered socket.
+     * @param events A combination of `IoEvent` flags.
+     * @return True if the registration was updated.
+     */
+    virtual bool modify(SOCKET socket, uint8_t events) = 0;
+
+    /**
+     * @brief Stops watching a socket. Must be called before the socket is closed.
+     *
+     * @param socket The socket to remove.
+     */
+    virtual void remove(SOCKET socket) = 0;
+
+    /**
+     * @brief Stops watching a socket that moves to another event loop, without losing data.
+     * <br> Readiness based backends leave unread data in the kernel and never hold sends back,
+     * completion based ones hand both over here. Never blocks.
+     *
+     * @param socket The socket to detach.
+     * @param outUnread Receives the bytes the backend already read from the socket but nobody consumed yet.
+     * @param outUnsent Receives the bytes `send` accepted but the backend didn't get out yet,
+     * the new owner has to send them before anything else.
+     */
+    virtual void detach(SOCKET socket, std::vector<char> &outUnread, std::vector<char> &outUnsent);
+
+    /**
+     * @brief Tells whether `detach` could hand the socket over right now without closing it.
+     * <br> Readiness based backends can always. Completion based ones can't while the kernel still owns a send,
+     * or while they hold received data the caller had no room for.
+     *
+     * @param socket The registered socket.
+     * @return False if detaching now would have to end the connection.
+     */
+    virtual bool canDetach(SOCKET socket) const;
+
+    /**
+     * @brief Reads data from a socket reported as readable.
+     *
+     * @param socket The ready socket.
+     * @param buffer Destination buffer.
+     * @param length Size of the destination buffer.
+     * @return The number of bytes read, 0 if the peer closed the connection, `WOULD_BLOCK` if there is nothing
+     * to read yet, -1 on error.
+     */
+    virtual int receive(SOCKET socket, char *buffer, int length);
+
+    /**
+     * @brief Sends as much of the slices, in order, as the socket takes without blocking.
+     * <br> Readiness based backends gather them into a single `WSASend`/`sendmsg` call.
+     * Backends are free to hold accepted data until the next `flush` or `wait`, the order per socket is kept.
+     * <br> Once a send took less than offered, watch the socket for `IoEvent::WRITE` before sending again.
+     *
+     * @param socket The target (non-blocking) socket.
+     * @param slices The bytes to send.
+     * @param count The number of slices, at most `MAX_SEND_SLICES`.
+     * @return The number of bytes accepted, 0 if the socket can't take any right now, -1 on error.
+     */
+    virtual int send(SOCKET socket, const IoSlice *slices, size_t count);
+
+    /**
+     * @brief Hands all queued sends to the kernel. Called at the end of every tick.
+     */
+    virtual void flush();
+
+    /**
+     * @brief Blocks until at least one registered socket is ready, the timeout expires or `wakeup` is called.
+     *
+     * @param outEvents Cleared and filled with the ready sockets.
+     * @param timeoutMs Maximum time to wait in milliseconds, -1 waits indefinitely.
+     * @return The number of ready sockets, or -1 on error.
+     */
+    virtual int wait(std::vector<ReadyEvent> &outEvents, int timeoutMs) = 0;
+
+    /**
+     * @brief Interrupts a blocking `wait` from another thread.
+     * <br> Backends that can't be woken up report it through `idleTimeoutMs` and get polled instead.
+     */
+    virtual void wakeup() = 0;
+
+    /**
+     * @brief The longest time the server should block in `wait` when it has nothing else to do.
+     *
+     * @return The timeout in milliseconds, -1 if the backend is fully woken by `wakeup`.
+     */
+    virtual int idleTimeoutMs() const = 0;
+
+    /**
+     * @brief Creates the best backend available on the current platform.
+     *
+     * @return io_uring on Linux when enabled and supported by the kernel, epoll on other Linux builds,
+     * select everywhere else.
+     */
+    static std::unique_ptr<EventLoop> createDefault();
+};
+
+#endif //TICTACTOEOVERLAN_EVENTLOOP_H
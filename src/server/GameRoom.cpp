@@ -0,0 +1,96 @@
+#include "GameRoom.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../common/Utils.h"
+
+GameRoom::GameRoom(const uint32_t roomId) : roomId(roomId), boardData({{}, 3, 3, 1, 1, 0}) {
+    Utils::initializeGameBoard(boardData);
+    memberByPlayerId.fill(INVALID_SOCKET);
+    availablePieces = {
+        PieceType::HEXAGON,
+        PieceType::OCTAGON,
+        PieceType::SQUARE,
+        PieceType::TRIANGLE,
+        PieceType::CIRCLE,
+        PieceType::CROSS
+    };
+}
+
+void GameRoom::addMember(const SOCKET socket, const uint8_t playerId) {
+    members.push_back(socket);
+    memberByPlayerId[playerId] = socket;
+}
+
+void GameRoom::removeMember(const SOCKET socket, const uint8_t playerId) {
+    std::erase(members, socket);
+    if (memberByPlayerId[playerId] == socket) {
+        memberByPlayerId[playerId] = INVALID_SOCKET;
+    }
+}
+
+SOCKET GameRoom::findMember(const uint8_t playerId) const {
+    return memberByPlayerId[playerId];
+}
+
+bool GameRoom::hasFreeSlot() const {
+    return !availablePieces.empty();
+}
+
+uint8_t GameRoom::freePlayerId() const {
+    for (size_t playerId = 1; playerId < memberByPlayerId.size(); ++playerId) {
+        const bool taken = memberByPlayerId[playerId] != INVALID_SOCKET
+                           || std::ranges::any_of(reservedSeats, [playerId](const ReservedSeat &seat) {
+                               return seat.playerId == playerId;
+                           });
+        if (!taken) {
+            return static_cast<uint8_t>(playerId);
+        }
+    }
+    return 0;
+}
+
+PieceType GameRoom::takeFirstAvailablePiece() {
+    const PieceType piece = availablePieces.back();
+    availablePieces.pop_back();
+    return piece;
+}
+
+bool GameRoom::claimReservedSeat(const char *playerName, const int32_t playerToken, ReservedSeat &outSeat) {
+    // The name alone is no proof, anybody can pick it
+    const auto it = std::ranges::find_if(reservedSeats, [playerName, playerToken](const ReservedSeat &seat) {
+        return seat.playerToken == playerToken
+               && std::strncmp(seat.playerName, playerName, MAX_PLAYER_NAME_LENGTH) == 0;
+    });
+    if (it == reservedSeats.end()) {
+        return false;
+    }
+
+    outSeat = *it;
+    reservedSeats.erase(it);
+    return true;
+}
+
+uint8_t GameRoom::seatInTurnOrder(const size_t index) const {
+    const size_t seatCount = members.size() + reservedSeats.size();
+    if (seatCount == 0) {
+        return 0;
+    }
+
+    size_t remaining = index % seatCount;
+    for (size_t playerId = 1; playerId < memberByPlayerId.size(); ++playerId) {
+        const bool seated = memberByPlayerId[playerId] != INVALID_SOCKET
+                            || std::ranges::any_of(reservedSeats, [playerId](const ReservedSeat &seat) {
+                                return seat.playerId == playerId;
+                            });
+        if (seated && remaining-- == 0) {
+            return static_cast<uint8_t>(playerId);
+        }
+    }
+    return 0;
+}
+
+bool GameRoom::isEmpty() const {
+    return members.empty() && reservedSeats.empty();
+}
@@ -0,0 +1,125 @@
+#ifndef TICTACTOEOVERLAN_GAMEROOM_H
+#define TICTACTOEOVERLAN_GAMEROOM_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "../common/GameDefinitions.h"
+#include "../common/NetworkProtocol.h"
+#include "../common/SocketLayer.h"
+
+constexpr static uint32_t DEFAULT_ROOM_ID = 0;
+
+/**
+ * @brief A seat recovered from the move journal whose player hasn't reconnected yet.
+ * <br> Its piece stays taken, the client that held it gets the seat back with its ID, piece and wins. That client
+ * is recognized by its name together with the auth token the server derived from its `initialToken`.
+ */
+struct ReservedSeat {
+    uint8_t playerId;
+    PieceType piece;
+    bool isHost;
+    int32_t wins;
+    int32_t playerToken; //The seat's `ClientProfile::playerToken`
+    char playerName[MAX_PLAYER_NAME_LENGTH];
+};
+
+/**
+ * @brief A single match hosted by the InternalGameServer.
+ * <br> Owns everything that used to be global to the server: the board, the roster, the piece pool and the move history.
+ * <br> Player IDs are scoped to the room, a joining player gets the lowest one nobody in the room holds, from 1 up.
+ */
+struct GameRoom {
+    uint32_t roomId;
+    // Guarded by the RoomManager, only the owning shard may touch the rest of the room
+    size_t ownerShard = 0;
+    bool inTransit = false;
+
+    // Sockets of the members in join order. Turns go by player ID instead, see `seatInTurnOrder`
+    std::vector<SOCKET> members;
+    std::array<SOCKET, 256> memberByPlayerId; //Indexed by the room scoped player ID, INVALID_SOCKET if unused
+    uint8_t hostingPlayerId = 0;
+    std::vector<PieceType> availablePieces;
+    std::vector<ReservedSeat> reservedSeats; //Only after a crash, players that haven't reconnected yet
+    uint64_t seatsReservedUntilMs = 0; //Monotonic, the seats nobody claimed by then get released
+
+    //Game State
+    BoardData boardData;
+    std::vector<Move> moves;
+    uint32_t moveSequence = 0; //Moves applied since the last GAME_START, numbers MOVE_APPLIED and keyframes
+    bool gameInProgress = false; //Between GAME_START and GAME_END
+    uint64_t gameStartedAtMs = 0; //Unix time of the last GAME_START, stamped on its replay
+
+    /**
+     * @brief Creates an empty room with the default 3x3 board and a full piece pool.
+     *
+     * @param roomId The ID clients use to join this room.
+     */
+    explicit GameRoom(uint32_t roomId);
+
+    /**
+     * @brief Seats a player, its turn comes after the members with lower player IDs.
+     */
+    void addMember(SOCKET socket, uint8_t playerId);
+
+    /**
+     * @brief Removes a player, the remaining members keep their turn order.
+     */
+    void removeMember(SOCKET socket, uint8_t playerId);
+
+    /**
+     * @return The socket of the member with this ID, INVALID_SOCKET if there is none.
+     */
+    SOCKET findMember(uint8_t playerId) const;
+
+    /**
+     * @brief Checks if another player can still join.
+     *
+     * @return True if there is a free piece left in the pool.
+     */
+    bool hasFreeSlot() const;
+
+    /**
+     * @brief Finds the ID for a joining player, IDs of players who left are handed out again.
+     * <br> 0 is never used, it stands for "nobody" (e.g. no host), and neither are IDs held by reserved seats.
+     *
+     * @return The lowest free player ID, 0 if all of them are taken.
+     */
+    uint8_t freePlayerId() const;
+
+    /**
+     * @brief Retrieves and removes the next available piece type from the pool.
+     *
+     * @return The piece type.
+     */
+    PieceType takeFirstAvailablePiece();
+
+    /**
+     * @brief Hands a recovered seat back to the player who had it, removing the reservation.
+     *
+     * @param playerName The name the joining client asked for.
+     * @param playerToken The auth token generated for the joining client.
+     * @param outSeat Receives the seat.
+     * @return False if no seat is reserved for this name and token.
+     */
+    bool claimReservedSeat(const char *playerName, int32_t playerToken, ReservedSeat &outSeat);
+
+    /**
+     * @brief Finds whose turn the n-th turn is.
+     * <br> Turns go around the seats in player ID order, reserved seats included. Unlike the order the players
+     * came back in after a crash, the IDs are restored from the journal, so a recovered game keeps its turn order.
+     *
+     * @param index The turn's index, wraps around the seats.
+     * @return The player ID, 0 if nobody holds a seat.
+     */
+    uint8_t seatInTurnOrder(size_t index) const;
+
+    /**
+     * @return True if nobody is in the room and no seat is kept for a player who might come back.
+     */
+    bool isEmpty() const;
+};
+
+
+#endif //TICTACTOEOVERLAN_GAMEROOM_H
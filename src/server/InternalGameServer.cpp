@@ -1,570 +1,399 @@
 #include "InternalGameServer.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
-#include <ranges>
-#include <thread>
+#include <filesystem>
 
-#include "ServerUtils.h"
-#include "WinValidator.h"
 #include "../common/NetworkProtocol.h"
+#include "../common/Logger.h"
 #include "../common/Utils.h"
 
-void InternalGameServer::start(const int port) {
+bool InternalGameServer::start(const int port, const size_t shardCount) {
     keepRunning = true;
     serverPort = port;
-    nextPlayerId = 1;
-
-    //GameState preparation
-    boardData.boardSize = 3;
-    boardData.winConditionLength = 3;
-    boardData.round = 1;
-    Utils::initializeGameBoard(boardData);
-    availablePieces = {
-        PieceType::HEXAGON,
-        PieceType::OCTAGON,
-        PieceType::SQUARE,
-        PieceType::TRIANGLE,
-        PieceType::CIRCLE,
-        PieceType::CROSS
-    };
+    acceptCursor = 0;
+    clientCount = 0;
 
-    //Socket and network setup
-    WSADATA wsadata;
-    WSAStartup(REQ_SOCK_VERSION, &wsadata);
-
-    listenSocket = socket(AF_INET, SOCK_STREAM, 0);
-    sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(port);
-
-    bind(listenSocket, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr));
-    listen(listenSocket, SOMAXCONN);
+    //GameState preparation, rooms get created with default settings on the first join
+    rooms.clear();
 
-    std::printf(ANSI_GREEN "[InternalServer] Listening on port %d...\n" ANSI_RESET, port);
-
-    while (keepRunning) {
-        //Time measuring
-        const long long startTime = std::chrono::system_clock::now().time_since_epoch().count();
+    //Socket and network setup
+    SocketLayer::startup();
 
-        //Packets and logic
-        fd_set readSet;
-        FD_ZERO(&readSet);
+    const size_t shardTotal = std::max<size_t>(shardCount, 1);
+    if (!this->openListeners(port, shardTotal)) {
+        SocketLayer::cleanup();
+        keepRunning = false;
+        return false;
+    }
 
-        FD_SET(listenSocket, &readSet);
+    //Read the journal only now that the port is ours, a second server on the same port must not touch it
+    JournalRecovery recovery;
+    if (!journalDirectory.empty()) {
+        const auto recoveryStart = std::chrono::steady_clock::now();
+        recovery = MoveJournal::recover(journalDirectory);
+        journalSequence = recovery.lastSequence;
+        journalEpoch = recovery.lastEpoch + 1;
+
+        if (!recovery.rooms.empty()) {
+            const std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - recoveryStart;
+            LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] Recovered %zu room(s) from %zu journal record(s) "
+                     "in %zu segment(s), took %.2f ms.\n" ANSI_RESET, recovery.rooms.size(), recovery.recordCount,
+                     recovery.segmentCount, took.count());
+        }
+    }
 
-        for (const auto &client: clients) {
-            FD_SET(client.socket, &readSet);
+    {
+        std::lock_guard<std::mutex> lock(this->shardsMutex);
+        shards.clear();
+        bool journalOpened = true;
+        for (size_t i = 0; i < shardTotal && journalOpened; ++i) {
+            shards.push_back(std::make_unique<ServerShard>(*this, i));
+            if (!journalDirectory.empty()) journalOpened = shards[i]->openJournal(journalDirectory, journalEpoch);
         }
 
-        timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 10000; //10ms between os polls
+        // Running without the journal we were asked for would lose the games on the next crash
+        if (!journalOpened) {
+            LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Can't journal into %s, not starting.\n" ANSI_RESET,
+                      journalDirectory.c_str());
+            shards.clear();
+            this->closeListeners();
+            SocketLayer::cleanup();
+            keepRunning = false;
+            return false;
+        }
 
-        const int socketCount = select(0, &readSet, nullptr, nullptr, &timeout);
+        // A lone acceptor spreads its connections itself, with one listener per shard the kernel already did
+        const bool spreadConnections = listenSockets.size() == 1;
+        for (size_t i = 0; i < listenSockets.size(); ++i) {
+            shards[i]->setListenSocket(listenSockets[i], spreadConnections);
+        }
+    }
 
-        if (socketCount > 0) {
-            if (FD_ISSET(listenSocket, &readSet)) {
-                this->handleNewConnection();
-            }
+    if (!journalDirectory.empty()) {
+        this->recoverRooms(recovery);
+    }
 
-            for (auto &client: clients) {
-                if (FD_ISSET(client.socket, &readSet)) {
-                    this->handleClientData(client);
-                }
-            }
+    if (!replayDirectory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(replayDirectory, error);
+        if (error) {
+            LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Can't create the replay directory %s, games won't be "
+                     "archived: %s\n" ANSI_RESET, replayDirectory.c_str(), error.message().c_str());
         }
+        replayWriter.start();
+    }
 
-        std::erase_if(
-            clients,
-            [](const ClientContext &c) { return c.markedForDeletion; }
-        );
-
-        //Calculate this based on how much time the processing took, set at 20 TPS initially -> 50ms per loop
-        // std::this_thread::sleep_for(std::chrono_literals::operator ""ms(1000));
-        const long long endTime = std::chrono::system_clock::now().time_since_epoch().count();
-        const long long timeTook = endTime - startTime;
-        lastTickTime = timeTook;
-        avgTickTime.add(timeTook);
-        ++tick;
+    LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] Listening on port %d with %zu shard(s) and %zu acceptor(s)...\n"
+             ANSI_RESET, port, shards.size(), listenSockets.size());
+
+    //The first shard runs on this thread, the rest get their own
+    for (size_t i = 1; i < shards.size(); ++i) {
+        shardThreads.emplace_back(&ServerShard::run, shards[i].get());
     }
+    shards[0]->run();
 
     //Cleanup
-    std::printf(ANSI_CYAN "[InternalServer] Shutting down...\n");
-    closesocket(listenSocket);
-    WSACleanup();
-}
-
-void InternalGameServer::handleNewConnection() {
-    //TODO: reject new connections if a game is already in progress
-    const SOCKET newSocket = accept(listenSocket, nullptr, nullptr);
+    LOG_INFO(SERVER, ANSI_CYAN "[InternalServer] Shutting down...\n");
+    for (auto &thread: shardThreads) {
+        if (thread.joinable()) thread.join();
+    }
+    shardThreads.clear();
 
-    ClientContext newClient;
-    newClient.setupPhase = ClientSetupPhase::NEW_CONNECTION;
-    newClient.socket = newSocket;
-    newClient.playerId = nextPlayerId++;
-    newClient.playerWins = 0;
+    // The last games ended with the shards, their replays are on the disk once this returns
+    replayWriter.stop();
 
-    ServerHelloPacket helloPacket;
-    helloPacket.playerId = newClient.playerId;
+    this->closeListeners();
+    SocketLayer::cleanup();
 
-    sendPacket<ServerHelloPacket>(newClient.socket, PacketType::SERVER_HELLO, helloPacket);
-    newClient.setupPhase = ClientSetupPhase::HELLO_SENT;
+    {
+        std::lock_guard<std::mutex> lock(this->shardsMutex);
+        shards.clear();
+    }
+    rooms.clear();
 
-    clients.push_back(newClient);
+    // A clean stop sent everyone home, there is nothing to recover
+    if (!journalDirectory.empty()) {
+        MoveJournal::removeEpochsBefore(journalDirectory, journalEpoch + 1);
+    }
+    return true;
 }
 
-void InternalGameServer::handleClientData(ClientContext &client) {
-    char buffer[DEFAULT_BUFFER_LEN];
-    const int bytesRead = recv(client.socket, buffer, sizeof(buffer), 0);
-
-    if (bytesRead <= 0) {
-        //Error or 0 means disconnected
-        std::printf(ANSI_RED "[InternalServer] Player with ID %hhu has disconnected.\n" ANSI_RESET, client.playerId);
-        client.markedForDeletion = true;
-        availablePieces.push_back(client.pieceType);
-
-        closesocket(client.socket);
-        client.socket = INVALID_SOCKET;
-
-        PlayerDisconnectedPacket disconnectPacket{};
-        disconnectPacket.playerId = client.playerId;
-        this->broadcastPacket(PacketType::PLAYER_DISCONNECTED, disconnectPacket);
-
-        // Reset the game here back to GAME_ROOM state
-        GameEndPacket endPacket{};
-        endPacket.reason = FinishReason::PLAYER_DISCONNECT;
-        endPacket.playerId = client.playerId;
-        endPacket.player = ServerUtils::clientContextToPlayer(client, 0);
-
-        this->broadcastPacket(PacketType::GAME_END, endPacket);
+void InternalGameServer::stop() {
+    keepRunning = false;
 
-        return;
+    std::lock_guard<std::mutex> lock(this->shardsMutex);
+    for (const auto &shard: shards) {
+        shard->wakeup();
     }
+}
 
-    client.receiveBuffer.insert(client.receiveBuffer.end(), buffer, buffer + bytesRead);
-
-    //Packet parsing
-    while (!client.markedForDeletion) {
-        if (client.receiveBuffer.size() < sizeof(PacketHeader)) {
-            break; //Not enough data, wait for next recv
-        }
-
-        const auto *pendingHeader = reinterpret_cast<PacketHeader *>(client.receiveBuffer.data());
-        const size_t totalPacketSize = sizeof(PacketHeader) + pendingHeader->payloadSize;
+std::shared_ptr<LoopbackChannel> InternalGameServer::connectLoopback() {
+    std::lock_guard<std::mutex> lock(this->shardsMutex);
+    if (!keepRunning || shards.empty()) {
+        return nullptr;
+    }
 
-        if (client.receiveBuffer.size() < totalPacketSize) {
-            break; //Still not enough data for the whole packet, wait for the next recv
-        }
+    auto channel = std::make_shared<LoopbackChannel>();
+    shards[this->nextAcceptShard()]->connectLoopback(channel);
+    return channel;
+}
 
-        // Here we have a valid packet
-        std::vector<char> payload{};
-        payload.clear();
-        if (pendingHeader->payloadSize > 0) {
-            payload.insert(
-                payload.end(),
-                client.receiveBuffer.begin() + sizeof(PacketHeader),
-                client.receiveBuffer.begin() + totalPacketSize);
-        }
+void InternalGameServer::recoverRooms(JournalRecovery &recovery) {
+    // Compacted into the first shard's segment, then the old epochs only repeat what it says
+    const bool compacted = shards[0]->checkpointRooms(recovery.rooms);
 
-        this->processPacket(client, pendingHeader->type, payload);
+    const size_t roomCount = recovery.rooms.size();
+    for (auto &room: recovery.rooms) {
+        const size_t ownerShard = room->roomId % shards.size();
+        shards[ownerShard]->holdReservedSeats(*room);
+        rooms.restore(std::move(room), ownerShard);
+    }
 
-        client.receiveBuffer.erase(client.receiveBuffer.begin(), client.receiveBuffer.begin() + totalPacketSize);
+    if (compacted) {
+        MoveJournal::removeEpochsBefore(journalDirectory, journalEpoch);
+    } else if (roomCount > 0) {
+        LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Couldn't compact the journal, keeping the old segments.\n"
+                 ANSI_RESET);
     }
 }
 
-void InternalGameServer::processPacket(ClientContext &client, const PacketType type, std::vector<char> &payload) {
-    //C2S Packets: SETUP_REQ[x], SETTINGS_CHANGE_REQ[x], MOVE_REQ[x], BACK_TO_GAME_ROOM[x]
-    printf(ANSI_CYAN "[InternalServer] Received packet of type %hhd from client with ID: %hhu\n" ANSI_RESET, type,
-           client.playerId);
-
-    switch (type) {
-        default: {
-            printf(ANSI_RED "[InternalServer] Unknown packet received! Type: %hhd", type);
-            break;
+bool InternalGameServer::openListeners(const int port, const size_t shardCount) {
+    if (shardCount > 1 && SocketLayer::supportsReusePort()) {
+        // Bind once without SO_REUSEPORT first: a second server on the same port must still fail
+        // instead of silently joining our group and taking half of the connections
+        const SOCKET probe = openListener(port, false);
+        if (probe == INVALID_SOCKET) {
+            return false;
         }
+        SocketLayer::close(probe);
 
-        case PacketType::SETUP_REQ: {
-            const auto *packet = reinterpret_cast<SetupReqPacket *>(payload.data());
-
-            this->handleSetupRequestPacket(client, packet);
-
-            break;
-        }
-
-        case PacketType::SETTINGS_CHANGE_REQ: {
-            const auto *packet = reinterpret_cast<SettingsChangeReqPacket *>(payload.data());
-
-            if (this->handleSettingsChangeRequestPacket(packet)) break;
-
-            break;
+        for (size_t i = 0; i < shardCount; ++i) {
+            const SOCKET listener = openListener(port, true);
+            if (listener == INVALID_SOCKET) break;
+            listenSockets.push_back(listener);
         }
 
-        case PacketType::GAME_START_REQ: {
-            const auto *packet = reinterpret_cast<GameStartRequestPacket *>(payload.data());
-
-            if (this->handleGameStartRequestPacket(packet)) break;
-
-            break;
+        if (listenSockets.size() == shardCount) {
+            return true;
         }
 
-        case PacketType::MOVE_REQ: {
-            const auto *packet = reinterpret_cast<MoveRequestPacket *>(payload.data());
-
-            if (this->handleMoveRequestPacket(client, packet)) break;
-
-            break;
-        }
-
-        case PacketType::BACK_TO_GAME_ROOM: {
-            const auto *packet = reinterpret_cast<BackToGameRoomPacket *>(payload.data());
-            printf(ANSI_CYAN "[InternalServer] Got a BACK_TO_GAME_ROOM packet, relaying to all clients.\n" ANSI_RESET);
-
-            // Relay the packet
-            this->broadcastPacket(PacketType::BACK_TO_GAME_ROOM, packet);
-
-            break;
-        }
+        LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Couldn't open a listener per shard, falling back to one.\n"
+                 ANSI_RESET);
+        this->closeListeners();
     }
-}
 
-void InternalGameServer::handleSetupRequestPacket(ClientContext &client, const SetupReqPacket *packet) {
-    client.setupPhase = ClientSetupPhase::SETUP_REQ_RECV;
-    client.isHost = packet->isHost;
-    if (client.isHost) hostingPlayerId = packet->playerId;
-
-    //Respond with a generated token
-    const int clientAuthToken = packet->initialToken / 3;
-    const auto clientPieceType = this->getFirstAvailablePiece();
-    printf(ANSI_CYAN "[InternalServer] Received SETUP_ACK with parameters [%hhu, %s, %d]\n" ANSI_RESET,
-           packet->playerId, packet->playerName, packet->initialToken);
-
-    //Add to playerlist - modify the client context (Or a separate active player list?)
-    client.playerToken = clientAuthToken;
-    client.pieceType = clientPieceType;
-    client.playerWins = 0;
-    memset(client.playerName, 0, MAX_PLAYER_NAME_LENGTH);
-    strncpy(client.playerName, packet->playerName, MAX_PLAYER_NAME_LENGTH - 1);
-
-    SetupAckPacket setupAckPacket{};
-    setupAckPacket.generatedAuthToken = clientAuthToken;
-    setupAckPacket.playerId = packet->playerId;
-    setupAckPacket.boardSize = boardData.boardSize;
-    setupAckPacket.winConditionLength = boardData.winConditionLength;
-    setupAckPacket.round = boardData.round;
-    setupAckPacket.playerCount = 0;
-    for (const auto &playerContext: clients) {
-        if (setupAckPacket.playerCount >= MAX_PLAYERS) {
-            break;
-        }
-        setupAckPacket.players[setupAckPacket.playerCount] =
-                ServerUtils::clientContextToPlayer(playerContext, client.playerId);
-        setupAckPacket.playerCount++;
+    const SOCKET listener = openListener(port, false);
+    if (listener == INVALID_SOCKET) {
+        return false;
     }
-
-    memset(setupAckPacket.playerName, 0, MAX_PLAYER_NAME_LENGTH);
-    strncpy(setupAckPacket.playerName, client.playerName, MAX_PLAYER_NAME_LENGTH - 1);
-    setupAckPacket.pieceType = clientPieceType;
-
-    printf(ANSI_CYAN "[InternalServer] Sending SETUP_ACK packet to client with ID: %d\n" ANSI_RESET,
-           packet->playerId);
-    this->sendPacket(client.socket, PacketType::SETUP_ACK, setupAckPacket);
-
-    // Broadcast new player joined packet
-    NewPlayerJoinPacket newPlayerJoinPacket{};
-    newPlayerJoinPacket.newPlayerId = client.playerId;
-    newPlayerJoinPacket.newPlayerPieceType = clientPieceType;
-    newPlayerJoinPacket.isHost = client.isHost;
-    memset(newPlayerJoinPacket.newPlayerName, 0, MAX_PLAYER_NAME_LENGTH);
-    strncpy(newPlayerJoinPacket.newPlayerName, client.playerName, MAX_PLAYER_NAME_LENGTH - 1);
-
-    this->broadcastPacket(PacketType::NEW_PLAYER_JOIN, newPlayerJoinPacket);
-
-    client.setupPhase = ClientSetupPhase::SET_UP;
+    listenSockets.push_back(listener);
+    return true;
 }
 
-bool InternalGameServer::handleSettingsChangeRequestPacket(const SettingsChangeReqPacket *packet) {
-    printf(
-        ANSI_CYAN
-        "[InternalServer] Received SETTINGS_CHANGE_REQ packet from %hhu with params: [size: %hhu, winCon: %hhu]!\n"
-        ANSI_RESET,
-        packet->playerId, packet->newBoardSize, packet->newWinConditionLength);
-
-    if (packet->playerId != hostingPlayerId) {
-        printf(
-            ANSI_RED
-            "[InternalServer] Somehow got a game settings change request from a client that isn't the host! "
-            "This shouldn't happen! [request: %hhu != host: %hhu]\n" ANSI_RESET,
-            packet->playerId, hostingPlayerId);
-        return true;
-    }
-
-    bool updated = false;
-    // 0 < BoardSize < MAX_BOARD_SIZE
-    if (packet->newBoardSize > 0 && packet->newBoardSize <= MAX_BOARD_SIZE && boardData.boardSize != packet->
-        newBoardSize) {
-        printf(ANSI_GREEN "[InternalServer] BoardSize updated from %hhu to %hhu\n" ANSI_RESET,
-               boardData.boardSize, packet->newBoardSize);
-        boardData.boardSize = packet->newBoardSize;
-        boardData.winConditionLength = std::min(boardData.winConditionLength, boardData.boardSize);
-        updated = true;
-    }
-
-    // 0 < WinConditionLength < BoardSize
-    if (packet->newWinConditionLength > 0 && packet->newWinConditionLength <= boardData.boardSize && boardData.
-        winConditionLength != packet->newWinConditionLength) {
-        printf(ANSI_GREEN "[InternalServer] WinConditionLength updated from %hhu to %hhu\n" ANSI_RESET,
-               boardData.winConditionLength, packet->newWinConditionLength);
-        boardData.winConditionLength = packet->newWinConditionLength;
-        updated = true;
+SOCKET InternalGameServer::openListener(const int port, const bool reusePort) {
+    const SOCKET listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET) {
+        LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Failed to create the listen socket: %d\n" ANSI_RESET,
+                  SocketLayer::lastError());
+        return INVALID_SOCKET;
     }
+    SocketLayer::setReuseAddress(listener);
 
-    //Send update packet if necessary
-    if (updated) {
-        SettingsUpdatePacket settingsUpdatePacket{};
-        settingsUpdatePacket.newBoardSize = boardData.boardSize;
-        settingsUpdatePacket.newWinConditionLength = boardData.winConditionLength;
-
-        printf(ANSI_CYAN "[InternalServer] Broadcasting new board settings!\n" ANSI_RESET);
-        this->broadcastPacket(PacketType::SETTINGS_UPDATE, settingsUpdatePacket);
+    if (reusePort && !SocketLayer::setReusePort(listener)) {
+        LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Failed to enable SO_REUSEPORT: %d\n" ANSI_RESET,
+                  SocketLayer::lastError());
+        SocketLayer::close(listener);
+        return INVALID_SOCKET;
     }
-    return false;
-}
 
-bool InternalGameServer::handleGameStartRequestPacket(const GameStartRequestPacket *packet) {
-    printf(ANSI_CYAN "[InternalServer] Got a%s game start request from player with id %hhu\n" ANSI_RESET,
-           (packet->newGame ? " new" : ""), packet->requestingPlayerId);
+    sockaddr_in serverAddr{};
+    serverAddr.sin_family = AF_INET;
+    serverAddr.sin_addr.s_addr = INADDR_ANY;
+    serverAddr.sin_port = htons(port);
 
-    if (packet->requestingPlayerId != hostingPlayerId) {
-        printf(ANSI_RED "[InternalServer] Somehow got a game start request from a client that isn't the host! "
-               "This shouldn't happen! [request: %hhu != host: %hhu]\n" ANSI_RESET,
-               packet->requestingPlayerId, hostingPlayerId);
-        return true;
+    if (bind(listener, reinterpret_cast<sockaddr *>(&serverAddr), sizeof(serverAddr)) == SOCKET_ERROR
+        || listen(listener, SOMAXCONN) == SOCKET_ERROR) {
+        LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Failed to listen on port %d: %d\n" ANSI_RESET,
+                  port, SocketLayer::lastError());
+        SocketLayer::close(listener);
+        return INVALID_SOCKET;
     }
 
-    Utils::initializeGameBoard(boardData);
-    boardData.turn = 1;
-    boardData.actingPlayerId = this->getNextActingPlayerId();
-    moves.clear();
+    //The accept loop drains the backlog until it would block
+    SocketLayer::setNonBlocking(listener);
+    return listener;
+}
 
-    if (packet->newGame) {
-        for (auto &ctx: clients) {
-            ctx.playerWins = 0;
-        }
+void InternalGameServer::closeListeners() {
+    for (const SOCKET listener: listenSockets) {
+        SocketLayer::close(listener);
     }
+    listenSockets.clear();
+}
 
-    GameStartPacket gameStartPacket{};
-    gameStartPacket.requestedByPlayerId = hostingPlayerId;
-    gameStartPacket.finalBoardSize = boardData.boardSize;
-    gameStartPacket.finalWinConditionLength = boardData.winConditionLength;
-    gameStartPacket.round = boardData.round;
-    gameStartPacket.turn = boardData.turn;
-    gameStartPacket.startingPlayerId = boardData.actingPlayerId;
-    gameStartPacket.playerCount = clients.size(); //To confirm we have synced the players on both sides
-    Utils::serializeBoard(boardData, gameStartPacket.grid, TOTAL_BOARD_AREA);
-
-    printf(ANSI_GREEN "[InternalServer] Sending out game start packets! [Starting playerID: %hhu]\n" ANSI_RESET,
-           gameStartPacket.startingPlayerId);
-    this->broadcastPacket(PacketType::GAME_START, gameStartPacket);
-    return false;
+size_t InternalGameServer::nextAcceptShard() {
+    return acceptCursor++ % shards.size();
 }
 
-bool InternalGameServer::handleMoveRequestPacket(ClientContext &client, const MoveRequestPacket *packet) {
-    printf(ANSI_CYAN "[InternalServer] Received a MOVE_REQ packet from player with ID: %hhu\n" ANSI_RESET,
-           packet->playerId);
-    if (packet->playerId != boardData.actingPlayerId) {
-        printf(
-            ANSI_RED
-            "[InternalServer] Somehow got a move request from a player whose ID doesnt match the current acting players! [req: %hhu != currActing: %hhu]\n"
-            ANSI_RESET,
-            packet->playerId, boardData.actingPlayerId);
-        return true;
-    }
+ServerShard &InternalGameServer::getShard(const size_t shardIndex) const {
+    return *shards[shardIndex];
+}
 
-    if (packet->turn != boardData.turn) {
-        printf(
-            ANSI_RED "[InternalServer] Turn mismatch! Possible desync! Sending BoardStateUpdate to fix.\n"
-            ANSI_RESET);
-        //TODO: send boardstate update
-        return true;
-    }
+void InternalGameServer::stealFor(const size_t thiefIndex) {
+    ServerShard *victim = nullptr;
+    size_t victimLoad = 1; //A shard has to have at least two runnable rooms to give one away
 
-    if (boardData.getSquareAt(packet->x, packet->y).piece != PieceType::EMPTY) {
-        printf(
-            ANSI_YELLOW
-            "[InternalServer] Player with id %hhu tried placing a piece on an already used square! [x:%hhu, y:%hhu]\n"
-            ANSI_RESET,
-            packet->playerId, packet->x, packet->y);
-        return true;
-    }
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (i == thiefIndex) continue;
 
-    BoardSquare square{};
-    square.playerId = packet->playerId;
-    square.turnPlaced = boardData.turn;
-    square.piece = packet->piece;
-    boardData.setSquareAt(packet->x, packet->y, square);
-
-    //For the move history
-    Move move(packet->piece, packet->playerId, boardData.turn, packet->x, packet->y);
-    moves.push_back(std::move(move));
-
-    //Update the board state
-    boardData.turn += 1;
-    boardData.actingPlayerId = this->getNextActingPlayerId();
-
-    // Broadcast the updated state
-    BoardStateUpdatePacket boardUpdate{};
-    Utils::serializeBoard(boardData, boardUpdate.grid, TOTAL_BOARD_AREA);
-    boardUpdate.boardSize = boardData.boardSize;
-    boardUpdate.winConditionLength = boardData.winConditionLength;
-    boardUpdate.round = boardData.round;
-    boardUpdate.turn = boardData.turn;
-    boardUpdate.actingPlayerId = boardData.actingPlayerId;
-    boardUpdate.lastMove = move;
-    boardUpdate.playerCount = 0;
-    for (auto &playerContext: clients) {
-        if (boardUpdate.playerCount >= MAX_PLAYERS) {
-            break;
+        const size_t load = shards[i]->getRunnableRoomCount();
+        if (load > victimLoad) {
+            victim = shards[i].get();
+            victimLoad = load;
         }
-
-        playerContext.myTurn = playerContext.playerId == boardData.actingPlayerId;
-
-        boardUpdate.players[boardUpdate.playerCount] =
-                ServerUtils::clientContextToPlayer(playerContext, client.playerId);
-        boardUpdate.playerCount++;
     }
 
-    printf(ANSI_CYAN "[InternalServer] Broadcasting board state update packets!\n" ANSI_RESET);
-    this->broadcastPacket(PacketType::BOARD_STATE_UPDATE, boardUpdate);
-
-
-    bool gameFinished = WinValidator::checkWin(boardData, packet->x, packet->y);
-    if (gameFinished) {
-        printf(ANSI_GREEN "[InternalServer] Player with ID %hhu won the round!\n" ANSI_RESET, packet->playerId);
-        ClientContext *winningClient;
-        for (auto &ctx: clients) {
-            if (ctx.playerId == packet->playerId) {
-                ctx.playerWins += 1;
-                winningClient = &ctx;
-                break;
-            }
-        }
-        boardData.round += 1;
-
-        //Broadcast game finish
-        GameEndPacket gameEndPacket{};
-        gameEndPacket.reason = FinishReason::PLAYER_WIN;
-        gameEndPacket.playerId = packet->playerId;
-        gameEndPacket.player = ServerUtils::clientContextToPlayer(*winningClient, 0);
-
-        this->broadcastPacket(PacketType::GAME_END, gameEndPacket);
+    if (victim != nullptr && victim->requestSteal(static_cast<int>(thiefIndex))) {
+        victim->wakeup();
     }
-    return false;
 }
 
-template<typename T>
-void InternalGameServer::broadcastPacket(const PacketType type, const T &data) {
-    for (const auto &client: clients) {
-        if (client.markedForDeletion) continue;
-        this->sendPacket(client.socket, type, data);
+void InternalGameServer::wakeIdleShard(const size_t busyIndex) {
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (i != busyIndex && shards[i]->isIdle()) {
+            shards[i]->wakeup();
+            return;
+        }
     }
 }
 
-template<typename T>
-void InternalGameServer::sendPacket(const SOCKET sock, const PacketType type, const T &data) {
-    std::vector<char> buffer;
-    buffer.reserve(sizeof(PacketHeader) + sizeof(T));
-
-    PacketHeader header{};
-    header.type = type;
-    header.payloadSize = sizeof(T);
-
-    const auto headerPtr = reinterpret_cast<const char *>(&header);
-    buffer.insert(buffer.end(), headerPtr, headerPtr + sizeof(header));
+void InternalGameServer::setOutboundHighWaterMark(const size_t bytes) {
+    outboundHighWaterMark = bytes;
+}
 
-    const auto dataPtr = reinterpret_cast<const char *>(&data);
-    buffer.insert(buffer.end(), dataPtr, dataPtr + sizeof(T));
+size_t InternalGameServer::getOutboundHighWaterMark() const {
+    return outboundHighWaterMark;
+}
 
-    int totalSent = 0;
-    int bytesLeft = static_cast<int>(buffer.size());
+void InternalGameServer::setMaxClients(const size_t count) {
+    maxClients = count;
+}
 
-    while (totalSent < buffer.size()) {
-        const int sent = send(sock, buffer.data() + totalSent, bytesLeft, 0);
+size_t InternalGameServer::getMaxClients() const {
+    return maxClients;
+}
 
-        if (sent == -1) {
-            // Error handling (connection lost?)
-            printf(ANSI_RED "[InternalServer] Error sending data!\n" ANSI_RESET);
-            return;
-        }
+void InternalGameServer::setJournalDirectory(const std::string &directory) {
+    journalDirectory = directory;
+}
 
-        totalSent += sent;
-        bytesLeft -= sent;
-    }
+void InternalGameServer::setReplayDirectory(const std::string &directory) {
+    replayDirectory = directory;
 }
 
-PieceType InternalGameServer::getFirstAvailablePiece() {
-    const PieceType piece = availablePieces.back();
-    availablePieces.pop_back();
-    return piece;
+size_t InternalGameServer::getClientCount() const {
+    return clientCount;
 }
 
-uint8_t InternalGameServer::getNextActingPlayerId() const {
-    return clients[(boardData.round + boardData.turn) % clients.size()].playerId;
+bool InternalGameServer::acquireClientSlot() {
+    const size_t limit = maxClients;
+    if (clientCount.fetch_add(1) < limit || limit == 0) {
+        return true;
+    }
+    --clientCount;
+    return false;
 }
 
-void InternalGameServer::stop() {
-    keepRunning = false;
-    nextPlayerId = 1;
+void InternalGameServer::releaseClientSlot() {
+    --clientCount;
 }
 
 long long InternalGameServer::getTick() {
-    return tick;
+    long long total = 0;
+    for (const auto &telemetry: this->getShardTelemetry()) {
+        total += telemetry.tick;
+    }
+    return total;
 }
 
 long long InternalGameServer::getLastTickTime() {
-    return lastTickTime;
+    long long longest = 0;
+    for (const auto &telemetry: this->getShardTelemetry()) {
+        longest = std::max(longest, telemetry.lastTickTime);
+    }
+    return longest;
 }
 
-double InternalGameServer::getAvgTickTime() {
-    return avgTickTime.average();
-}
+PackagedValues InternalGameServer::getTickTimes() {
+    const auto telemetry = this->getShardTelemetry();
+    if (telemetry.empty()) {
+        return {};
+    }
 
-int InternalGameServer::getServerPort() const {
-    return serverPort;
+    PackagedValues combined = telemetry.front().tickTimes;
+    double averageSum = 0;
+    for (const auto &shard: telemetry) {
+        const PackagedValues &times = shard.tickTimes;
+        averageSum += times.average;
+        combined.min = std::min(combined.min, times.min);
+        combined.max = std::max(combined.max, times.max);
+        combined.p50 = std::max(combined.p50, times.p50);
+        combined.p99 = std::max(combined.p99, times.p99);
+        combined.p999 = std::max(combined.p999, times.p999);
+    }
+    combined.average = averageSum / static_cast<double>(telemetry.size());
+    return combined;
 }
 
-uint16_t InternalGameServer::getCurrentTurn() const {
-    return boardData.turn;
+LatencyHistogram InternalGameServer::getRoundTripTimes() {
+    LatencyHistogram merged;
+    for (const auto &telemetry: this->getShardTelemetry()) {
+        merged.merge(telemetry.roundTripTimes);
+    }
+    return merged;
 }
 
-uint8_t InternalGameServer::getHostingPlayerId() const {
-    return hostingPlayerId;
+int InternalGameServer::getServerPort() const {
+    return serverPort;
 }
 
-uint8_t InternalGameServer::getNextPlayerId() const {
-    return nextPlayerId;
+size_t InternalGameServer::getRoomCount() const {
+    return rooms.size();
 }
 
-std::tuple<uint8_t, uint8_t> InternalGameServer::getBoardSettings() {
-    return {boardData.boardSize, boardData.winConditionLength};
+size_t InternalGameServer::getShardCount() const {
+    std::lock_guard<std::mutex> lock(this->shardsMutex);
+    return shards.size();
 }
 
-std::vector<PieceType> InternalGameServer::getAllAvailablePieces() {
-    return availablePieces;
-}
+std::vector<ShardTelemetry> InternalGameServer::getShardTelemetry() const {
+    std::lock_guard<std::mutex> lock(this->shardsMutex);
 
-std::vector<Player> InternalGameServer::getPlayers() const {
-    std::vector<Player> players;
-    players.reserve(clients.size());
-    for (auto &client: clients) {
-        players.push_back(ServerUtils::clientContextToPlayer(client, 0));
+    std::vector<ShardTelemetry> telemetry;
+    telemetry.reserve(shards.size());
+    for (const auto &shard: shards) {
+        telemetry.push_back(shard->getTelemetry());
     }
-    return players;
+    return telemetry;
 }
 
-std::vector<Move> InternalGameServer::getMoves() {
-    return moves;
+void InternalGameServer::watchRoom(const uint32_t roomId) {
+    watchedRoomId.store(roomId, std::memory_order_relaxed);
 }
 
+RoomTelemetry InternalGameServer::getRoomTelemetry(const uint32_t roomId) const {
+    std::lock_guard<std::mutex> lock(this->shardsMutex);
 
-
+    // A room that moved between shards was published by both, the newer snapshot wins
+    RoomTelemetry latest{};
+    latest.roomId = roomId;
+    for (const auto &shard: shards) {
+        const RoomTelemetry telemetry = shard->getRoomTelemetry();
+        if (telemetry.roomId == roomId && telemetry.version > latest.version) {
+            latest = telemetry;
+        }
+    }
+    return latest;
+}
@@ -2,175 +2,246 @@
 #define TICTACTOEOVERLAN_INTERNALGAMESERVER_H
 
 #include <atomic>
-#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
-#include <winsock2.h>
 
-#include "ClientContext.h"
-#include "../common/LongLongRollingAverage.h"
+#include "MoveJournal.h"
+#include "ReplayWriter.h"
+#include "RoomManager.h"
+#include "ServerShard.h"
 #include "../common/NetworkProtocol.h"
-
-#pragma comment(lib, "Ws2_32.lib")
+#include "../common/SocketLayer.h"
 
 /**
  * @brief The authoritative server logic for the game.
- * <br> Runs on a dedicated thread hosted by one of the clients.
+ * <br> Runs on a dedicated thread hosted by one of the clients, or standalone in the headless `tictactoe-server`.
  * <br> Responsibilities include:
  * <br> 1. Accepting new connections (TCP).
  * <br> 2. Managing the main game loop (Tick rate).
  * <br> 3. Enforcing game rules and state synchronization.
- * <br> 4. Broadcasting updates to all connected clients.
+ * <br> 4. Broadcasting updates to the members of each room.
+ * <br> A single server hosts many independent matches, each one lives in its own `GameRoom`.
+ * <br> The work is split across `ServerShard`s, each running its own event loop on its own thread.
+ * The server itself only owns the listening sockets, the room directory and the shards.
+ * <br> With a journal directory set, every shard logs its rooms' moves and events to a `MoveJournal`.
+ * After a crash the next `start` rebuilds the rooms from it, a clean stop deletes it.
+ * <br> With a replay directory set, every game that ends is archived there as a `ReplayFile`, written to disk
+ * by the `ReplayWriter`'s thread.
  */
 class InternalGameServer {
+    friend class ServerShard;
+
+public:
+    constexpr static size_t DEFAULT_OUTBOUND_HIGH_WATER_MARK = 256 * 1024;
+
+private:
     std::atomic<bool> keepRunning;
-    SOCKET listenSocket;
+    std::vector<SOCKET> listenSockets; //One per shard with SO_REUSEPORT, otherwise a single one on the first shard
     int serverPort;
-    std::atomic<long long> tick = 0;
-    std::atomic<long long> lastTickTime = 0;
-    LongLongRollingAverage avgTickTime{100}; //Thread-safe with mutex inside, so no need for atomic
+    std::atomic<size_t> outboundHighWaterMark = DEFAULT_OUTBOUND_HIGH_WATER_MARK;
+    std::atomic<size_t> maxClients = 0; //0 means unlimited
+    std::atomic<size_t> clientCount = 0; //Open connections across all shards
+
+    //Game State, each room owns its board, roster, piece pool and move history
+    RoomManager rooms;
+    // The clientContexts also hold player data and state, they live in the shard that owns their room
 
-    // std::map<uint8_t, ClientContext> clients;
-    std::vector<ClientContext> clients;
-    uint8_t nextPlayerId = 1;
-    uint8_t hostingPlayerId = 0;
-    std::vector<PieceType> availablePieces;
+    std::vector<std::unique_ptr<ServerShard>> shards;
+    std::vector<std::thread> shardThreads;
+    mutable std::mutex shardsMutex; //Guards `shards` against the debug getters while starting and stopping
+    std::atomic<size_t> acceptCursor = 0;
 
-    //Game State
-    BoardData boardData;
-    std::vector<Move> moves;
-    // The clientContexts also hold player data and state
+    //Crash recovery, see `MoveJournal`
+    std::string journalDirectory; //Empty while journaling is off
+    uint32_t journalEpoch = 0; //This start's epoch, one past the newest one found in the directory
+    std::atomic<uint64_t> journalSequence = 0; //The last sequence handed to a journal record, shared by all shards
+
+    std::string replayDirectory; //Where finished games get archived, see `ReplayFile`. Empty while archiving is off
+    ReplayWriter replayWriter; //Runs while archiving is on
+
+    //Telemetry, the shards publish the watched room for the debug overlay
+    std::atomic<uint32_t> watchedRoomId = DEFAULT_ROOM_ID;
+    std::atomic<uint64_t> roomTelemetryVersion = 0;
 
 public:
     InternalGameServer() : keepRunning(false),
-                           listenSocket(INVALID_SOCKET),
-                           boardData({{}, 3, 3, 0, 1}) {
+                           serverPort(0) {
     };
 
     /**
      * @brief Starts the server loop.
-     * <br> Binds to the specified port and enters the main `while(keepRunning)` loop.
+     * <br> Binds to the specified port, spawns the worker shards and runs the first one on the calling thread
+     * until `stop` is called.
+     * <br> Where the OS supports SO_REUSEPORT every shard gets its own listener on the port, so the kernel
+     * spreads incoming connections across the shards. Otherwise the first shard accepts for all of them.
      *
      * @param port The port number to listen on.
+     * @param shardCount How many shards (threads) share the rooms, at least one.
+     * @return False if the port couldn't be bound or the journal couldn't be opened, true once the server was stopped.
+     */
+    bool start(int port, size_t shardCount = 1);
+
+    /**
+     * @brief Connects the hosting client in-process, packets skip the TCP stack entirely.
+     * <br> The connection is accepted like a socket one: the server answers with `SERVER_HELLO`.
+     *
+     * @return The client's end of the connection, nullptr if the server isn't running (yet).
      */
-    void start(int port);
+    std::shared_ptr<LoopbackChannel> connectLoopback();
 
     /**
      * @brief Signals the server loop to terminate.
-     * <br> Sets `keepRunning` to false.
+     * <br> Sets `keepRunning` to false and wakes every shard if it's blocked.
      */
     void stop();
 
-    //getters - for debug purposes
-    long long getTick();
-
-    long long getLastTickTime();
+    /**
+     * @brief Sets how many bytes may wait in a client's outbound queue before the client gets disconnected.
+     * <br> Keeps a stalled connection from piling up memory, everyone else is never slowed down by it anyway.
+     *
+     * @param bytes The limit in bytes.
+     */
+    void setOutboundHighWaterMark(size_t bytes);
 
-    double getAvgTickTime();
+    size_t getOutboundHighWaterMark() const;
 
-    int getServerPort() const;
+    /**
+     * @brief Sets how many connections the server accepts at once, further ones get closed right away.
+     *
+     * @param count The limit, 0 for no limit.
+     */
+    void setMaxClients(size_t count);
 
-    uint8_t getNextPlayerId() const;
+    size_t getMaxClients() const;
 
-    uint16_t getCurrentTurn() const;
+    /**
+     * @brief Makes the server journal every room's moves and events, so a crashed server gets them back on restart.
+     * <br> Takes effect on the next `start`.
+     *
+     * @param directory Where the journal segments are kept, created if needed. Empty turns journaling off.
+     */
+    void setJournalDirectory(const std::string &directory);
 
-    uint8_t getHostingPlayerId() const;
+    /**
+     * @brief Makes the server archive every finished game as a replay file, for auditing it later.
+     * <br> Takes effect on the next `start`.
+     *
+     * @param directory Where the replays are written, created if needed. Empty turns archiving off.
+     */
+    void setReplayDirectory(const std::string &directory);
 
-    std::tuple<uint8_t, uint8_t> getBoardSettings();
+    size_t getClientCount() const;
 
-    std::vector<PieceType> getAllAvailablePieces();
+    //getters - for debug purposes, they read the snapshots the shards publish every tick and never block them
+    long long getTick();
 
-    std::vector<Player> getPlayers() const;
+    long long getLastTickTime();
 
-    std::vector<Move> getMoves();
+    /**
+     * @return The tick times of all shards: the mean of their averages, the overall min and max,
+     * and the percentiles of the slowest shard.
+     */
+    PackagedValues getTickTimes();
 
-private:
     /**
-     * @brief Accepts and processes a new connection.
-     * <br> If a client connects, creates a new `ClientContext`, assigns an ID, and sends `SERVER_HELLO`.
+     * @return Heartbeat round trip times of every client, across all shards.
      */
-    void handleNewConnection();
+    LatencyHistogram getRoundTripTimes();
+
+    int getServerPort() const;
+
+    size_t getRoomCount() const;
+
+    size_t getShardCount() const;
+
+    std::vector<ShardTelemetry> getShardTelemetry() const;
 
     /**
-     * @brief Reads incoming data from a specific client.
-     * <br> Appends data to the client's `receiveBuffer`.
-     * <br> If a full packet is assembled, calls `processPacket`.
+     * @brief Makes the shards publish this room's state for `getRoomTelemetry`, only one room is watched at a time.
+     * <br> The owning shard publishes on its next tick, and after that whenever the room changes.
      *
-     * @param client The client connection to poll.
+     * @param roomId The room to watch.
      */
-    void handleClientData(ClientContext &client);
+    void watchRoom(uint32_t roomId);
 
     /**
-     * @brief Retrieves and removes the next available piece type from the pool.
-     *
-     * @return The piece type.
+     * @return The latest published snapshot of the room, defaults if it isn't the watched room or doesn't exist.
      */
-    PieceType getFirstAvailablePiece();
+    RoomTelemetry getRoomTelemetry(uint32_t roomId) const;
 
+private:
     /**
-     * @brief Determines whose turn it is based on the round/turn counters.
+     * @brief Opens the listening sockets for `shardCount` shards into `listenSockets`.
+     * <br> Tries one SO_REUSEPORT listener per shard first and falls back to a single listener.
      *
-     * @return The ID of the acting player.
+     * @return False if the port couldn't be bound at all.
      */
-    uint8_t getNextActingPlayerId() const;
+    bool openListeners(int port, size_t shardCount);
 
     /**
-     * @brief The core logic dispatcher.
-     * <br> Switches on `PacketType` and executes the corresponding game logic.
+     * @brief Creates a non-blocking socket listening on all interfaces.
      *
-     * @param client The client who sent the packet.
-     * @param type The type of packet received.
-     * @param payload The raw byte data of the packet body.
+     * @param port The port number to listen on.
+     * @param reusePort Whether the socket joins the port's SO_REUSEPORT group.
+     * @return The socket, INVALID_SOCKET if it couldn't be bound.
      */
-    void processPacket(ClientContext &client, PacketType type, std::vector<char> &payload);
+    static SOCKET openListener(int port, bool reusePort);
+
+    void closeListeners();
 
     /**
-     * @brief Processes the SETUP_REQ packet.
+     * @brief Rebuilds the rooms left behind by a crashed run from the journal, hands them to their shards
+     * and compacts them into this epoch's first segment. Called by `start` once the shards exist.
+     * <br> The previous epochs' segments are only deleted after the compacted copy is on the disk.
      *
-     * @param client The client from which we received the packet.
-     * @param packet The parsed SetupReqPacket packet.
+     * @param recovery What `MoveJournal::recover` found, its rooms get moved into the room directory.
      */
-    void handleSetupRequestPacket(ClientContext &client, const SetupReqPacket *packet);
+    void recoverRooms(JournalRecovery &recovery);
 
     /**
-     * @brief Processes the SETTINGS_CHANGE_REQ packet.
-     *
-     * @param packet The parsed SettingsChangeReqPacket packet.
+     * @return The sequence of the next journal record, from any shard.
      */
-    bool handleSettingsChangeRequestPacket(const SettingsChangeReqPacket *packet);
+    uint64_t nextJournalSequence() {
+        return journalSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
 
     /**
-     * @brief Processes the GAME_START_REQ packet.
+     * @brief Picks the shard that receives the next accepted connection, round-robin.
      *
-     * @param packet The parsed GameStartRequestPacket packet.
+     * @return The shard index.
      */
-    bool handleGameStartRequestPacket(const GameStartRequestPacket *packet);
+    size_t nextAcceptShard();
+
+    ServerShard &getShard(size_t shardIndex) const;
 
     /**
-     * @brief Processes the MOVE_REQ packet.
+     * @brief Counts a new connection against the `maxClients` limit.
      *
-     * @param client The client from which we received the packet.
-     * @param packet The parsed MoveRequestPacket packet.
+     * @return False if the server is full and the connection has to be refused.
+     */
+    bool acquireClientSlot();
+
+    /**
+     * @brief Frees the slot of a closed connection.
      */
-    bool handleMoveRequestPacket(ClientContext &client, const MoveRequestPacket *packet);
+    void releaseClientSlot();
 
     /**
-     * @brief Sends a structured packet to a specific client.
+     * @brief Looks for a shard with spare runnable rooms and asks it to give one to the thief.
      *
-     * @param sock The target socket.
-     * @param type The packet type identifier.
-     * @param data The payload struct.
+     * @param thiefIndex The index of the idle shard.
      */
-    template<typename T>
-    static void sendPacket(SOCKET sock, PacketType type, const T &data);
+    void stealFor(size_t thiefIndex);
 
     /**
-     * @brief Sends a packet to ALL connected clients.
+     * @brief Wakes one idle shard so it can steal work from a busy one.
      *
-     * @param type The packet type identifier.
-     * @param data The payload struct.
+     * @param busyIndex The index of the busy shard, never woken.
      */
-    template<typename T>
-    void broadcastPacket(const PacketType type, const T &data);
+    void wakeIdleShard(size_t busyIndex);
 };
 
 
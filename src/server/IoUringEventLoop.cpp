@@ -0,0 +1,725 @@
+#include "IoUringEventLoop.h"
+
+#ifdef __linux__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ranges>
+#include <poll.h>
+#include <unistd.h>
+#include <linux/time_types.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+IoUringEventLoop::IoUringEventLoop() {
+    wakeupFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (wakeupFd == -1 || !this->setupRing() || !this->setupBuffers()) {
+        LOG_ERROR(SERVER, ANSI_RED "[IoUringEventLoop] Failed to set up io_uring!\n" ANSI_RESET);
+        return;
+    }
+
+    valid = true;
+    this->armWakeup();
+}
+
+IoUringEventLoop::~IoUringEventLoop() {
+    //Closing the ring cancels everything still in flight
+    if (ringFd != -1) close(ringFd);
+    if (sqes != nullptr) munmap(sqes, sqesSize);
+    if (sqRing != nullptr) munmap(sqRing, sqRingSize);
+    if (wakeupFd != -1) close(wakeupFd);
+}
+
+bool IoUringEventLoop::isValid() const {
+    return valid;
+}
+
+bool IoUringEventLoop::setupRing() {
+    io_uring_params params{};
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, QUEUE_DEPTH, &params));
+    if (ringFd < 0) {
+        ringFd = -1;
+        return false;
+    }
+
+    constexpr unsigned requiredFeatures = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & requiredFeatures) != requiredFeatures) {
+        return false;
+    }
+
+    //With SINGLE_MMAP both rings share one mapping
+    sqRingSize = std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                          params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                  IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+        sqRing = nullptr;
+        return false;
+    }
+
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                            ringFd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+        sqes = nullptr;
+        return false;
+    }
+
+    const auto ring = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(ring + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(ring + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(ring + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(ring + params.sq_off.array);
+    sqLocalTail = *sqTail;
+
+    cqHead = reinterpret_cast<unsigned *>(ring + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(ring + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(ring + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(ring + params.cq_off.cqes);
+
+    return true;
+}
+
+bool IoUringEventLoop::setupBuffers() {
+    buffers.resize(static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+    for (uint16_t bufferId = 0; bufferId < BUFFER_COUNT; ++bufferId) {
+        this->recycleBuffer(bufferId);
+    }
+
+    //Hand the pool over right away, so the first receives find buffers
+    this->submit(0, 0);
+    return true;
+}
+
+bool IoUringEventLoop::add(const SOCKET socket, const uint8_t events) {
+    if (registrationBySocket.contains(socket)) {
+        return false;
+    }
+
+    //Listening sockets can't be received from, they get a poll instead
+    int acceptsConnections = 0;
+    socklen_t optionLength = sizeof(acceptsConnections);
+    getsockopt(socket, SOL_SOCKET, SO_ACCEPTCONN, &acceptsConnections, &optionLength);
+
+    const uint64_t registrationId = nextRegistrationId++;
+    registrations[registrationId] = {socket, events, acceptsConnections != 0, 0, false, false};
+    registrationBySocket[socket] = registrationId;
+
+    if (events & IoEvent::READ) {
+        if (acceptsConnections) {
+            this->armPoll(registrationId, socket);
+        } else {
+            this->armReceive(registrationId, socket);
+        }
+    }
+    if (events & IoEvent::WRITE) {
+        writeWatchers.insert(socket);
+    }
+
+    return true;
+}
+
+bool IoUringEventLoop::modify(const SOCKET socket, const uint8_t events) {
+    const auto idIt = registrationBySocket.find(socket);
+    if (idIt == registrationBySocket.end()) {
+        return false;
+    }
+
+    const uint64_t registrationId = idIt->second;
+    Registration &registration = registrations.at(registrationId);
+    const uint8_t added = events & ~registration.events;
+    const uint8_t removed = registration.events & ~events;
+    registration.events = events;
+
+    const Operation readOperation = registration.listening ? Operation::POLL_READ : Operation::RECEIVE;
+    if (removed & IoEvent::READ) this->cancel(encodeUserData(registrationId, readOperation));
+    if (removed & IoEvent::WRITE) writeWatchers.erase(socket);
+
+    if (added & IoEvent::READ) {
+        if (registration.listening) {
+            this->armPoll(registrationId, socket);
+        } else {
+            this->armReceive(registrationId, socket);
+        }
+    }
+    if (added & IoEvent::WRITE) {
+        writeWatchers.insert(socket);
+    }
+
+    return true;
+}
+
+void IoUringEventLoop::remove(const SOCKET socket) {
+    const auto idIt = registrationBySocket.find(socket);
+    if (idIt == registrationBySocket.end()) {
+        return;
+    }
+    const uint64_t registrationId = idIt->second;
+
+    //Nobody is going to read what wasn't sent yet
+    if (const auto outboundIt = outbound.find(socket); outboundIt != outbound.end()) {
+        outboundIt->second.queued.clear();
+    }
+    this->cancelOperations(registrationId);
+    inbound.erase(socket);
+    this->retire(registrationId);
+}
+
+void IoUringEventLoop::detach(const SOCKET socket, std::vector<char> &outUnread, std::vector<char> &outUnsent) {
+    const auto idIt = registrationBySocket.find(socket);
+    if (idIt == registrationBySocket.end()) {
+        return;
+    }
+    const uint64_t registrationId = idIt->second;
+
+    //Queued bytes aren't submitted anymore, they go to the new owner along with the cancelled batch
+    std::erase(pendingFlush, socket);
+    this->cancelOperations(registrationId);
+
+    if (const auto inboundIt = inbound.find(socket); inboundIt != inbound.end()) {
+        const Inbound &received = inboundIt->second;
+        outUnread.insert(outUnread.end(), received.data.begin() + static_cast<long>(received.readOffset),
+                         received.data.end());
+        inbound.erase(inboundIt);
+    }
+
+    bool stillInFlight = registrations.at(registrationId).armedOperations > 0;
+    if (const auto outboundIt = outbound.find(socket); outboundIt != outbound.end()) {
+        const Outbound &pending = outboundIt->second;
+        if (pending.sending) {
+            stillInFlight = true;
+        } else {
+            copyUnsent(pending, outUnsent);
+        }
+    }
+
+    //Whatever completes later can't be handed over anymore, end the stream rather than leave a gap in it
+    if (stillInFlight) {
+        LOG_WARN(SERVER, ANSI_YELLOW "[IoUringEventLoop] Socket %d still had operations in flight while detaching, "
+                 "closing the connection.\n" ANSI_RESET, socket);
+        shutdown(socket, SHUT_RDWR);
+    }
+    this->retire(registrationId);
+}
+
+bool IoUringEventLoop::canDetach(const SOCKET socket) const {
+    //Received data the caller had no room for yet may not fit into the new owner's buffer either
+    if (inbound.contains(socket)) {
+        return false;
+    }
+
+    //A submitted send can't be taken back, only cancelled with an unknown part of it already sent
+    const auto outboundIt = outbound.find(socket);
+    return outboundIt == outbound.end() || !outboundIt->second.sending;
+}
+
+int IoUringEventLoop::receive(const SOCKET socket, char *buffer, const int length) {
+    const auto inboundIt = inbound.find(socket);
+    if (inboundIt == inbound.end()) {
+        return WOULD_BLOCK;
+    }
+
+    Inbound &received = inboundIt->second;
+    const size_t unread = received.data.size() - received.readOffset;
+    if (unread > 0) {
+        //Only the offset moves, `handleReceive` compacts the consumed bytes away
+        const size_t count = std::min(static_cast<size_t>(length), unread);
+        std::memcpy(buffer, received.data.data() + received.readOffset, count);
+        received.readOffset += count;
+
+        if (received.readOffset == received.data.size() && !received.closed && !received.failed) {
+            inbound.erase(inboundIt);
+        }
+        return static_cast<int>(count);
+    }
+
+    //Everything was consumed, report how the connection ended
+    const bool failed = received.failed;
+    inbound.erase(inboundIt);
+    return failed ? -1 : 0;
+}
+
+int IoUringEventLoop::send(const SOCKET socket, const IoSlice *slices, const size_t count) {
+    //One batch in flight per socket, the caller keeps the rest until the socket is reported writable again
+    const auto [outboundIt, created] = outbound.try_emplace(socket);
+    Outbound &pending = outboundIt->second;
+    if (pending.sending) {
+        return 0;
+    }
+
+    //Not submitted yet, so it still joins the batch going out at the end of this tick
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const IoSlice &slice = slices[i];
+        if (slice.frame != nullptr) {
+            pending.queued.push_back({*slice.frame, slice.data, slice.length});
+        } else {
+            //Nothing keeps these bytes alive until the send completes, so they get a frame of their own
+            auto copy = std::make_shared<const std::vector<char>>(slice.data, slice.data + slice.length);
+            const char *data = copy->data();
+            pending.queued.push_back({std::move(copy), data, slice.length});
+        }
+        accepted += slice.length;
+    }
+    if (created) {
+        pendingFlush.push_back(socket);
+    }
+    return static_cast<int>(accepted);
+}
+
+void IoUringEventLoop::flush() {
+    for (const SOCKET socket: pendingFlush) {
+        this->submitSend(socket);
+    }
+    pendingFlush.clear();
+
+    if (sqUnsubmitted > 0) {
+        this->submit(0, 0);
+    }
+}
+
+int IoUringEventLoop::wait(std::vector<ReadyEvent> &outEvents, const int timeoutMs) {
+    outEvents.clear();
+
+    for (const SOCKET socket: pendingFlush) {
+        this->submitSend(socket);
+    }
+    pendingFlush.clear();
+
+    //The server handled the previous readiness by now, so a poll that fires again reports new work
+    for (const uint64_t registrationId: pollsToRearm) {
+        const auto registrationIt = registrations.find(registrationId);
+        if (registrationIt == registrations.end() || registrationIt->second.detaching) continue;
+
+        if (registrationIt->second.events & IoEvent::READ) {
+            this->armPoll(registrationId, registrationIt->second.socket);
+        }
+    }
+    pollsToRearm.clear();
+
+    //A socket is writable as long as it has no batch of its own in flight
+    for (const SOCKET socket: writeWatchers) {
+        if (!outbound.contains(socket)) {
+            readyThisWait[socket] |= IoEvent::WRITE;
+        }
+    }
+
+    //Don't block if there is still something to report from earlier completions
+    const bool hasBacklog = !inbound.empty() || !readyThisWait.empty()
+                            || std::atomic_ref(*cqTail).load(std::memory_order_acquire) != *cqHead;
+    this->submit(hasBacklog ? 0 : 1, timeoutMs);
+    this->reapCompletions();
+
+    for (const auto &socket: inbound | std::views::keys) {
+        readyThisWait[socket] |= IoEvent::READ;
+    }
+    for (const auto &[socket, events]: readyThisWait) {
+        outEvents.push_back({socket, events});
+    }
+    readyThisWait.clear();
+
+    return static_cast<int>(outEvents.size());
+}
+
+void IoUringEventLoop::wakeup() {
+    constexpr uint64_t one = 1;
+    write(wakeupFd, &one, sizeof(one));
+}
+
+int IoUringEventLoop::idleTimeoutMs() const {
+    return -1;
+}
+
+io_uring_sqe *IoUringEventLoop::nextSqe() {
+    if (sqLocalTail - std::atomic_ref(*sqHead).load(std::memory_order_acquire) > sqMask) {
+        this->submit(0, 0);
+    }
+
+    const unsigned index = sqLocalTail & sqMask;
+    io_uring_sqe *sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    sqArray[index] = index;
+
+    ++sqLocalTail;
+    ++sqUnsubmitted;
+    return sqe;
+}
+
+void IoUringEventLoop::submit(const unsigned waitFor, const int timeoutMs) {
+    this->provideRecycledBuffers();
+    std::atomic_ref(*sqTail).store(sqLocalTail, std::memory_order_release);
+
+    unsigned flags = 0;
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg waitArgs{};
+    if (waitFor > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        if (timeoutMs >= 0) {
+            timeout.tv_sec = timeoutMs / 1000;
+            timeout.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+            waitArgs.ts = reinterpret_cast<uint64_t>(&timeout);
+        }
+    }
+
+    const long submitted = syscall(__NR_io_uring_enter, ringFd, sqUnsubmitted, waitFor, flags,
+                                   waitFor > 0 ? &waitArgs : nullptr, waitFor > 0 ? sizeof(waitArgs) : 0);
+    if (submitted > 0) {
+        sqUnsubmitted -= static_cast<unsigned>(submitted);
+    } else if (submitted < 0 && errno != ETIME && errno != EINTR) {
+        LOG_ERROR(SERVER, ANSI_RED "[IoUringEventLoop] io_uring_enter failed: %s\n" ANSI_RESET, std::strerror(errno));
+    }
+}
+
+void IoUringEventLoop::armReceive(const uint64_t registrationId, const SOCKET socket) {
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = socket;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = encodeUserData(registrationId, Operation::RECEIVE);
+
+    ++registrations.at(registrationId).armedOperations;
+}
+
+void IoUringEventLoop::armPoll(const uint64_t registrationId, const SOCKET socket) {
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = socket;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = encodeUserData(registrationId, Operation::POLL_READ);
+
+    ++registrations.at(registrationId).armedOperations;
+}
+
+void IoUringEventLoop::armWakeup() {
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeupFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = encodeUserData(0, Operation::WAKEUP);
+}
+
+void IoUringEventLoop::cancel(const uint64_t userData) {
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = userData;
+    sqe->user_data = encodeUserData(0, Operation::CANCEL);
+}
+
+void IoUringEventLoop::submitSend(const SOCKET socket) {
+    const auto outboundIt = outbound.find(socket);
+    if (outboundIt == outbound.end() || outboundIt->second.sending || outboundIt->second.queued.empty()) {
+        return;
+    }
+
+    const auto idIt = registrationBySocket.find(socket);
+    if (idIt == registrationBySocket.end()) {
+        outbound.erase(outboundIt);
+        return;
+    }
+
+    //Everything queued since the last send goes out as a single write
+    Outbound &pending = outboundIt->second;
+    pending.inFlight.swap(pending.queued);
+    pending.queued.clear();
+    pending.inFlightIndex = 0;
+    pending.inFlightOffset = 0;
+
+    //sendmsg takes at most IOV_MAX slices, the tail of a bigger batch (of tiny frames) is copied into one
+    if (pending.inFlight.size() > MAX_SEND_IOVECS) {
+        const auto tail = pending.inFlight.begin() + static_cast<long>(MAX_SEND_IOVECS - 1);
+        auto merged = std::make_shared<std::vector<char>>();
+        for (auto sliceIt = tail; sliceIt != pending.inFlight.end(); ++sliceIt) {
+            merged->insert(merged->end(), sliceIt->data, sliceIt->data + sliceIt->length);
+        }
+        pending.inFlight.erase(tail, pending.inFlight.end());
+        const char *data = merged->data();
+        const size_t length = merged->size();
+        pending.inFlight.push_back({std::move(merged), data, length});
+    }
+    pending.sending = true;
+    this->submitSendSqe(idIt->second, socket, pending);
+}
+
+void IoUringEventLoop::submitSendSqe(const uint64_t registrationId, const SOCKET socket, Outbound &pending) {
+    //The kernel copies the header and the iovecs when the entry is submitted, only the frames have to stay alive
+    pending.iovecs.clear();
+    for (size_t i = pending.inFlightIndex; i < pending.inFlight.size(); ++i) {
+        const OutboundSlice &slice = pending.inFlight[i];
+        const size_t alreadySent = i == pending.inFlightIndex ? pending.inFlightOffset : 0;
+        pending.iovecs.push_back({const_cast<char *>(slice.data + alreadySent), slice.length - alreadySent});
+    }
+    pending.message = {};
+    pending.message.msg_iov = pending.iovecs.data();
+    pending.message.msg_iovlen = pending.iovecs.size();
+
+    //Keyed by the registration, the completion may arrive after the descriptor got reused
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = socket;
+    sqe->addr = reinterpret_cast<uint64_t>(&pending.message);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = encodeUserData(registrationId, Operation::SEND);
+}
+
+void IoUringEventLoop::copyUnsent(const Outbound &pending, std::vector<char> &outUnsent) {
+    for (size_t i = pending.inFlightIndex; i < pending.inFlight.size(); ++i) {
+        const OutboundSlice &slice = pending.inFlight[i];
+        const size_t alreadySent = i == pending.inFlightIndex ? pending.inFlightOffset : 0;
+        outUnsent.insert(outUnsent.end(), slice.data + alreadySent, slice.data + slice.length);
+    }
+    for (const OutboundSlice &slice: pending.queued) {
+        outUnsent.insert(outUnsent.end(), slice.data, slice.data + slice.length);
+    }
+}
+
+void IoUringEventLoop::reapCompletions() {
+    unsigned head = *cqHead;
+    const unsigned tail = std::atomic_ref(*cqTail).load(std::memory_order_acquire);
+
+    while (head != tail) {
+        const io_uring_cqe cqe = cqes[head & cqMask];
+        ++head;
+        std::atomic_ref(*cqHead).store(head, std::memory_order_release);
+
+        const uint64_t id = cqe.user_data >> 8;
+        const bool finished = !(cqe.flags & IORING_CQE_F_MORE);
+
+        switch (static_cast<Operation>(cqe.user_data & 0xFF)) {
+            case Operation::RECEIVE:
+                this->handleReceive(id, cqe);
+                break;
+            case Operation::POLL_READ: {
+                const auto registrationIt = registrations.find(id);
+                if (registrationIt == registrations.end()) break;
+
+                Registration &registration = registrationIt->second;
+                if (cqe.res > 0 && !registration.detaching) {
+                    readyThisWait[registration.socket] |= IoEvent::READ;
+                }
+                if (finished) {
+                    --registration.armedOperations;
+                    if (cqe.res >= 0 && !registration.detaching && (registration.events & IoEvent::READ)) {
+                        pollsToRearm.push_back(id);
+                    }
+                    this->releaseIfDone(id);
+                }
+                break;
+            }
+            case Operation::SEND:
+                this->handleSend(id, cqe.res);
+                break;
+            case Operation::WAKEUP: {
+                uint64_t counter;
+                read(wakeupFd, &counter, sizeof(counter));
+                if (finished) this->armWakeup();
+                break;
+            }
+            case Operation::PROVIDE_BUFFERS:
+                if (cqe.res < 0) {
+                    LOG_ERROR(SERVER, ANSI_RED "[IoUringEventLoop] Failed to provide receive buffers: %s\n" ANSI_RESET,
+                              std::strerror(-cqe.res));
+                }
+                break;
+            case Operation::CANCEL:
+                break;
+        }
+    }
+}
+
+void IoUringEventLoop::handleReceive(const uint64_t registrationId, const io_uring_cqe &cqe) {
+    const auto registrationIt = registrations.find(registrationId);
+    Registration *registration = registrationIt == registrations.end() ? nullptr : &registrationIt->second;
+
+    if (cqe.flags & IORING_CQE_F_BUFFER) {
+        const auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (registration != nullptr && !registration->retired && cqe.res > 0) {
+            const char *data = buffers.data() + static_cast<size_t>(bufferId) * BUFFER_SIZE;
+            Inbound &received = inbound[registration->socket];
+            //Drop what `receive` handed out once it's at least half the data, so every byte moves at most once more
+            if (received.readOffset > 0 && received.readOffset * 2 >= received.data.size()) {
+                received.data.erase(received.data.begin(),
+                                    received.data.begin() + static_cast<long>(received.readOffset));
+                received.readOffset = 0;
+            }
+            received.data.insert(received.data.end(), data, data + cqe.res);
+        }
+        this->recycleBuffer(bufferId);
+    }
+
+    if (registration == nullptr || (cqe.flags & IORING_CQE_F_MORE)) {
+        return;
+    }
+
+    //The multishot receive is over, find out why
+    --registration->armedOperations;
+    if (registration->detaching || !(registration->events & IoEvent::READ)) {
+        this->releaseIfDone(registrationId);
+        return;
+    }
+
+    if (cqe.res > 0 || cqe.res == -ENOBUFS) {
+        this->armReceive(registrationId, registration->socket);
+    } else if (cqe.res == 0) {
+        inbound[registration->socket].closed = true;
+    } else if (cqe.res != -ECANCELED) {
+        inbound[registration->socket].failed = true;
+    }
+}
+
+void IoUringEventLoop::handleSend(const uint64_t registrationId, const int result) {
+    const auto registrationIt = registrations.find(registrationId);
+    if (registrationIt == registrations.end()) {
+        return;
+    }
+
+    //The socket is gone, all that's left is to free the buffer
+    const Registration &registration = registrationIt->second;
+    if (registration.retired) {
+        retiredSends.erase(registrationId);
+        this->releaseIfDone(registrationId);
+        return;
+    }
+
+    const SOCKET socket = registration.socket;
+    const auto outboundIt = outbound.find(socket);
+    if (outboundIt == outbound.end()) {
+        return;
+    }
+
+    Outbound &pending = outboundIt->second;
+    if (result < 0) {
+        if (result != -ECANCELED) {
+            LOG_ERROR(SERVER,
+                      ANSI_RED "[IoUringEventLoop] Error sending data: %s\n" ANSI_RESET, std::strerror(-result));
+        }
+        if (registration.detaching) {
+            //Cancelled by `detach`, which hands the unsent bytes over
+            pending.sending = false;
+        } else {
+            outbound.erase(outboundIt);
+        }
+        return;
+    }
+
+    //Skip the slices that are out, the batch continues in the middle of the next one
+    auto sent = static_cast<size_t>(result);
+    while (sent > 0) {
+        const size_t sliceLeft = pending.inFlight[pending.inFlightIndex].length - pending.inFlightOffset;
+        if (sent < sliceLeft) {
+            pending.inFlightOffset += sent;
+            break;
+        }
+        sent -= sliceLeft;
+        ++pending.inFlightIndex;
+        pending.inFlightOffset = 0;
+    }
+
+    if (registration.detaching) {
+        pending.sending = false;
+        return;
+    }
+    if (pending.inFlightIndex < pending.inFlight.size()) {
+        //Short write, send the rest before anything queued behind it
+        this->submitSendSqe(registrationId, socket, pending);
+        return;
+    }
+
+    //The batch is out, the socket takes the next one
+    outbound.erase(outboundIt);
+    if (writeWatchers.contains(socket)) {
+        readyThisWait[socket] |= IoEvent::WRITE;
+    }
+}
+
+void IoUringEventLoop::recycleBuffer(const uint16_t bufferId) {
+    recycledBuffers.push_back(bufferId);
+}
+
+void IoUringEventLoop::provideRecycledBuffers() {
+    if (recycledBuffers.empty()) {
+        return;
+    }
+
+    std::vector<uint16_t> recycled;
+    recycled.swap(recycledBuffers);
+    std::ranges::sort(recycled);
+
+    //One submission per run of consecutive buffer IDs
+    size_t runStart = 0;
+    for (size_t i = 1; i <= recycled.size(); ++i) {
+        if (i < recycled.size() && recycled[i] == recycled[i - 1] + 1) continue;
+
+        io_uring_sqe *sqe = this->nextSqe();
+        sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+        sqe->fd = static_cast<int>(i - runStart);
+        sqe->addr = reinterpret_cast<uint64_t>(buffers.data() + static_cast<size_t>(recycled[runStart]) * BUFFER_SIZE);
+        sqe->len = BUFFER_SIZE;
+        sqe->off = recycled[runStart];
+        sqe->buf_group = BUFFER_GROUP;
+        sqe->user_data = encodeUserData(0, Operation::PROVIDE_BUFFERS);
+
+        runStart = i;
+    }
+}
+
+void IoUringEventLoop::cancelOperations(const uint64_t registrationId) {
+    Registration &registration = registrations.at(registrationId);
+    registration.detaching = true;
+
+    io_uring_sqe *sqe = this->nextSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = registration.socket;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = encodeUserData(0, Operation::CANCEL);
+
+    //The kernel looks the descriptor up when it processes the cancellation, it has to be submitted before the close
+    this->submit(0, 0);
+    this->reapCompletions();
+}
+
+void IoUringEventLoop::retire(const uint64_t registrationId) {
+    Registration &registration = registrations.at(registrationId);
+    registration.retired = true;
+    const SOCKET socket = registration.socket;
+
+    //The kernel may still read an in-flight send's buffer, it lives until the send completes
+    if (const auto outboundIt = outbound.find(socket); outboundIt != outbound.end()) {
+        if (outboundIt->second.sending) {
+            retiredSends[registrationId] = std::move(outboundIt->second);
+        }
+        outbound.erase(outboundIt);
+    }
+
+    registrationBySocket.erase(socket);
+    writeWatchers.erase(socket);
+    readyThisWait.erase(socket);
+    std::erase(pendingFlush, socket);
+    this->releaseIfDone(registrationId);
+}
+
+void IoUringEventLoop::releaseIfDone(const uint64_t registrationId) {
+    const auto registrationIt = registrations.find(registrationId);
+    if (registrationIt != registrations.end() && registrationIt->second.retired
+        && registrationIt->second.armedOperations == 0 && !retiredSends.contains(registrationId)) {
+        registrations.erase(registrationIt);
+    }
+}
+
+uint64_t IoUringEventLoop::encodeUserData(const uint64_t id, const Operation operation) {
+    return id << 8 | static_cast<uint8_t>(operation);
+}
+
+#endif //__linux__
@@ -0,0 +1,241 @@
+#ifndef TICTACTOEOVERLAN_IOURINGEVENTLOOP_H
+#define TICTACTOEOVERLAN_IOURINGEVENTLOOP_H
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include "EventLoop.h"
+
+/**
+ * @brief Linux `EventLoop` backed by io_uring, talking to the kernel through the raw syscalls.
+ * <br> Client sockets get a multishot receive that picks its buffers from a pool provided to the kernel, so no
+ * `recv` syscall is made per read, the data is already in user space when `wait` reports the socket.
+ * Consumed buffers are given back in batches along with the next submission.
+ * <br> Sends are collected into one batch per socket and submitted at the end of the tick as a single gathered
+ * `sendmsg`. The batch references the caller's frames instead of copying them, so a broadcast frame stays shared.
+ * A socket has one batch in flight at a time, to keep the byte order, and is reported as `IoEvent::WRITE` ready
+ * once it's fully sent. The caller coalesces everything it produced in the meantime into the next batch.
+ * <br> Listening sockets use one-shot polls, re-armed on the next `wait` so they behave
+ * level-triggered like the other backends. The wakeup eventfd uses a multishot poll.
+ * <br> `remove` and `detach` never wait for the kernel: they cancel the socket's operations and the registration
+ * stays around, retired, until its last completions come in through `wait`. A send in flight can't be handed over,
+ * so `canDetach` holds a migration back until it completed, and until the caller consumed what was received.
+ * <br> Requires Linux 6.0 or newer, `isValid` reports false if the ring couldn't be set up.
+ */
+class IoUringEventLoop final : public EventLoop {
+    constexpr static unsigned QUEUE_DEPTH = 256;
+    constexpr static unsigned BUFFER_COUNT = 256; //Must be a power of two
+    constexpr static unsigned BUFFER_SIZE = 4096;
+    constexpr static uint16_t BUFFER_GROUP = 0;
+    constexpr static size_t MAX_SEND_IOVECS = 1024; //IOV_MAX, slices of one batch
+
+    /**
+     * @brief What a submission was for, stored in the low byte of its `user_data`.
+     */
+    enum class Operation : uint8_t {
+        RECEIVE = 1,
+        POLL_READ = 2,
+        SEND = 3,
+        WAKEUP = 4,
+        CANCEL = 5,
+        PROVIDE_BUFFERS = 6,
+    };
+
+    struct Registration {
+        SOCKET socket;
+        uint8_t events;
+        bool listening;
+        int armedOperations; //Operations that haven't posted their final completion yet
+        bool detaching; //Its operations got cancelled, completions no longer re-arm anything
+        bool retired; //The socket is gone, the registration only waits for its last completions
+    };
+
+    struct Inbound {
+        std::vector<char> data;
+        size_t readOffset = 0; //Bytes at the front already handed out by `receive`
+        bool closed = false;
+        bool failed = false;
+    };
+
+    /**
+     * @brief Bytes of a frame waiting to be sent, the frame is referenced, never copied.
+     */
+    struct OutboundSlice {
+        SharedFrame frame;
+        const char *data;
+        size_t length;
+    };
+
+    struct Outbound {
+        std::vector<OutboundSlice> queued;
+        std::vector<OutboundSlice> inFlight;
+        size_t inFlightIndex = 0; //First slice of `inFlight` that isn't fully sent
+        size_t inFlightOffset = 0; //Bytes of that slice that are
+        std::vector<iovec> iovecs; //The unsent part of `inFlight`, as submitted
+        msghdr message{};
+        bool sending = false;
+    };
+
+    bool valid = false;
+    int ringFd = -1;
+    int wakeupFd = -1;
+
+    //Submission queue, the completion queue shares its mapping
+    void *sqRing = nullptr;
+    size_t sqRingSize = 0;
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned *sqArray = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned sqLocalTail = 0;
+    unsigned sqUnsubmitted = 0;
+
+    //Completion queue
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+
+    //Provided buffers for the multishot receives
+    std::vector<char> buffers;
+    std::vector<uint16_t> recycledBuffers; //Consumed, not yet given back to the kernel
+
+    uint64_t nextRegistrationId = 1;
+    std::unordered_map<uint64_t, Registration> registrations;
+    std::unordered_map<SOCKET, uint64_t> registrationBySocket;
+
+    std::unordered_map<SOCKET, Inbound> inbound; //Received but not yet consumed through `receive`
+    std::unordered_map<SOCKET, Outbound> outbound;
+    std::unordered_map<uint64_t, Outbound> retiredSends; //In-flight sends of retired registrations
+    std::vector<SOCKET> pendingFlush; //Sockets with queued data and no send in flight
+    std::unordered_set<SOCKET> writeWatchers; //Sockets registered for `IoEvent::WRITE`
+
+    std::unordered_map<SOCKET, uint8_t> readyThisWait;
+    std::vector<uint64_t> pollsToRearm; //Registrations whose one-shot read poll fired
+
+public:
+    IoUringEventLoop();
+
+    ~IoUringEventLoop() override;
+
+    /**
+     * @return True if the ring, the buffer pool and the wakeup eventfd were all set up.
+     */
+    bool isValid() const;
+
+    bool add(SOCKET socket, uint8_t events) override;
+
+    bool modify(SOCKET socket, uint8_t events) override;
+
+    void remove(SOCKET socket) override;
+
+    void detach(SOCKET socket, std::vector<char> &outUnread, std::vector<char> &outUnsent) override;
+
+    bool canDetach(SOCKET socket) const override;
+
+    int receive(SOCKET socket, char *buffer, int length) override;
+
+    int send(SOCKET socket, const IoSlice *slices, size_t count) override;
+
+    void flush() override;
+
+    int wait(std::vector<ReadyEvent> &outEvents, int timeoutMs) override;
+
+    void wakeup() override;
+
+    int idleTimeoutMs() const override;
+
+private:
+    bool setupRing();
+
+    bool setupBuffers();
+
+    /**
+     * @brief Reserves the next submission queue entry, submitting the queue first if it's full.
+     */
+    io_uring_sqe *nextSqe();
+
+    /**
+     * @brief Hands all reserved entries and recycled buffers to the kernel and optionally waits for completions.
+     *
+     * @param waitFor Minimum number of completions to wait for.
+     * @param timeoutMs Maximum time to wait, -1 waits indefinitely. Ignored if `waitFor` is 0.
+     */
+    void submit(unsigned waitFor, int timeoutMs);
+
+    void armReceive(uint64_t registrationId, SOCKET socket);
+
+    void armPoll(uint64_t registrationId, SOCKET socket);
+
+    void armWakeup();
+
+    /**
+     * @brief Cancels a single in-flight operation.
+     *
+     * @param userData The `user_data` the operation was submitted with.
+     */
+    void cancel(uint64_t userData);
+
+    void submitSend(SOCKET socket);
+
+    /**
+     * @brief Submits a gathered send of the batch's unsent bytes.
+     */
+    void submitSendSqe(uint64_t registrationId, SOCKET socket, Outbound &pending);
+
+    /**
+     * @brief Copies the bytes of the batch that weren't sent yet, in order, for `detach`.
+     */
+    static void copyUnsent(const Outbound &pending, std::vector<char> &outUnsent);
+
+    /**
+     * @brief Processes every completion currently in the completion queue.
+     */
+    void reapCompletions();
+
+    void handleReceive(uint64_t registrationId, const io_uring_cqe &cqe);
+
+    void handleSend(uint64_t registrationId, int result);
+
+    void recycleBuffer(uint16_t bufferId);
+
+    /**
+     * @brief Queues the submissions that give all recycled buffers back to the kernel.
+     */
+    void provideRecycledBuffers();
+
+    /**
+     * @brief Cancels everything in flight on the registration's socket, without waiting for it.
+     * <br> The cancellation is submitted right away, while the socket is still open, and whatever completed
+     * by then is reaped. Operations on a socket are cancelled inline by the kernel, so in practice nothing is
+     * left in flight afterwards.
+     */
+    void cancelOperations(uint64_t registrationId);
+
+    /**
+     * @brief Forgets the registration's socket, so the descriptor can be reused right away.
+     * <br> An in-flight send keeps its buffer until it completes, the registration itself is erased once
+     * nothing of it is in flight anymore.
+     */
+    void retire(uint64_t registrationId);
+
+    /**
+     * @brief Erases a retired registration once its last completion came in.
+     */
+    void releaseIfDone(uint64_t registrationId);
+
+    static uint64_t encodeUserData(uint64_t id, Operation operation);
+};
+
+#endif //__linux__
+
+#endif //TICTACTOEOVERLAN_IOURINGEVENTLOOP_H
@@ -0,0 +1,100 @@
+#include "LoopbackChannel.h"
+
+#include "ServerShard.h"
+
+namespace {
+    // Counts down from just below INVALID_SOCKET, a range no real socket gets handed out from
+    std::atomic<size_t> handlesIssued = 0;
+}
+
+LoopbackChannel::LoopbackChannel() : handle(static_cast<SOCKET>(INVALID_SOCKET - 1 - handlesIssued++)) {
+}
+
+SOCKET LoopbackChannel::getHandle() const {
+    return handle;
+}
+
+bool LoopbackChannel::sendToServer(SharedFrame frame) {
+    if (closedByClient || closedByServer) {
+        return false;
+    }
+
+    const bool pushed = toServer.tryPush(std::move(frame));
+    this->wakeOwner();
+    return pushed;
+}
+
+bool LoopbackChannel::receiveFromServer(SharedFrame &outFrame) {
+    if (!toClient.tryPop(outFrame)) {
+        return false;
+    }
+
+    // The server stopped pushing because we were full, let it continue now that there's room
+    if (serverWaitingForSpace.exchange(false)) {
+        this->wakeOwner();
+    }
+    return true;
+}
+
+void LoopbackChannel::closeFromClient() {
+    closedByClient = true;
+    this->wakeOwner();
+}
+
+bool LoopbackChannel::isClosedByServer() const {
+    return closedByServer;
+}
+
+void LoopbackChannel::waitForServer() {
+    std::unique_lock<std::mutex> lock(this->clientMutex);
+    clientCondition.wait(lock, [this] { return clientWoken; });
+    clientWoken = false;
+}
+
+void LoopbackChannel::wakeClient() {
+    {
+        std::lock_guard<std::mutex> lock(this->clientMutex);
+        clientWoken = true;
+    }
+    clientCondition.notify_one();
+}
+
+void LoopbackChannel::setOwner(ServerShard *shard) {
+    std::lock_guard<std::mutex> lock(this->ownerMutex);
+    owner = shard;
+}
+
+bool LoopbackChannel::sendToClient(SharedFrame frame) {
+    if (toClient.tryPush(std::move(frame))) {
+        this->wakeClient();
+        return true;
+    }
+
+    serverWaitingForSpace = true;
+    // The client may have drained everything between the failed push and setting the flag
+    if (!toClient.tryPush(std::move(frame))) {
+        return false;
+    }
+    this->wakeClient();
+    return true;
+}
+
+bool LoopbackChannel::receiveFromClient(SharedFrame &outFrame) {
+    return toServer.tryPop(outFrame);
+}
+
+void LoopbackChannel::closeFromServer() {
+    closedByServer = true;
+    this->wakeClient();
+}
+
+bool LoopbackChannel::isClosedByClient() const {
+    return closedByClient;
+}
+
+void LoopbackChannel::wakeOwner() {
+    std::lock_guard<std::mutex> lock(this->ownerMutex);
+    if (owner != nullptr) {
+        owner->wakeup();
+    }
+}
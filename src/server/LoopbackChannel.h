@@ -0,0 +1,114 @@
+#ifndef TICTACTOEOVERLAN_LOOPBACKCHANNEL_H
+#define TICTACTOEOVERLAN_LOOPBACKCHANNEL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "OutboundQueue.h"
+#include "../common/SocketLayer.h"
+#include "../common/SpscQueue.h"
+
+class ServerShard;
+
+/**
+ * @brief In-process connection between the hosting client and its own InternalGameServer.
+ * <br> Replaces the TCP loopback socket: encoded frames are handed over by reference through two
+ * lock-free single-producer/single-consumer queues, so nothing is copied through the kernel.
+ * <br> The server keys its clients by socket, so every channel gets a synthetic `handle` that can't collide
+ * with a real socket. Sending to the server wakes the shard that currently owns the client,
+ * sending to the client wakes its I/O thread.
+ */
+class LoopbackChannel {
+public:
+    constexpr static size_t QUEUE_CAPACITY = 256; //Frames per direction
+
+private:
+    const SOCKET handle;
+
+    SpscQueue<SharedFrame, QUEUE_CAPACITY> toServer;
+    SpscQueue<SharedFrame, QUEUE_CAPACITY> toClient;
+
+    std::atomic<bool> closedByClient = false;
+    std::atomic<bool> closedByServer = false;
+    std::atomic<bool> serverWaitingForSpace = false; //The server couldn't push, wake it once the client drained
+
+    // Only guards the owner pointer, so a shard can't go away while the client thread is waking it
+    std::mutex ownerMutex;
+    ServerShard *owner = nullptr;
+
+    std::mutex clientMutex;
+    std::condition_variable clientCondition;
+    bool clientWoken = false; //Set by `wakeClient`, consumed by the next `waitForServer`
+
+public:
+    LoopbackChannel();
+
+    /**
+     * @return The synthetic socket the server identifies this connection by.
+     */
+    SOCKET getHandle() const;
+
+    // Client side
+
+    /**
+     * @brief Hands an encoded frame to the server and wakes the shard owning the connection.
+     *
+     * @return False if the connection is closed or the server is too far behind.
+     */
+    bool sendToServer(SharedFrame frame);
+
+    /**
+     * @brief Takes the next frame the server sent.
+     *
+     * @return False if nothing is waiting.
+     */
+    bool receiveFromServer(SharedFrame &outFrame);
+
+    /**
+     * @brief Closes the connection from the client side, the server drops the client on its next tick.
+     */
+    void closeFromClient();
+
+    bool isClosedByServer() const;
+
+    /**
+     * @brief Blocks until the server sent something or closed the connection since the last call,
+     * or `wakeClient` was called.
+     */
+    void waitForServer();
+
+    /**
+     * @brief Makes the client's current or next `waitForServer` return, callable from any thread.
+     */
+    void wakeClient();
+
+    // Server side
+
+    /**
+     * @brief Sets the shard that gets woken when the client sends something, nullptr while in transit between shards.
+     */
+    void setOwner(ServerShard *shard);
+
+    /**
+     * @brief Hands an encoded frame to the client and wakes it.
+     *
+     * @return False if the client hasn't drained the queue yet, it wakes the owner once it does.
+     */
+    bool sendToClient(SharedFrame frame);
+
+    bool receiveFromClient(SharedFrame &outFrame);
+
+    /**
+     * @brief Closes the connection from the server side and wakes the client to notice it.
+     */
+    void closeFromServer();
+
+    bool isClosedByClient() const;
+
+private:
+    void wakeOwner();
+};
+
+
+#endif //TICTACTOEOVERLAN_LOOPBACKCHANNEL_H
@@ -0,0 +1,140 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        this->close();
+        view = std::exchange(other.view, nullptr);
+        mappedSize = std::exchange(other.mappedSize, 0);
+#ifdef _WIN32
+        fileHandle = std::exchange(other.fileHandle, nullptr);
+        mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#else
+        fileDescriptor = std::exchange(other.fileDescriptor, -1);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path, const size_t size) {
+    this->close();
+    if (size == 0) return false;
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    fileHandle = file;
+
+    // Mapping more than the file holds grows it, the new bytes read as zero
+    const auto size64 = static_cast<unsigned long long>(size);
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                       static_cast<DWORD>(size64 & 0xFFFFFFFF), nullptr);
+    if (mapping == nullptr) {
+        this->close();
+        return false;
+    }
+    mappingHandle = mapping;
+
+    view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr) {
+        this->close();
+        return false;
+    }
+    mappedSize = size;
+    return true;
+}
+
+bool MappedFile::flush(const size_t offset, const size_t length) const {
+    if (view == nullptr || length == 0) return view != nullptr;
+    return FlushViewOfFile(this->data() + offset, length) != 0;
+}
+
+bool MappedFile::sync() const {
+    if (view == nullptr) return false;
+    return FlushViewOfFile(view, mappedSize) != 0 && FlushFileBuffers(static_cast<HANDLE>(fileHandle)) != 0;
+}
+
+void MappedFile::close() {
+    if (view != nullptr) UnmapViewOfFile(view);
+    if (mappingHandle != nullptr) CloseHandle(static_cast<HANDLE>(mappingHandle));
+    if (fileHandle != nullptr) CloseHandle(static_cast<HANDLE>(fileHandle));
+    view = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    mappedSize = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string &path, const size_t size) {
+    this->close();
+    if (size == 0) return false;
+
+    fileDescriptor = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+
+    // Extending with ftruncate leaves a sparse hole, the zeros don't take up any disk until written
+    struct stat status{};
+    if (fstat(fileDescriptor, &status) != 0
+        || (static_cast<size_t>(status.st_size) < size && ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0)) {
+        this->close();
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    view = mapped;
+    mappedSize = size;
+    return true;
+}
+
+bool MappedFile::flush(const size_t offset, const size_t length) const {
+    if (view == nullptr || length == 0) return view != nullptr;
+
+    // msync wants a page aligned start
+    static const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t start = offset / pageSize * pageSize;
+    return msync(this->data() + start, offset + length - start, MS_ASYNC) == 0;
+}
+
+bool MappedFile::sync() const {
+    if (view == nullptr) return false;
+    return msync(view, mappedSize, MS_SYNC) == 0;
+}
+
+void MappedFile::close() {
+    if (view != nullptr) munmap(view, mappedSize);
+    if (fileDescriptor >= 0) ::close(fileDescriptor);
+    view = nullptr;
+    fileDescriptor = -1;
+    mappedSize = 0;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef TICTACTOEOVERLAN_MAPPEDFILE_H
+#define TICTACTOEOVERLAN_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A file mapped into memory for reading and writing, mmap on POSIX and a file mapping on Windows.
+ * <br> Writes to `data` land in the page cache right away, without a system call, and survive the process
+ * crashing. `flush` asks the OS to write them to the disk, which it otherwise does on its own schedule.
+ */
+class MappedFile {
+    void *view = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr; //HANDLE, kept as void* so the header doesn't need windows.h
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+
+public:
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    /**
+     * @brief Maps the first `size` bytes of a file, closing whatever was mapped before.
+     * <br> The file is created if it doesn't exist and zero-extended if it's shorter, never truncated.
+     *
+     * @param path The file to map.
+     * @param size How many bytes to map, more than 0.
+     * @return False if the file couldn't be opened or mapped.
+     */
+    bool open(const std::string &path, size_t size);
+
+    /**
+     * @brief Starts writing the dirty pages in `[offset, offset + length)` to the disk, without waiting for it.
+     *
+     * @return False if the OS refused.
+     */
+    bool flush(size_t offset, size_t length) const;
+
+    /**
+     * @brief Writes every dirty page to the disk and waits until it's there.
+     *
+     * @return False if the OS refused.
+     */
+    bool sync() const;
+
+    /**
+     * @brief Unmaps and closes the file, the written data stays in it.
+     */
+    void close();
+
+    bool isOpen() const {
+        return view != nullptr;
+    }
+
+    char *data() const {
+        return static_cast<char *>(view);
+    }
+
+    size_t size() const {
+        return mappedSize;
+    }
+};
+
+
+#endif //TICTACTOEOVERLAN_MAPPEDFILE_H
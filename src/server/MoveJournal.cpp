@@ -0,0 +1,405 @@
+#include "MoveJournal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <ranges>
+#include <unordered_map>
+
+#include "../common/Logger.h"
+#include "../common/Utils.h"
+
+namespace {
+    constexpr size_t alignRecord(const size_t size) {
+        return (size + MoveJournal::RECORD_ALIGNMENT - 1) / MoveJournal::RECORD_ALIGNMENT *
+               MoveJournal::RECORD_ALIGNMENT;
+    }
+
+    constexpr size_t FIRST_RECORD_OFFSET = alignRecord(sizeof(JournalSegmentHeader));
+
+    uint32_t fnv1a(const void *data, const size_t size, uint32_t hash = 2166136261u) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t recordChecksum(JournalRecordHeader header, const void *payload) {
+        header.checksum = 0;
+        return fnv1a(payload, header.payloadSize, fnv1a(&header, sizeof(header)));
+    }
+
+    /**
+     * @return The epoch a segment belongs to, from its `<epoch>-<shard>-<segment>` file name.
+     */
+    bool parseEpoch(const std::filesystem::path &path, uint32_t &outEpoch) {
+        return std::sscanf(path.filename().string().c_str(), "%u-", &outEpoch) == 1;
+    }
+
+    struct RecordView {
+        JournalRecordHeader header;
+        const char *payload; //Points into the mapped segment
+    };
+
+    template<typename T>
+    bool readPayload(const RecordView &record, T &outPayload) {
+        if (record.header.payloadSize != sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&outPayload, record.payload, sizeof(T));
+        return true;
+    }
+
+    void applySeat(GameRoom &room, const JournalSeat &record) {
+        if (record.isHost) room.hostingPlayerId = record.playerId;
+
+        auto seat = std::ranges::find_if(room.reservedSeats, [&](const ReservedSeat &reserved) {
+            return reserved.playerId == record.playerId;
+        });
+        if (seat == room.reservedSeats.end()) {
+            std::erase(room.availablePieces, record.piece);
+            seat = room.reservedSeats.insert(room.reservedSeats.end(), ReservedSeat{});
+        }
+
+        seat->playerId = record.playerId;
+        seat->piece = record.piece;
+        seat->isHost = record.isHost != 0;
+        seat->wins = record.wins;
+        seat->playerToken = record.playerToken;
+        std::memcpy(seat->playerName, record.playerName, MAX_PLAYER_NAME_LENGTH);
+        seat->playerName[MAX_PLAYER_NAME_LENGTH - 1] = '\0';
+    }
+
+    void applySeatLeft(GameRoom &room, const JournalSeatLeft &record) {
+        const auto seat = std::ranges::find_if(room.reservedSeats, [&](const ReservedSeat &reserved) {
+            return reserved.playerId == record.playerId;
+        });
+        if (seat == room.reservedSeats.end()) {
+            return;
+        }
+
+        room.availablePieces.push_back(seat->piece);
+        room.reservedSeats.erase(seat);
+        if (room.hostingPlayerId == record.playerId) room.hostingPlayerId = 0;
+        // Leaving ends the game for everyone
+        room.gameInProgress = false;
+    }
+
+    void applyRoomState(GameRoom &room, const JournalRoomState &record) {
+        room.boardData.boardSize = record.boardSize;
+        room.boardData.winConditionLength = record.winConditionLength;
+        room.boardData.round = record.round;
+        room.boardData.turn = record.turn;
+        room.boardData.actingPlayerId = record.actingPlayerId;
+        room.hostingPlayerId = record.hostingPlayerId;
+        room.gameInProgress = (record.flags & JournalRoomState::IN_GAME) != 0;
+
+        if (record.flags & JournalRoomState::RESET_BOARD) {
+            room.moves.clear();
+        }
+        if (record.flags & JournalRoomState::RESET_WINS) {
+            for (auto &seat: room.reservedSeats) {
+                seat.wins = 0;
+            }
+        }
+    }
+
+    void applyMove(GameRoom &room, const JournalMove &record) {
+        room.moves.emplace_back(record.piece, record.playerId, record.turnPlaced, record.posX, record.posY);
+        room.boardData.turn = record.turnPlaced + 1;
+        room.boardData.actingPlayerId = record.nextActingPlayerId;
+    }
+
+    /**
+     * @brief Lays the recovered moves out on a fresh board, the board itself is never journaled.
+     */
+    void rebuildBoard(GameRoom &room) {
+        Utils::initializeGameBoard(room.boardData);
+        for (const Move &move: room.moves) {
+            // The board may have been resized after the last game, its old moves are history only then
+            if (move.posX >= room.boardData.boardSize || move.posY >= room.boardData.boardSize) continue;
+
+            BoardSquare square{};
+            square.piece = move.piece;
+            square.playerId = move.playerId;
+            square.turnPlaced = move.turnPlaced;
+            room.boardData.setSquareAt(move.posX, move.posY, square);
+        }
+        room.moveSequence = static_cast<uint32_t>(room.moves.size());
+    }
+}
+
+bool MoveJournal::open(const std::string &journalDirectory, const uint32_t journalEpoch,
+                       const size_t journalShardIndex) {
+    this->close();
+    directory = journalDirectory;
+    epoch = journalEpoch;
+    shardIndex = journalShardIndex;
+    segmentIndex = 0;
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error || !this->openSegment()) {
+        LOG_ERROR(SERVER, ANSI_RED "[MoveJournal] Couldn't create a segment in '%s'.\n" ANSI_RESET,
+                  directory.c_str());
+        return false;
+    }
+    return true;
+}
+
+void MoveJournal::append(const JournalRecordType type, const uint32_t roomId, const uint64_t sequence) {
+    this->appendRaw(type, roomId, sequence, nullptr, 0);
+}
+
+void MoveJournal::appendRaw(const JournalRecordType type, const uint32_t roomId, const uint64_t sequence,
+                            const void *payload, const size_t payloadSize) {
+    if (!segment.isOpen()) {
+        return;
+    }
+
+    const size_t recordSize = alignRecord(sizeof(JournalRecordHeader) + payloadSize);
+    if (writeOffset + recordSize > segment.size()) {
+        // The only system calls of the write path, once every few thousand games
+        segment.flush(flushedOffset, writeOffset - flushedOffset);
+        ++segmentIndex;
+        if (!this->openSegment()) {
+            LOG_ERROR(SERVER, ANSI_RED "[MoveJournal] Couldn't create segment %u, journaling is off.\n" ANSI_RESET,
+                      segmentIndex);
+            return;
+        }
+    }
+
+    JournalRecordHeader header{};
+    header.sequence = sequence;
+    header.roomId = roomId;
+    header.payloadSize = static_cast<uint16_t>(payloadSize);
+    header.type = type;
+    header.checksum = recordChecksum(header, payload);
+
+    // The padding is still zero, segments are fresh files
+    char *record = segment.data() + writeOffset;
+    if (payloadSize > 0) std::memcpy(record + sizeof(header), payload, payloadSize);
+    std::memcpy(record, &header, sizeof(header));
+    writeOffset += recordSize;
+}
+
+void MoveJournal::flush(const uint64_t nowMs) {
+    if (writeOffset == flushedOffset || nowMs - lastFlushMs < FLUSH_INTERVAL_MS) {
+        return;
+    }
+
+    segment.flush(flushedOffset, writeOffset - flushedOffset);
+    flushedOffset = writeOffset;
+    lastFlushMs = nowMs;
+}
+
+bool MoveJournal::sync() {
+    flushedOffset = writeOffset;
+    return segment.sync();
+}
+
+void MoveJournal::close() {
+    segment.close();
+    writeOffset = 0;
+    flushedOffset = 0;
+}
+
+void MoveJournal::writeCheckpoint(const GameRoom &room, uint64_t &sequence) {
+    this->append(JournalRecordType::ROOM_CLOSED, room.roomId, ++sequence);
+    // The moves below take the counters from the last game start to where they are now
+    this->append(JournalRecordType::ROOM_STATE, room.roomId, ++sequence,
+                 roomStateRecord(room, JournalRoomState::RESET_BOARD));
+
+    for (const ReservedSeat &seat: room.reservedSeats) {
+        JournalSeat record{};
+        record.playerId = seat.playerId;
+        record.piece = seat.piece;
+        record.isHost = seat.isHost;
+        record.wins = seat.wins;
+        record.playerToken = seat.playerToken;
+        std::memcpy(record.playerName, seat.playerName, MAX_PLAYER_NAME_LENGTH);
+        this->append(JournalRecordType::SEAT, room.roomId, ++sequence, record);
+    }
+
+    for (size_t i = 0; i < room.moves.size(); ++i) {
+        const uint8_t nextActing = i + 1 < room.moves.size()
+                                       ? room.moves[i + 1].playerId
+                                       : room.boardData.actingPlayerId;
+        this->append(JournalRecordType::MOVE, room.roomId, ++sequence, moveRecord(room.moves[i], nextActing));
+    }
+}
+
+JournalRecovery MoveJournal::recover(const std::string &journalDirectory) {
+    JournalRecovery recovery;
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(journalDirectory, error)) {
+        return recovery;
+    }
+
+    // Every segment stays mapped until the replay is done, the records point into them
+    std::vector<MappedFile> segments;
+    std::vector<RecordView> records;
+    for (const auto &entry: std::filesystem::directory_iterator(journalDirectory, error)) {
+        uint32_t fileEpoch;
+        if (!entry.is_regular_file(error) || entry.path().extension() != FILE_EXTENSION
+            || !parseEpoch(entry.path(), fileEpoch)) {
+            continue;
+        }
+
+        // Counted even if unreadable, the next epoch mustn't reuse its file names
+        recovery.lastEpoch = std::max(recovery.lastEpoch, fileEpoch);
+
+        const auto fileSize = static_cast<size_t>(entry.file_size(error));
+        MappedFile file;
+        if (error || fileSize < FIRST_RECORD_OFFSET || !file.open(entry.path().string(), fileSize)) {
+            LOG_WARN(SERVER, ANSI_YELLOW "[MoveJournal] Skipping unreadable segment '%s'.\n" ANSI_RESET,
+                     entry.path().string().c_str());
+            continue;
+        }
+
+        JournalSegmentHeader segmentHeader{};
+        std::memcpy(&segmentHeader, file.data(), sizeof(segmentHeader));
+        if (segmentHeader.magic != MAGIC || segmentHeader.version != VERSION) {
+            LOG_WARN(SERVER, ANSI_YELLOW "[MoveJournal] Skipping '%s', it isn't a version %hu segment.\n" ANSI_RESET,
+                     entry.path().string().c_str(), VERSION);
+            continue;
+        }
+        ++recovery.segmentCount;
+
+        size_t offset = FIRST_RECORD_OFFSET;
+        while (offset + sizeof(JournalRecordHeader) <= fileSize) {
+            RecordView record{};
+            std::memcpy(&record.header, file.data() + offset, sizeof(record.header));
+            if (record.header.sequence == 0) {
+                break; //The end of what got written
+            }
+
+            const size_t recordSize = alignRecord(sizeof(JournalRecordHeader) + record.header.payloadSize);
+            record.payload = file.data() + offset + sizeof(JournalRecordHeader);
+            if (offset + recordSize > fileSize || recordChecksum(record.header, record.payload) !=
+                record.header.checksum) {
+                LOG_WARN(SERVER, ANSI_YELLOW "[MoveJournal] '%s' ends in a torn record, ignoring the rest.\n"
+                         ANSI_RESET, entry.path().string().c_str());
+                break;
+            }
+
+            records.push_back(record);
+            offset += recordSize;
+        }
+        segments.push_back(std::move(file));
+    }
+
+    std::ranges::sort(records, {}, [](const RecordView &record) { return record.header.sequence; });
+
+    std::unordered_map<uint32_t, std::unique_ptr<GameRoom>> rooms;
+    const auto roomFor = [&rooms](const uint32_t roomId) -> GameRoom & {
+        auto &room = rooms[roomId];
+        if (!room) room = std::make_unique<GameRoom>(roomId);
+        return *room;
+    };
+
+    for (const RecordView &record: records) {
+        const uint32_t roomId = record.header.roomId;
+        recovery.lastSequence = std::max(recovery.lastSequence, record.header.sequence);
+        ++recovery.recordCount;
+
+        switch (record.header.type) {
+            case JournalRecordType::SEAT: {
+                JournalSeat payload{};
+                if (readPayload(record, payload)) applySeat(roomFor(roomId), payload);
+                break;
+            }
+            case JournalRecordType::SEAT_LEFT: {
+                JournalSeatLeft payload{};
+                if (readPayload(record, payload) && rooms.contains(roomId)) applySeatLeft(*rooms[roomId], payload);
+                break;
+            }
+            case JournalRecordType::ROOM_STATE: {
+                JournalRoomState payload{};
+                if (readPayload(record, payload)) applyRoomState(roomFor(roomId), payload);
+                break;
+            }
+            case JournalRecordType::MOVE: {
+                JournalMove payload{};
+                if (readPayload(record, payload) && rooms.contains(roomId)) applyMove(*rooms[roomId], payload);
+                break;
+            }
+            case JournalRecordType::ROOM_CLOSED:
+                rooms.erase(roomId);
+                break;
+            default:
+                break;
+        }
+    }
+
+    for (auto &room: rooms | std::views::values) {
+        // A room whose players all left without it being closed has nothing left to restore
+        if (room->isEmpty()) continue;
+
+        rebuildBoard(*room);
+        recovery.rooms.push_back(std::move(room));
+    }
+    std::ranges::sort(recovery.rooms, {}, [](const auto &room) { return room->roomId; });
+    return recovery;
+}
+
+void MoveJournal::removeEpochsBefore(const std::string &journalDirectory, const uint32_t journalEpoch) {
+    std::error_code error;
+    for (const auto &entry: std::filesystem::directory_iterator(journalDirectory, error)) {
+        uint32_t fileEpoch;
+        if (entry.path().extension() == FILE_EXTENSION && parseEpoch(entry.path(), fileEpoch)
+            && fileEpoch < journalEpoch) {
+            std::filesystem::remove(entry.path(), error);
+        }
+    }
+}
+
+JournalRoomState MoveJournal::roomStateRecord(const GameRoom &room, const uint8_t flags) {
+    JournalRoomState record{};
+    record.flags = flags | (room.gameInProgress ? JournalRoomState::IN_GAME : 0);
+    record.boardSize = room.boardData.boardSize;
+    record.winConditionLength = room.boardData.winConditionLength;
+    record.round = room.boardData.round;
+    record.turn = room.boardData.turn;
+    record.actingPlayerId = room.boardData.actingPlayerId;
+    record.hostingPlayerId = room.hostingPlayerId;
+    return record;
+}
+
+JournalMove MoveJournal::moveRecord(const Move &move, const uint8_t nextActingPlayerId) {
+    JournalMove record{};
+    record.piece = move.piece;
+    record.playerId = move.playerId;
+    record.turnPlaced = move.turnPlaced;
+    record.posX = move.posX;
+    record.posY = move.posY;
+    record.nextActingPlayerId = nextActingPlayerId;
+    return record;
+}
+
+bool MoveJournal::openSegment() {
+    if (!segment.open(this->segmentPath(segmentIndex), SEGMENT_SIZE)) {
+        return false;
+    }
+
+    JournalSegmentHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.shardIndex = static_cast<uint16_t>(shardIndex);
+    header.epoch = epoch;
+    header.segmentIndex = segmentIndex;
+    std::memcpy(segment.data(), &header, sizeof(header));
+
+    writeOffset = FIRST_RECORD_OFFSET;
+    flushedOffset = 0;
+    return true;
+}
+
+std::string MoveJournal::segmentPath(const uint32_t segment) const {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%08u-%04zu-%06u%s", epoch, shardIndex, segment, FILE_EXTENSION);
+    return (std::filesystem::path(directory) / name).string();
+}
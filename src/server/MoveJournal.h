@@ -0,0 +1,228 @@
+#ifndef TICTACTOEOVERLAN_MOVEJOURNAL_H
+#define TICTACTOEOVERLAN_MOVEJOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GameRoom.h"
+#include "MappedFile.h"
+#include "../common/GameDefinitions.h"
+#include "../common/NetworkProtocol.h"
+
+/**
+ * @brief What a journal record describes, every type has its own payload struct.
+ */
+enum class JournalRecordType : uint8_t {
+    NONE, // Zeroed space past the last record of a segment
+    SEAT, // A player took a seat or its wins changed: JournalSeat
+    SEAT_LEFT, // A player left the room for good: JournalSeatLeft
+    ROOM_STATE, // Settings and counters, optionally starting a new game: JournalRoomState
+    MOVE, // A move the server accepted: JournalMove
+    ROOM_CLOSED // The room got destroyed, no payload
+};
+
+#pragma pack(push, 1)
+
+/**
+ * @brief The first bytes of every segment file.
+ */
+struct JournalSegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t shardIndex;
+    uint32_t epoch;
+    uint32_t segmentIndex;
+};
+
+/**
+ * @brief Prepended to every record, the record is padded to `MoveJournal::RECORD_ALIGNMENT` bytes.
+ */
+struct JournalRecordHeader {
+    uint64_t sequence; //Global order across all shards and segments, starts at 1. 0 marks the end of a segment
+    uint32_t roomId;
+    uint32_t checksum; //FNV-1a over the header (with this field 0) and the payload, catches torn writes
+    uint16_t payloadSize;
+    JournalRecordType type;
+    uint8_t reserved;
+};
+
+struct JournalSeat {
+    uint8_t playerId;
+    PieceType piece;
+    uint8_t isHost;
+    int32_t wins;
+    int32_t playerToken; //Required to take the seat back after a crash
+    char playerName[MAX_PLAYER_NAME_LENGTH];
+};
+
+struct JournalSeatLeft {
+    uint8_t playerId;
+};
+
+struct JournalRoomState {
+    constexpr static uint8_t RESET_BOARD = 1 << 0; // A game started, the moves so far are gone
+    constexpr static uint8_t RESET_WINS = 1 << 1; // A new game, every seat's wins go back to 0
+    constexpr static uint8_t IN_GAME = 1 << 2; // The game is running after this record
+
+    uint8_t flags;
+    uint8_t boardSize;
+    uint8_t winConditionLength;
+    uint16_t round;
+    uint16_t turn;
+    uint8_t actingPlayerId;
+    uint8_t hostingPlayerId;
+};
+
+struct JournalMove {
+    PieceType piece;
+    uint8_t playerId;
+    uint16_t turnPlaced;
+    uint8_t posX;
+    uint8_t posY;
+    uint8_t nextActingPlayerId; //Whose turn it is after the move
+};
+
+#pragma pack(pop)
+
+/**
+ * @brief The rooms rebuilt from a journal directory, see `MoveJournal::recover`.
+ */
+struct JournalRecovery {
+    std::vector<std::unique_ptr<GameRoom>> rooms;
+    uint64_t lastSequence = 0; //The highest sequence found, new records continue after it
+    uint32_t lastEpoch = 0; //The highest epoch found, the restarted server writes the next one
+    size_t segmentCount = 0;
+    size_t recordCount = 0;
+};
+
+/**
+ * @brief Append-only binary journal of one shard's accepted moves and room events, for crash recovery.
+ * <br> Records are written into a memory-mapped segment file of `SEGMENT_SIZE` bytes, appending is a memcpy into
+ * the mapping and never a system call. Once per `FLUSH_INTERVAL_MS` the shard asks the OS to write the new bytes out.
+ * A crash of the process loses nothing, the pages already belong to the file. A crash of the machine loses at most
+ * what the OS hadn't written back yet.
+ * <br> Segments are named `<epoch>-<shard>-<segment>.journal`. Every server start is a new epoch: the old segments
+ * are replayed into rooms, written back compacted as the new epoch's first records and then deleted.
+ * <br> Owned and used by a single thread.
+ */
+class MoveJournal {
+public:
+    constexpr static size_t SEGMENT_SIZE = 4 * 1024 * 1024; //A full 32x32 game is ~33KB of moves
+    constexpr static uint64_t FLUSH_INTERVAL_MS = 100;
+    constexpr static size_t RECORD_ALIGNMENT = 8;
+    constexpr static uint32_t MAGIC = 0x4A545454; //"TTTJ"
+    constexpr static uint16_t VERSION = 2;
+    constexpr static auto FILE_EXTENSION = ".journal";
+
+private:
+    std::string directory;
+    uint32_t epoch = 0;
+    size_t shardIndex = 0;
+    uint32_t segmentIndex = 0;
+
+    MappedFile segment;
+    size_t writeOffset = 0; //Where the next record goes
+    size_t flushedOffset = 0; //Everything before this was handed to the OS by `flush`
+    uint64_t lastFlushMs = 0;
+
+public:
+    /**
+     * @brief Creates the directory if needed and maps the shard's first segment of the epoch.
+     *
+     * @param journalDirectory Where the segments are kept.
+     * @param journalEpoch The current server start, from `JournalRecovery::lastEpoch` + 1.
+     * @param journalShardIndex The owning shard, part of the file names.
+     * @return False if the segment couldn't be created, the journal then stays closed.
+     */
+    bool open(const std::string &journalDirectory, uint32_t journalEpoch, size_t journalShardIndex);
+
+    bool isOpen() const {
+        return segment.isOpen();
+    }
+
+    /**
+     * @brief Appends a record, moving on to a new segment if the current one is full. Ignored while closed.
+     *
+     * @param type The record type, has to match the payload.
+     * @param roomId The room the record belongs to.
+     * @param sequence The record's place in the global order.
+     * @param payload The payload struct.
+     */
+    template<typename T>
+    void append(const JournalRecordType type, const uint32_t roomId, const uint64_t sequence, const T &payload) {
+        this->appendRaw(type, roomId, sequence, &payload, sizeof(T));
+    }
+
+    /**
+     * @brief Appends a record without a payload, i.e. ROOM_CLOSED.
+     */
+    void append(JournalRecordType type, uint32_t roomId, uint64_t sequence);
+
+    /**
+     * @brief Hands the records appended since the last flush to the OS, at most once per `FLUSH_INTERVAL_MS`.
+     * <br> Called at the end of every tick, doesn't wait for the disk.
+     *
+     * @param nowMs The current time, from `TimerWheel::monotonicMs`.
+     */
+    void flush(uint64_t nowMs);
+
+    /**
+     * @brief Writes everything appended so far to the disk and waits until it's there.
+     *
+     * @return False if the OS refused or the journal is closed.
+     */
+    bool sync();
+
+    void close();
+
+    /**
+     * @brief Appends everything needed to rebuild the room on its own: its state, its seats and the moves since
+     * the last game start. Preceded by a ROOM_CLOSED, so older records of the room no longer matter.
+     *
+     * @param room The room to write.
+     * @param sequence The last sequence handed out, advanced by one per record.
+     */
+    void writeCheckpoint(const GameRoom &room, uint64_t &sequence);
+
+    /**
+     * @brief Reads every segment in the directory, replays the records in sequence order and rebuilds the rooms.
+     * <br> A segment is read up to its first empty or corrupt record, like the one a crash tore in half.
+     * <br> Recovered rooms keep their seats as `reservedSeats` until the players come back.
+     *
+     * @param journalDirectory Where the segments are kept, a missing directory recovers nothing.
+     * @return The rooms and where the sequence and epoch continue.
+     */
+    static JournalRecovery recover(const std::string &journalDirectory);
+
+    /**
+     * @brief Deletes the segments of every epoch before the given one.
+     */
+    static void removeEpochsBefore(const std::string &journalDirectory, uint32_t journalEpoch);
+
+    /**
+     * @return The state record of the room, with IN_GAME set if a game is running.
+     */
+    static JournalRoomState roomStateRecord(const GameRoom &room, uint8_t flags);
+
+    /**
+     * @return The record of a move, `nextActingPlayerId` is whose turn it is after it.
+     */
+    static JournalMove moveRecord(const Move &move, uint8_t nextActingPlayerId);
+
+private:
+    void appendRaw(JournalRecordType type, uint32_t roomId, uint64_t sequence, const void *payload,
+                   size_t payloadSize);
+
+    /**
+     * @brief Maps segment `segmentIndex` of the epoch and writes its header.
+     */
+    bool openSegment();
+
+    std::string segmentPath(uint32_t segment) const;
+};
+
+
+#endif //TICTACTOEOVERLAN_MOVEJOURNAL_H
@@ -0,0 +1,60 @@
+#include "OutboundQueue.h"
+
+void OutboundQueue::push(SharedFrame frame, const size_t alreadySent) {
+    if (frames.empty()) {
+        frontOffset = alreadySent;
+    }
+    queuedBytes += frame->size() - alreadySent;
+    frames.push_back(std::move(frame));
+}
+
+void OutboundQueue::pushFront(SharedFrame frame) {
+    // Only the front frame can be partially sent, it keeps just its unsent bytes once it's no longer in front
+    if (frontOffset > 0) {
+        const std::vector<char> &oldFront = *frames.front();
+        frames.front() = std::make_shared<const std::vector<char>>(oldFront.begin() + static_cast<long>(frontOffset),
+                                                                   oldFront.end());
+        frontOffset = 0;
+    }
+    queuedBytes += frame->size();
+    frames.push_front(std::move(frame));
+}
+
+size_t OutboundQueue::gather(IoSlice *outSlices, const size_t maxSlices) const {
+    size_t count = 0;
+    for (const auto &frame: frames) {
+        if (count == maxSlices) break;
+
+        const size_t offset = count == 0 ? frontOffset : 0;
+        outSlices[count++] = {frame->data() + offset, frame->size() - offset, &frame};
+    }
+    return count;
+}
+
+const SharedFrame &OutboundQueue::front() const {
+    return frames.front();
+}
+
+void OutboundQueue::consume(size_t count) {
+    queuedBytes -= count;
+
+    while (count > 0) {
+        const size_t frontLeft = frames.front()->size() - frontOffset;
+        if (count < frontLeft) {
+            frontOffset += count;
+            return;
+        }
+
+        count -= frontLeft;
+        frames.pop_front();
+        frontOffset = 0;
+    }
+}
+
+size_t OutboundQueue::size() const {
+    return queuedBytes;
+}
+
+bool OutboundQueue::empty() const {
+    return frames.empty();
+}
@@ -0,0 +1,66 @@
+#ifndef TICTACTOEOVERLAN_OUTBOUNDQUEUE_H
+#define TICTACTOEOVERLAN_OUTBOUNDQUEUE_H
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "EventLoop.h"
+
+/**
+ * @brief Frames waiting to be sent to a client whose socket couldn't take them right away.
+ * <br> Frames are queued by reference, never copied, and handed to the socket as one gathered write.
+ */
+class OutboundQueue {
+    std::deque<SharedFrame> frames;
+    size_t frontOffset = 0; //Bytes of the front frame that were already sent
+    size_t queuedBytes = 0;
+
+public:
+    /**
+     * @brief Appends a frame to the back of the queue.
+     *
+     * @param frame The frame to send.
+     * @param alreadySent How many bytes from the start of the frame were already sent.
+     */
+    void push(SharedFrame frame, size_t alreadySent = 0);
+
+    /**
+     * @brief Puts a frame in front of everything queued, for bytes that were due before them.
+     *
+     * @param frame The frame to send first.
+     */
+    void pushFront(SharedFrame frame);
+
+    /**
+     * @brief Describes the unsent bytes from the front of the queue, one slice per frame.
+     *
+     * @param outSlices Array the slices get written to.
+     * @param maxSlices Capacity of `outSlices`.
+     * @return The number of slices written.
+     */
+    size_t gather(IoSlice *outSlices, size_t maxSlices) const;
+
+    /**
+     * @return The front frame, the queue must not be empty.
+     */
+    const SharedFrame &front() const;
+
+    /**
+     * @brief Drops bytes from the front after they were sent, releasing fully sent frames.
+     *
+     * @param count Number of bytes sent, at most `size`.
+     */
+    void consume(size_t count);
+
+    /**
+     * @return Number of bytes still waiting to be sent.
+     */
+    size_t size() const;
+
+    bool empty() const;
+};
+
+
+#endif //TICTACTOEOVERLAN_OUTBOUNDQUEUE_H
@@ -0,0 +1,66 @@
+#include "ReplayWriter.h"
+
+#include <cstdio>
+#include <filesystem>
+
+#include "../common/Logger.h"
+#include "../common/ReplayFile.h"
+#include "../common/Utils.h"
+
+ReplayWriter::~ReplayWriter() {
+    this->stop();
+}
+
+void ReplayWriter::start() {
+    std::lock_guard<std::mutex> lock(this->queueMutex);
+    if (running) {
+        return;
+    }
+
+    running = true;
+    writer = std::thread(&ReplayWriter::run, this);
+}
+
+void ReplayWriter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        running = false;
+    }
+    queueCondition.notify_one();
+
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void ReplayWriter::enqueue(std::string path, std::vector<uint8_t> bytes) {
+    {
+        std::lock_guard<std::mutex> lock(this->queueMutex);
+        queue.push_back({std::move(path), std::move(bytes)});
+    }
+    queueCondition.notify_one();
+}
+
+void ReplayWriter::run() {
+    std::unique_lock<std::mutex> lock(this->queueMutex);
+    while (true) {
+        queueCondition.wait(lock, [this] { return !queue.empty() || !running; });
+        if (queue.empty()) {
+            return;
+        }
+
+        PendingReplay replay = std::move(queue.front());
+        queue.pop_front();
+
+        // The disk is slow, the shards keep queueing meanwhile
+        lock.unlock();
+        const std::string fileName = std::filesystem::path(replay.path).filename().string();
+        if (ReplayFile::write(replay.path, replay.bytes)) {
+            LOG_DEBUG(SERVER, ANSI_CYAN "[ReplayWriter] Wrote %s (%zu bytes)\n" ANSI_RESET, fileName.c_str(),
+                      replay.bytes.size());
+        } else {
+            LOG_WARN(SERVER, ANSI_YELLOW "[ReplayWriter] Couldn't write the replay %s\n" ANSI_RESET, fileName.c_str());
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef TICTACTOEOVERLAN_REPLAYWRITER_H
+#define TICTACTOEOVERLAN_REPLAYWRITER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Writes archived games to disk on a thread of its own, a finished game never makes a shard wait for the disk.
+ * <br> The shards hand over files they already encoded with `ReplayFile::encode`, the writer stores them in order.
+ * <br> `stop` still writes everything queued before it returns.
+ */
+class ReplayWriter {
+    struct PendingReplay {
+        std::string path;
+        std::vector<uint8_t> bytes;
+    };
+
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    std::deque<PendingReplay> queue;
+    bool running = false;
+
+    std::thread writer;
+
+public:
+    ReplayWriter() = default;
+
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter &) = delete;
+
+    ReplayWriter &operator=(const ReplayWriter &) = delete;
+
+    /**
+     * @brief Starts the writer thread.
+     */
+    void start();
+
+    /**
+     * @brief Writes what's still queued and joins the writer thread.
+     */
+    void stop();
+
+    /**
+     * @brief Queues an encoded replay, from any thread.
+     *
+     * @param path The file to write, replaced if it exists.
+     * @param bytes The file contents.
+     */
+    void enqueue(std::string path, std::vector<uint8_t> bytes);
+
+private:
+    /**
+     * @brief The writer thread: writes replays as they come in until stopped and the queue is empty.
+     */
+    void run();
+};
+
+
+#endif //TICTACTOEOVERLAN_REPLAYWRITER_H
@@ -0,0 +1,93 @@
+#include "RoomManager.h"
+
+#include <ranges>
+
+GameRoom *RoomManager::acquire(const uint32_t roomId, const size_t shardIndex, size_t &outOwnerShard) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    auto &room = rooms[roomId];
+    if (!room) {
+        room = std::make_unique<GameRoom>(roomId);
+        room->ownerShard = shardIndex;
+    }
+
+    outOwnerShard = room->ownerShard;
+    return room->ownerShard == shardIndex && !room->inTransit ? room.get() : nullptr;
+}
+
+GameRoom *RoomManager::findOwned(const uint32_t roomId, const size_t shardIndex) const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    const auto it = rooms.find(roomId);
+    if (it == rooms.end() || it->second->ownerShard != shardIndex || it->second->inTransit) {
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+GameRoom *RoomManager::find(const uint32_t roomId) const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    const auto it = rooms.find(roomId);
+    return it == rooms.end() ? nullptr : it->second.get();
+}
+
+void RoomManager::beginTransfer(const uint32_t roomId, const size_t newOwnerShard) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    const auto it = rooms.find(roomId);
+    if (it != rooms.end()) {
+        it->second->ownerShard = newOwnerShard;
+        it->second->inTransit = true;
+    }
+}
+
+void RoomManager::finishTransfer(const uint32_t roomId) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    const auto it = rooms.find(roomId);
+    if (it != rooms.end()) {
+        it->second->inTransit = false;
+    }
+}
+
+bool RoomManager::removeIfEmpty(const uint32_t roomId) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    const auto it = rooms.find(roomId);
+    if (it != rooms.end() && it->second->isEmpty()) {
+        rooms.erase(it);
+        return true;
+    }
+    return false;
+}
+
+void RoomManager::restore(std::unique_ptr<GameRoom> room, const size_t ownerShard) {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    room->ownerShard = ownerShard;
+    room->inTransit = false;
+    const uint32_t roomId = room->roomId;
+    rooms[roomId] = std::move(room);
+}
+
+void RoomManager::clear() {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    rooms.clear();
+}
+
+size_t RoomManager::size() const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+    return rooms.size();
+}
+
+std::vector<uint32_t> RoomManager::getRoomIds() const {
+    std::lock_guard<std::mutex> lock(this->mtx);
+
+    std::vector<uint32_t> roomIds;
+    roomIds.reserve(rooms.size());
+    for (const auto &roomId: rooms | std::views::keys) {
+        roomIds.push_back(roomId);
+    }
+    return roomIds;
+}
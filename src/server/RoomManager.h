@@ -0,0 +1,98 @@
+#ifndef TICTACTOEOVERLAN_ROOMMANAGER_H
+#define TICTACTOEOVERLAN_ROOMMANAGER_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "GameRoom.h"
+
+/**
+ * @brief Registry of all rooms hosted by one InternalGameServer.
+ * <br> Rooms are created on the first join and destroyed once their last member leaves,
+ * or restored from the move journal when the server starts after a crash.
+ * <br> Rooms are heap allocated, so references stay valid while other rooms come and go.
+ * <br> Every room is owned by one `ServerShard`. Only the owner may read or modify the room's contents,
+ * delete it or hand it to another shard.
+ * <br> Thread-safe: the map and the owner field are guarded by a mutex, the room contents are not.
+ */
+class RoomManager {
+    std::unordered_map<uint32_t, std::unique_ptr<GameRoom> > rooms;
+    mutable std::mutex mtx;
+
+public:
+    /**
+     * @brief Finds a room for a joining client, creating it on the calling shard if it doesn't exist yet.
+     *
+     * @param roomId The requested room ID.
+     * @param shardIndex The shard asking for the room.
+     * @param outOwnerShard Set to the index of the shard that owns the room.
+     * @return The room if it's owned by `shardIndex` and not moving, nullptr if the client has to move to `outOwnerShard`.
+     */
+    GameRoom *acquire(uint32_t roomId, size_t shardIndex, size_t &outOwnerShard);
+
+    /**
+     * @brief Finds a room owned by the given shard.
+     *
+     * @param roomId The requested room ID.
+     * @param shardIndex The shard asking for the room.
+     * @return The room, or nullptr if it doesn't exist, is moving or belongs to another shard.
+     */
+    GameRoom *findOwned(uint32_t roomId, size_t shardIndex) const;
+
+    /**
+     * @brief Finds an existing room regardless of its owner.
+     * <br> Only meant for debug telemetry, the contents may be changing while they are read.
+     *
+     * @param roomId The requested room ID.
+     * @return The room, or nullptr if there is no room with this ID.
+     */
+    GameRoom *find(uint32_t roomId) const;
+
+    /**
+     * @brief Makes another shard the owner of a room, which stays unavailable until `finishTransfer`.
+     * <br> Clients joining in the meantime are sent to the new owner.
+     *
+     * @param roomId The room to move.
+     * @param newOwnerShard The index of the new owner.
+     */
+    void beginTransfer(uint32_t roomId, size_t newOwnerShard);
+
+    /**
+     * @brief Makes a moved room available again. Called by the new owner once it has adopted the members.
+     *
+     * @param roomId The moved room.
+     */
+    void finishTransfer(uint32_t roomId);
+
+    /**
+     * @brief Destroys the room if nobody is left in it and no seat is reserved. Must be called by the current owner.
+     *
+     * @param roomId The room to check.
+     * @return True if the room got destroyed.
+     */
+    bool removeIfEmpty(uint32_t roomId);
+
+    /**
+     * @brief Adds a room rebuilt from the move journal, replacing any room with the same ID.
+     * <br> Only while no shard is running.
+     *
+     * @param room The recovered room.
+     * @param ownerShard The index of the shard that gets the room.
+     */
+    void restore(std::unique_ptr<GameRoom> room, size_t ownerShard);
+
+    /**
+     * @brief Destroys all rooms.
+     */
+    void clear();
+
+    size_t size() const;
+
+    std::vector<uint32_t> getRoomIds() const;
+};
+
+
+#endif //TICTACTOEOVERLAN_ROOMMANAGER_H
@@ -0,0 +1,121 @@
+#include "SelectEventLoop.h"
+
+#include <algorithm>
+
+SelectEventLoop::SelectEventLoop() {
+    wakeSocket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (wakeSocket == INVALID_SOCKET) {
+        return;
+    }
+
+    // Bound to a free loopback port and connected to itself, so `wakeup` can just send to it
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+
+    if (bind(wakeSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR
+        || getsockname(wakeSocket, reinterpret_cast<sockaddr *>(&address), &addressLength) == SOCKET_ERROR
+        || connect(wakeSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == SOCKET_ERROR
+        || !SocketLayer::setNonBlocking(wakeSocket)) {
+        SocketLayer::close(wakeSocket);
+        wakeSocket = INVALID_SOCKET;
+    }
+}
+
+SelectEventLoop::~SelectEventLoop() {
+    if (wakeSocket != INVALID_SOCKET) {
+        SocketLayer::close(wakeSocket);
+    }
+}
+
+bool SelectEventLoop::add(const SOCKET socket, const uint8_t events) {
+    // The wake socket takes up one of the slots
+    if (registrations.size() + (wakeSocket != INVALID_SOCKET ? 1 : 0) >= FD_SETSIZE) {
+        return false;
+    }
+
+    registrations.push_back({socket, events});
+    return true;
+}
+
+bool SelectEventLoop::modify(const SOCKET socket, const uint8_t events) {
+    for (auto &registration: registrations) {
+        if (registration.socket == socket) {
+            registration.events = events;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SelectEventLoop::remove(const SOCKET socket) {
+    std::erase_if(registrations, [socket](const Registration &r) { return r.socket == socket; });
+}
+
+int SelectEventLoop::wait(std::vector<ReadyEvent> &outEvents, const int timeoutMs) {
+    outEvents.clear();
+
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+
+    SOCKET maxSocket = 0;
+    if (wakeSocket != INVALID_SOCKET) {
+        FD_SET(wakeSocket, &readSet);
+        maxSocket = wakeSocket;
+    }
+    for (const auto &registration: registrations) {
+        if (registration.events & IoEvent::READ) FD_SET(registration.socket, &readSet);
+        if (registration.events & IoEvent::WRITE) FD_SET(registration.socket, &writeSet);
+        maxSocket = std::max(maxSocket, registration.socket);
+    }
+
+    timeval timeout;
+    timeval *timeoutPtr = nullptr;
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+        timeoutPtr = &timeout;
+    }
+
+    // The first argument is ignored by Winsock, but POSIX needs the highest descriptor + 1
+    const int socketCount = select(static_cast<int>(maxSocket) + 1, &readSet, &writeSet, nullptr, timeoutPtr);
+    if (socketCount <= 0) {
+        return socketCount;
+    }
+
+    if (wakeSocket != INVALID_SOCKET && FD_ISSET(wakeSocket, &readSet)) {
+        // Several wakeups can pile up before we get here, one pass handles all of them
+        char drain[64];
+        while (::recv(wakeSocket, drain, sizeof(drain), 0) > 0) {
+        }
+    }
+
+    for (const auto &registration: registrations) {
+        uint8_t ready = IoEvent::NONE;
+        if (FD_ISSET(registration.socket, &readSet)) ready |= IoEvent::READ;
+        if (FD_ISSET(registration.socket, &writeSet)) ready |= IoEvent::WRITE;
+
+        if (ready != IoEvent::NONE) {
+            outEvents.push_back({registration.socket, ready});
+        }
+    }
+
+    return static_cast<int>(outEvents.size());
+}
+
+void SelectEventLoop::wakeup() {
+    if (wakeSocket == INVALID_SOCKET) {
+        return; //The 10ms idle timeout covers it
+    }
+
+    constexpr char signal = 1;
+    ::send(wakeSocket, &signal, sizeof(signal), 0);
+}
+
+int SelectEventLoop::idleTimeoutMs() const {
+    return wakeSocket != INVALID_SOCKET ? -1 : 10; //10ms between os polls if we can't be woken up
+}
@@ -0,0 +1,42 @@
+#ifndef TICTACTOEOVERLAN_SELECTEVENTLOOP_H
+#define TICTACTOEOVERLAN_SELECTEVENTLOOP_H
+
+#include <vector>
+
+#include "EventLoop.h"
+
+/**
+ * @brief Portable `EventLoop` backed by `select`.
+ * <br> Keeps the registered sockets in a flat list and builds the fd_sets from it inside `wait`.
+ * <br> Limited to FD_SETSIZE sockets. `wakeup` sends a datagram to a UDP socket bound to loopback,
+ * which is part of every select. Without it (it couldn't be created) the loop is polled with a short timeout.
+ */
+class SelectEventLoop final : public EventLoop {
+    struct Registration {
+        SOCKET socket;
+        uint8_t events;
+    };
+
+    std::vector<Registration> registrations;
+    SOCKET wakeSocket = INVALID_SOCKET; //Connected to itself, `wakeup` makes it readable
+
+public:
+    SelectEventLoop();
+
+    ~SelectEventLoop() override;
+
+    bool add(SOCKET socket, uint8_t events) override;
+
+    bool modify(SOCKET socket, uint8_t events) override;
+
+    void remove(SOCKET socket) override;
+
+    int wait(std::vector<ReadyEvent> &outEvents, int timeoutMs) override;
+
+    void wakeup() override;
+
+    int idleTimeoutMs() const override;
+};
+
+
+#endif //TICTACTOEOVERLAN_SELECTEVENTLOOP_H
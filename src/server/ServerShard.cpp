@@ -0,0 +1,1578 @@
+#include "ServerShard.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <ranges>
+
+#include "InternalGameServer.h"
+#include "ServerUtils.h"
+#include "WinValidator.h"
+#include "../common/NetworkProtocol.h"
+#include "../common/Logger.h"
+#include "../common/ReplayFile.h"
+#include "../common/Tracer.h"
+#include "../common/Utils.h"
+
+namespace {
+    uint64_t monotonicUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // One span name per packet type, so a trace tells which packet a slow tick spent its time on
+    constexpr const char *PACKET_SPAN_NAMES[] = {
+        "packet SERVER_HELLO", "packet SETUP_REQ", "packet SETUP_ACK", "packet NEW_PLAYER_JOIN",
+        "packet PLAYER_DISCONNECTED", "packet SETTINGS_CHANGE_REQ", "packet SETTINGS_UPDATE", "packet GAME_START_REQ",
+        "packet GAME_START", "packet MOVE_REQ", "packet BOARD_STATE_UPDATE", "packet BACK_TO_GAME_ROOM",
+        "packet GAME_END", "packet MOVE_APPLIED", "packet PING", "packet PONG", "packet RESYNC_REQ"
+    };
+    static_assert(std::size(PACKET_SPAN_NAMES) == static_cast<size_t>(PacketType::RESYNC_REQ) + 1,
+                  "Every packet type needs a span name");
+
+    // Time left until a monotonic deadline, 0 once it passed
+    uint64_t msUntil(const uint64_t deadlineMs, const uint64_t nowMs) {
+        return deadlineMs > nowMs ? deadlineMs - nowMs : 0;
+    }
+
+    [[maybe_unused]] const char *packetSpanName(const PacketType type) {
+        const auto index = static_cast<size_t>(type);
+        return index < std::size(PACKET_SPAN_NAMES) ? PACKET_SPAN_NAMES[index] : "packet UNKNOWN";
+    }
+}
+
+ServerShard::ServerShard(InternalGameServer &server, const size_t shardIndex) : server(server),
+    shardIndex(shardIndex),
+    eventLoop(EventLoop::createDefault()) {
+}
+
+ServerShard::~ServerShard() {
+    // Connections that arrived after the loop stopped, so the client doesn't wait for a hello forever
+    for (const auto &channel: pendingLoopbackConnections) {
+        channel->closeFromServer();
+    }
+}
+
+void ServerShard::run() {
+    Tracer::setThreadName("Shard " + std::to_string(shardIndex));
+
+    while (server.keepRunning) {
+        //Packets and logic, only the sockets that are ready get touched
+        //Sleeps until a socket is ready, a timer is due or another thread wakes us
+        int socketCount;
+        {
+            TRACE_SPAN("wait");
+            socketCount = eventLoop->wait(readyEvents, this->nextWaitTimeoutMs());
+        }
+
+        //Time measuring, starts after the wait so idle time doesn't count as tick time
+        //Steady clock nanoseconds, the same clock the trace spans use
+        const uint64_t startTime = Tracer::nowNs();
+
+        this->adoptPendingClients();
+        {
+            TRACE_SPAN("timers");
+            timers.advance(TimerWheel::monotonicMs());
+        }
+
+        if (socketCount > 0) {
+            for (const auto &[socket, events]: readyEvents) {
+                if (socket == listenSocket) {
+                    this->handleNewConnections();
+                    continue;
+                }
+
+                ClientContext *client = this->findClient(socket);
+                if (client == nullptr || client->markedForDeletion) {
+                    continue;
+                }
+
+                if (events & IoEvent::WRITE) {
+                    this->flushOutbound(*client);
+                }
+                if (events & IoEvent::READ) {
+                    this->handleClientData(*client);
+                }
+            }
+        }
+
+        // The hosting client's packets are work too, even though its room never shows up in the event loop
+        const bool loopbackHadWork = this->pollLoopbackClients();
+
+        this->flushPendingClients();
+        this->removeMarkedClients();
+        this->publishRoomTelemetry();
+        this->balanceLoad(socketCount > 0 || loopbackHadWork);
+
+        //Everything sent this tick goes out together
+        {
+            TRACE_SPAN("send");
+            eventLoop->flush();
+        }
+        //The journal only talks to the OS every few ticks
+        journal.flush(TimerWheel::monotonicMs());
+
+        //Calculate this based on how much time the processing took, set at 20 TPS initially -> 50ms per loop
+        // std::this_thread::sleep_for(std::chrono_literals::operator ""ms(1000));
+        const uint64_t endTime = Tracer::nowNs();
+        const auto timeTook = static_cast<long long>(endTime - startTime);
+        lastTickTime = timeTook;
+        tickTimes.add(timeTook);
+        ++tick;
+        // The spans of this tick nest under it
+        Tracer::record("tick", startTime, endTime - startTime);
+
+        // Outside the measured time, the overlay must not show up in the tick time it displays
+        shardTelemetry.store({shardIndex, tick, lastTickTime, {}, clientCount, runnableRoomCount, roundTripTimes});
+    }
+
+    //Cleanup, clients that were still being handed over get closed too
+    this->adoptPendingClients();
+    for (auto &client: clients) {
+        if (client.socket == INVALID_SOCKET) continue;
+        this->closeConnection(client);
+    }
+    clients.clear();
+    clientBySocket.clear();
+    pendingRemovals.clear();
+    clientCount = 0;
+    shardTelemetry.store({shardIndex, tick, lastTickTime, {}, clientCount, 0, roundTripTimes});
+
+    if (listenSocket != INVALID_SOCKET) {
+        eventLoop->remove(listenSocket);
+        listenSocket = INVALID_SOCKET;
+    }
+}
+
+int ServerShard::nextWaitTimeoutMs() const {
+    const int idleTimeout = eventLoop->idleTimeoutMs();
+    const int untilTimer = timers.msUntilNextEvent(TimerWheel::monotonicMs());
+
+    if (untilTimer < 0) {
+        return idleTimeout;
+    }
+    if (idleTimeout < 0) {
+        return untilTimer;
+    }
+    return std::min(idleTimeout, untilTimer);
+}
+
+void ServerShard::expireHandshake(const ClientHandle handle) {
+    ClientContext *client = this->findClient(handle);
+    if (client == nullptr || client->markedForDeletion || client->setupPhase == ClientSetupPhase::SET_UP) {
+        return;
+    }
+
+    client->handshakeTimer = TimerWheel::NO_TIMER;
+    LOG_WARN(SERVER,
+             ANSI_YELLOW "[InternalServer] Player with ID %hhu didn't finish the handshake in time, dropping it.\n"
+             ANSI_RESET, client->playerId);
+    this->requestDisconnect(*client);
+}
+
+void ServerShard::holdReservedSeats(GameRoom &room) {
+    if (room.reservedSeats.empty()) {
+        return;
+    }
+    room.seatsReservedUntilMs = TimerWheel::monotonicMs() + RESERVED_SEAT_TIMEOUT_MS;
+    this->scheduleSeatRelease(room);
+}
+
+void ServerShard::scheduleSeatRelease(const GameRoom &room) {
+    const uint32_t roomId = room.roomId;
+    timers.schedule(msUntil(room.seatsReservedUntilMs, TimerWheel::monotonicMs()), [this, roomId]() {
+        this->releaseReservedSeats(roomId);
+    });
+}
+
+void ServerShard::releaseReservedSeats(const uint32_t roomId) {
+    // Gone, moved to a shard that waits for the deadline itself, or everybody came back
+    GameRoom *room = server.rooms.findOwned(roomId, shardIndex);
+    if (room == nullptr || room->reservedSeats.empty()) {
+        return;
+    }
+    if (TimerWheel::monotonicMs() < room->seatsReservedUntilMs) {
+        this->scheduleSeatRelease(*room);
+        return;
+    }
+
+    while (!room->reservedSeats.empty()) {
+        const ReservedSeat seat = room->reservedSeats.back();
+        LOG_INFO(SERVER, ANSI_YELLOW "[InternalServer] Player with ID %hhu didn't come back to room %u, releasing "
+                 "its seat.\n" ANSI_RESET, seat.playerId, roomId);
+
+        // Stands in for the player that never reconnected
+        ClientContext departed{};
+        departed.socket = INVALID_SOCKET;
+        departed.playerId = seat.playerId;
+        departed.profile->playerToken = seat.playerToken;
+        departed.profile->pieceType = seat.piece;
+        departed.profile->playerWins = seat.wins;
+        departed.profile->isHost = seat.isHost;
+        std::memcpy(departed.profile->playerName, seat.playerName, MAX_PLAYER_NAME_LENGTH);
+
+        const bool endsGame = room->gameInProgress;
+        if (endsGame) {
+            this->archiveReplay(*room, FinishReason::PLAYER_DISCONNECT, departed);
+        }
+
+        room->reservedSeats.pop_back();
+        room->availablePieces.push_back(seat.piece);
+        if (room->hostingPlayerId == seat.playerId) room->hostingPlayerId = 0;
+        room->gameInProgress = false;
+        this->journalRecord(JournalRecordType::SEAT_LEFT, roomId, JournalSeatLeft{seat.playerId});
+
+        PlayerDisconnectedPacket disconnectPacket{};
+        disconnectPacket.playerId = seat.playerId;
+        this->broadcastPacket(*room, PacketType::PLAYER_DISCONNECTED, disconnectPacket);
+
+        if (endsGame) {
+            GameEndPacket endPacket{};
+            endPacket.reason = FinishReason::PLAYER_DISCONNECT;
+            endPacket.playerId = seat.playerId;
+            endPacket.player = ServerUtils::clientContextToPlayer(departed, 0);
+            this->broadcastPacket(*room, PacketType::GAME_END, endPacket);
+        }
+    }
+    if (roomId == publishedRoomId) watchedRoomChanged = true;
+
+    if (server.rooms.removeIfEmpty(roomId) && journal.isOpen()) {
+        journal.append(JournalRecordType::ROOM_CLOSED, roomId, server.nextJournalSequence());
+    }
+}
+
+void ServerShard::sendHeartbeat(const ClientHandle handle) {
+    ClientContext *client = this->findClient(handle);
+    if (client == nullptr || client->markedForDeletion) {
+        return;
+    }
+    client->heartbeatTimer = TimerWheel::NO_TIMER;
+
+    const uint64_t nowMs = TimerWheel::monotonicMs();
+    if (nowMs - client->lastPongAtMs > HEARTBEAT_TIMEOUT_MS) {
+        LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Player with ID %hhu stopped answering heartbeats, dropping it.\n"
+                 ANSI_RESET, client->playerId);
+        this->requestDisconnect(*client);
+        return;
+    }
+
+    PingPacket pingPacket{};
+    pingPacket.sequence = ++client->pingSequence;
+    pingPacket.sentAtUs = monotonicUs();
+    const LatencyHistogram &roundTrips = client->profile->roundTripTimes;
+    pingPacket.lastRttUs = roundTrips.lastSampleUs();
+    pingPacket.medianRttUs = roundTrips.percentileUs(50);
+    pingPacket.p99RttUs = roundTrips.percentileUs(99);
+    this->sendPacket(*client, PacketType::PING, pingPacket);
+
+    client->nextHeartbeatAtMs = nowMs + HEARTBEAT_INTERVAL_MS;
+    client->heartbeatTimer = timers.schedule(HEARTBEAT_INTERVAL_MS, [this, handle]() {
+        this->sendHeartbeat(handle);
+    });
+}
+
+void ServerShard::handlePongPacket(ClientContext &client, const PongPacket *packet) {
+    // Any answer proves the client is alive, only one to the latest PING is worth measuring
+    client.lastPongAtMs = TimerWheel::monotonicMs();
+
+    const uint64_t nowUs = monotonicUs();
+    if (packet->sequence != client.pingSequence || packet->sentAtUs > nowUs) {
+        return;
+    }
+
+    const auto roundTripUs = static_cast<uint32_t>(std::min<uint64_t>(nowUs - packet->sentAtUs, UINT32_MAX));
+    client.profile->roundTripTimes.record(roundTripUs);
+    roundTripTimes.record(roundTripUs);
+}
+
+void ServerShard::cancelClientTimers(ClientContext &client) {
+    timers.cancel(client.handshakeTimer);
+    timers.cancel(client.heartbeatTimer);
+    client.handshakeTimer = TimerWheel::NO_TIMER;
+    client.heartbeatTimer = TimerWheel::NO_TIMER;
+}
+
+void ServerShard::wakeup() {
+    eventLoop->wakeup();
+}
+
+bool ServerShard::openJournal(const std::string &directory, const uint32_t epoch) {
+    return journal.open(directory, epoch, shardIndex);
+}
+
+bool ServerShard::checkpointRooms(const std::vector<std::unique_ptr<GameRoom>> &recoveredRooms) {
+    if (!journal.isOpen()) {
+        return false;
+    }
+
+    uint64_t sequence = server.journalSequence.load();
+    for (const auto &room: recoveredRooms) {
+        journal.writeCheckpoint(*room, sequence);
+    }
+    server.journalSequence.store(sequence);
+    return journal.sync();
+}
+
+void ServerShard::setListenSocket(const SOCKET socket, const bool spreadConnections) {
+    listenSocket = socket;
+    spreadsConnections = spreadConnections;
+    eventLoop->add(listenSocket, IoEvent::READ);
+}
+
+void ServerShard::adoptClient(ClientContext client) {
+    {
+        std::lock_guard<std::mutex> lock(this->handoffMutex);
+        pendingHandoffs.push_back(std::move(client));
+    }
+    this->wakeup();
+}
+
+void ServerShard::connectLoopback(std::shared_ptr<LoopbackChannel> channel) {
+    {
+        std::lock_guard<std::mutex> lock(this->handoffMutex);
+        pendingLoopbackConnections.push_back(std::move(channel));
+    }
+    this->wakeup();
+}
+
+void ServerShard::adoptRoom(const uint32_t roomId, std::vector<ClientContext> members) {
+    {
+        // Marking the transfer under our handoff lock guarantees that clients forwarded to us
+        // because of it get queued behind the room's members
+        std::lock_guard<std::mutex> lock(this->handoffMutex);
+        server.rooms.beginTransfer(roomId, shardIndex);
+        for (auto &member: members) {
+            pendingHandoffs.push_back(std::move(member));
+        }
+        pendingRoomTransfers.push_back(roomId);
+    }
+    this->wakeup();
+}
+
+bool ServerShard::requestSteal(const int thiefIndex) {
+    int expected = -1;
+    return stealRequestedBy.compare_exchange_strong(expected, thiefIndex);
+}
+
+bool ServerShard::isIdle() const {
+    return idle;
+}
+
+size_t ServerShard::getRunnableRoomCount() const {
+    return runnableRoomCount;
+}
+
+ShardTelemetry ServerShard::getTelemetry() {
+    ShardTelemetry telemetry = shardTelemetry.load();
+    // Summarized on the reader's thread, the shard only pays for recording
+    telemetry.tickTimes = this->getTickTimes();
+    return telemetry;
+}
+
+PackagedValues ServerShard::getTickTimes() {
+    return tickTimes.getPackagedValues();
+}
+
+RoomTelemetry ServerShard::getRoomTelemetry() const {
+    return roomTelemetry.load();
+}
+
+void ServerShard::publishRoomTelemetry() {
+    TRACE_SPAN("telemetry");
+    const uint32_t watchedRoomId = server.watchedRoomId.load(std::memory_order_relaxed);
+    if (watchedRoomId != publishedRoomId) {
+        publishedRoomId = watchedRoomId;
+        publishedRoomExists = false;
+        watchedRoomChanged = true;
+    }
+    if (!watchedRoomChanged && !runnableRooms.contains(watchedRoomId)) {
+        return;
+    }
+    watchedRoomChanged = false;
+
+    if (const GameRoom *room = server.rooms.findOwned(watchedRoomId, shardIndex)) {
+        publishedRoomExists = true;
+        roomTelemetry.store(this->captureRoom(*room));
+        return;
+    }
+
+    // Moved away: the new owner publishes once it adopted the room. Only a destroyed room is on us
+    if (!publishedRoomExists || server.rooms.find(watchedRoomId) != nullptr) {
+        return;
+    }
+    publishedRoomExists = false;
+
+    RoomTelemetry destroyed{};
+    destroyed.version = ++server.roomTelemetryVersion;
+    destroyed.roomId = watchedRoomId;
+    roomTelemetry.store(destroyed);
+}
+
+RoomTelemetry ServerShard::captureRoom(const GameRoom &room) {
+    RoomTelemetry telemetry{};
+    telemetry.version = ++server.roomTelemetryVersion;
+    telemetry.roomId = room.roomId;
+    telemetry.exists = true;
+    telemetry.nextPlayerId = room.freePlayerId();
+    telemetry.hostingPlayerId = room.hostingPlayerId;
+    telemetry.turn = room.boardData.turn;
+    telemetry.boardSize = room.boardData.boardSize;
+    telemetry.winConditionLength = room.boardData.winConditionLength;
+
+    for (const PieceType piece: room.availablePieces) {
+        if (telemetry.availablePieceCount == telemetry.availablePieces.size()) break;
+        telemetry.availablePieces[telemetry.availablePieceCount++] = piece;
+    }
+
+    for (const SOCKET memberSocket: room.members) {
+        if (telemetry.playerCount == telemetry.players.size()) break;
+        if (const ClientContext *member = this->findClient(memberSocket)) {
+            telemetry.players[telemetry.playerCount++] = ServerUtils::clientContextToPlayer(*member, 0);
+        }
+    }
+
+    for (const Move &move: room.moves) {
+        if (telemetry.moveCount == telemetry.moves.size()) break;
+        telemetry.moves[telemetry.moveCount++] = move;
+    }
+    return telemetry;
+}
+
+void ServerShard::handleNewConnections() {
+    TRACE_SPAN("accept");
+    //TODO: reject new connections if a game is already in progress
+    for (size_t accepted = 0; accepted < MAX_ACCEPTS_PER_WAKEUP; ++accepted) {
+        const SOCKET newSocket = accept(listenSocket, nullptr, nullptr);
+        if (newSocket == INVALID_SOCKET) {
+            // Usually the backlog is drained, anything else (out of descriptors, ...) is retried on the next wakeup
+            return;
+        }
+
+        this->acceptConnection(newSocket);
+    }
+}
+
+void ServerShard::acceptConnection(const SOCKET newSocket) {
+    if (!server.acquireClientSlot()) {
+        LOG_WARN(SERVER,
+                 ANSI_YELLOW "[InternalServer] Server is full (%zu clients), refusing a connection.\n" ANSI_RESET,
+                 server.getMaxClients());
+        SocketLayer::close(newSocket);
+        return;
+    }
+
+    //Make the socket non-blocking, a slow client must never stall the tick
+    SocketLayer::setNonBlocking(newSocket);
+
+    //Packets are already coalesced per tick, Nagle would only hold back the last segment
+    SocketLayer::setNoDelay(newSocket);
+
+    ClientContext newClient = this->greetNewClient(newSocket);
+
+    // Spread the lobby connections, they move again if their room lives elsewhere
+    const size_t targetShard = spreadsConnections ? server.nextAcceptShard() : shardIndex;
+    if (targetShard != shardIndex) {
+        // The hello is still in the client's send queue and moves along with it,
+        // the new shard sends it before anything else
+        server.getShard(targetShard).adoptClient(std::move(newClient));
+        return;
+    }
+
+    this->addClient(std::move(newClient));
+}
+
+ClientContext ServerShard::greetNewClient(const SOCKET socket) {
+    ClientContext newClient;
+    newClient.setupPhase = ClientSetupPhase::NEW_CONNECTION;
+    newClient.socket = socket;
+    newClient.playerId = nextPlayerId++;
+
+    ServerHelloPacket helloPacket;
+    helloPacket.playerId = newClient.playerId;
+
+    this->sendPacket<ServerHelloPacket>(newClient, PacketType::SERVER_HELLO, helloPacket);
+    newClient.setupPhase = ClientSetupPhase::HELLO_SENT;
+    return newClient;
+}
+
+bool ServerShard::pollLoopbackClients() {
+    TRACE_SPAN("loopback");
+    // A copy, clients leave the list when they disconnect or move to another shard
+    const std::vector<ClientHandle> polling = loopbackClients;
+    bool received = false;
+
+    for (const ClientHandle handle: polling) {
+        ClientContext *client = this->findClient(handle);
+        if (client == nullptr || client->markedForDeletion) continue;
+
+        // Held on to, a migration moves the channel out of the client
+        const std::shared_ptr<LoopbackChannel> channel = client->loopback;
+        // Checked first, everything the client sent before closing still gets processed
+        const bool closed = channel->isClosedByClient();
+
+        SharedFrame frame;
+        while (!client->markedForDeletion && channel->receiveFromClient(frame)) {
+            received = true;
+            if (!client->receiveBuffer.append(frame->data(), frame->size())) {
+                LOG_WARN(SERVER,
+                         ANSI_RED "[InternalServer] Receive buffer of player with ID %hhu overflowed.\n" ANSI_RESET,
+                         client->playerId);
+                this->disconnectClient(*client);
+                break;
+            }
+            this->parseReceivedPackets(*client);
+        }
+
+        if (client->markedForDeletion) continue;
+
+        if (closed) {
+            this->disconnectClient(*client);
+            continue;
+        }
+
+        // Whatever didn't fit into the channel last time
+        if (!client->sendQueue.empty() && !client->flushScheduled) {
+            client->flushScheduled = true;
+            pendingFlushes.push_back(client->handle);
+        }
+    }
+    return received;
+}
+
+void ServerShard::closeConnection(ClientContext &client) {
+    this->cancelClientTimers(client);
+
+    if (client.loopback != nullptr) {
+        client.loopback->closeFromServer();
+        client.loopback->setOwner(nullptr);
+        std::erase(loopbackClients, client.handle);
+        return;
+    }
+
+    eventLoop->remove(client.socket);
+    SocketLayer::close(client.socket);
+}
+
+ClientContext *ServerShard::addClient(ClientContext &&client) {
+    const ClientHandle handle = clients.insert(std::move(client));
+    clientCount = clients.size();
+
+    ClientContext &added = *clients.get(handle);
+    added.handle = handle;
+    clientBySocket[added.socket] = handle;
+    added.waitingForWrite = false;
+    if (added.loopback != nullptr) {
+        // Polled every tick, the channel wakes us up when the client sends something
+        loopbackClients.push_back(handle);
+        added.loopback->setOwner(this);
+    } else if (!eventLoop->add(added.socket, IoEvent::READ)) {
+        LOG_WARN(SERVER, ANSI_RED "[InternalServer] Event loop refused a connection, dropping it.\n" ANSI_RESET);
+        this->disconnectClient(added);
+        return nullptr;
+    }
+
+    // Timers belong to the shard but the deadlines follow the client, a migration doesn't give it more time
+    const uint64_t nowMs = TimerWheel::monotonicMs();
+    if (added.lastPongAtMs == 0) {
+        added.lastPongAtMs = nowMs;
+        added.handshakeDeadlineMs = nowMs + HANDSHAKE_TIMEOUT_MS;
+        added.nextHeartbeatAtMs = nowMs + HEARTBEAT_INTERVAL_MS;
+    }
+    if (added.setupPhase != ClientSetupPhase::SET_UP) {
+        added.handshakeTimer = timers.schedule(msUntil(added.handshakeDeadlineMs, nowMs), [this, handle]() {
+            this->expireHandshake(handle);
+        });
+    }
+    added.heartbeatTimer = timers.schedule(msUntil(added.nextHeartbeatAtMs, nowMs), [this, handle]() {
+        this->sendHeartbeat(handle);
+    });
+
+    // Anything still queued (e.g. by the previous shard) goes out with this tick's flush
+    added.flushScheduled = !added.sendQueue.empty();
+    if (added.flushScheduled) {
+        pendingFlushes.push_back(handle);
+    }
+
+    // Flagged on the previous shard, but moved before it got dropped there
+    if (added.disconnectPending) {
+        pendingDisconnects.push_back(handle);
+    }
+
+    return &added;
+}
+
+void ServerShard::adoptPendingClients() {
+    std::vector<ClientContext> adopted;
+    std::vector<uint32_t> adoptedRooms;
+    std::vector<std::shared_ptr<LoopbackChannel>> loopbackConnections;
+    {
+        std::lock_guard<std::mutex> lock(this->handoffMutex);
+        adopted.swap(pendingHandoffs);
+        adoptedRooms.swap(pendingRoomTransfers);
+        loopbackConnections.swap(pendingLoopbackConnections);
+    }
+
+    // The hosting client connecting in-process, the server already picked this shard for it
+    for (auto &channel: loopbackConnections) {
+        if (!server.acquireClientSlot()) {
+            LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Server is full (%zu clients), refusing a connection.\n"
+                     ANSI_RESET, server.getMaxClients());
+            channel->closeFromServer();
+            continue;
+        }
+
+        ClientContext newClient = this->greetNewClient(channel->getHandle());
+        newClient.loopback = std::move(channel);
+        this->addClient(std::move(newClient));
+    }
+
+    if (adopted.empty() && adoptedRooms.empty()) {
+        return;
+    }
+
+    // Nobody else touches a moving room, and joiners it turned away are queued behind its members
+    for (const uint32_t roomId: adoptedRooms) {
+        server.rooms.finishTransfer(roomId);
+        if (roomId == publishedRoomId) watchedRoomChanged = true;
+
+        // The previous owner's wheel doesn't fire for us
+        const GameRoom *room = server.rooms.findOwned(roomId, shardIndex);
+        if (room != nullptr && !room->reservedSeats.empty()) {
+            this->scheduleSeatRelease(*room);
+        }
+    }
+
+    // Register everyone first, so broadcasts from the parsed packets below reach all members of a moved room
+    std::vector<ClientHandle> adoptedHandles;
+    adoptedHandles.reserve(adopted.size());
+    for (auto &handedOver: adopted) {
+        if (const ClientContext *added = this->addClient(std::move(handedOver))) {
+            adoptedHandles.push_back(added->handle);
+        }
+    }
+
+    // A SETUP_REQ that triggered the move is still at the front of the buffer
+    for (const ClientHandle handle: adoptedHandles) {
+        if (ClientContext *client = this->findClient(handle)) {
+            this->parseReceivedPackets(*client);
+        }
+    }
+}
+
+void ServerShard::removeMarkedClients() {
+    if (pendingRemovals.empty()) {
+        return;
+    }
+
+    for (const ClientHandle handle: pendingRemovals) {
+        clients.erase(handle);
+    }
+    pendingRemovals.clear();
+    clientCount = clients.size();
+}
+
+void ServerShard::markForRemoval(ClientContext &client) {
+    if (client.markedForDeletion) {
+        return;
+    }
+    client.markedForDeletion = true;
+    pendingRemovals.push_back(client.handle);
+}
+
+void ServerShard::disconnectClient(ClientContext &client) {
+    LOG_INFO(SERVER, ANSI_RED "[InternalServer] Player with ID %hhu has disconnected.\n" ANSI_RESET, client.playerId);
+    this->markForRemoval(client);
+
+    this->closeConnection(client);
+    const SOCKET closedSocket = client.socket;
+    clientBySocket.erase(closedSocket);
+    client.socket = INVALID_SOCKET;
+    server.releaseClientSlot();
+
+    if (!client.inRoom) {
+        return;
+    }
+
+    GameRoom *room = server.rooms.findOwned(client.roomId, shardIndex);
+    if (room == nullptr) {
+        return;
+    }
+
+    if (room->gameInProgress) {
+        this->archiveReplay(*room, FinishReason::PLAYER_DISCONNECT, client);
+    }
+
+    room->availablePieces.push_back(client.profile->pieceType);
+    room->removeMember(closedSocket, client.playerId);
+    if (room->hostingPlayerId == client.playerId) room->hostingPlayerId = 0;
+    room->gameInProgress = false;
+    client.inRoom = false;
+    this->journalRecord(JournalRecordType::SEAT_LEFT, room->roomId, JournalSeatLeft{client.playerId});
+    if (room->roomId == publishedRoomId) watchedRoomChanged = true;
+
+    PlayerDisconnectedPacket disconnectPacket{};
+    disconnectPacket.playerId = client.playerId;
+    this->broadcastPacket(*room, PacketType::PLAYER_DISCONNECTED, disconnectPacket);
+
+    // Reset the game here back to GAME_ROOM state
+    GameEndPacket endPacket{};
+    endPacket.reason = FinishReason::PLAYER_DISCONNECT;
+    endPacket.playerId = client.playerId;
+    endPacket.player = ServerUtils::clientContextToPlayer(client, 0);
+
+    this->broadcastPacket(*room, PacketType::GAME_END, endPacket);
+
+    if (server.rooms.removeIfEmpty(client.roomId) && journal.isOpen()) {
+        journal.append(JournalRecordType::ROOM_CLOSED, client.roomId, server.nextJournalSequence());
+    }
+}
+
+ClientContext *ServerShard::findClient(const SOCKET socket) {
+    const auto clientIt = clientBySocket.find(socket);
+    if (clientIt == clientBySocket.end()) {
+        return nullptr;
+    }
+    return clients.get(clientIt->second);
+}
+
+ClientContext *ServerShard::findClient(const ClientHandle handle) {
+    return clients.get(handle);
+}
+
+ClientContext *ServerShard::findPlayer(const GameRoom &room, const uint8_t playerId) {
+    const SOCKET memberSocket = room.findMember(playerId);
+    return memberSocket == INVALID_SOCKET ? nullptr : this->findClient(memberSocket);
+}
+
+void ServerShard::handleClientData(ClientContext &client) {
+    // Receive straight into the client's ring, the packets are parsed from there in place
+    size_t writable;
+    char *buffer = client.receiveBuffer.writableSpan(writable);
+    if (writable == 0) {
+        LOG_WARN(SERVER, ANSI_RED "[InternalServer] Receive buffer of player with ID %hhu overflowed.\n" ANSI_RESET,
+                 client.playerId);
+        this->disconnectClient(client);
+        return;
+    }
+
+    int bytesRead;
+    {
+        TRACE_SPAN("recv");
+        bytesRead = eventLoop->receive(client.socket, buffer, static_cast<int>(writable));
+    }
+
+    if (bytesRead == EventLoop::WOULD_BLOCK) {
+        return;
+    }
+
+    if (bytesRead <= 0) {
+        //Error or 0 means disconnected
+        this->disconnectClient(client);
+        return;
+    }
+
+    client.receiveBuffer.commit(bytesRead);
+
+    this->parseReceivedPackets(client);
+}
+
+void ServerShard::parseReceivedPackets(ClientContext &client) {
+    TRACE_SPAN("parse");
+    //Packet parsing
+    while (!client.markedForDeletion) {
+        PacketView packet{};
+        const FrameResult result = client.receiveBuffer.peek(packet);
+
+        if (result == FrameResult::INCOMPLETE) {
+            break; //Not enough data for the whole packet, wait for the next recv
+        }
+
+        if (result == FrameResult::OVERSIZED) {
+            LOG_WARN(SERVER, ANSI_RED "[InternalServer] Player with ID %hhu sent an oversized packet.\n" ANSI_RESET,
+                     client.playerId);
+            this->disconnectClient(client);
+            break;
+        }
+
+        // Here we have a valid packet, it stays in the buffer until processed so a migrating client takes it along
+        // A packet that trips a bug only costs its sender the connection, never the shard and its other rooms
+        try {
+            this->processPacket(client, packet);
+        } catch (const std::exception &exception) {
+            LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Packet of type %d from player with ID %hhu failed: %s, "
+                      "dropping the client.\n" ANSI_RESET, static_cast<int>(packet.header.type), client.playerId,
+                      exception.what());
+            this->disconnectClient(client);
+            break;
+        }
+
+        client.receiveBuffer.pop();
+    }
+}
+
+void ServerShard::processPacket(ClientContext &client, const PacketView &packetView) {
+    const PacketType type = packetView.header.type;
+    TRACE_SPAN(packetSpanName(type));
+    //C2S Packets: SETUP_REQ[x], SETTINGS_CHANGE_REQ[x], MOVE_REQ[x], BACK_TO_GAME_ROOM[x], PONG[x], RESYNC_REQ[x]
+
+    // Heartbeats arrive every few seconds from every client, in or out of a room, and aren't worth a log line
+    if (type != PacketType::PONG) {
+        LOG_DEBUG(SERVER,
+                  ANSI_CYAN "[InternalServer] Received packet of type %d from client with ID: %hhu\n" ANSI_RESET,
+                  static_cast<int>(type), client.playerId);
+    }
+
+    DispatchResult result = LobbyDispatcher::dispatch(*this, packetView, client);
+
+    if (result == DispatchResult::UNROUTED) {
+        // Everything past the handshake happens inside the client's room, which always lives on this shard
+        GameRoom *room = client.inRoom ? server.rooms.findOwned(client.roomId, shardIndex) : nullptr;
+        if (room == nullptr) {
+            LOG_WARN(SERVER,
+                     ANSI_RED "[InternalServer] Client with ID %hhu sent a packet before joining a room! Type: %d\n"
+                     ANSI_RESET, client.playerId, static_cast<int>(type));
+            return;
+        }
+        runnableRooms.insert(room->roomId);
+
+        result = RoomDispatcher::dispatch(*this, packetView, *room, client);
+    }
+
+    if (result == DispatchResult::UNROUTED) {
+        LOG_WARN(SERVER, ANSI_RED "[InternalServer] Unknown packet received! Type: %d\n" ANSI_RESET,
+                 static_cast<int>(type));
+    } else if (result == DispatchResult::MALFORMED) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Dropping a malformed packet from client with ID %hhu! "
+                 "Type: %d, size: %u\n" ANSI_RESET, client.playerId, static_cast<int>(type),
+                 packetView.header.payloadSize);
+    }
+}
+
+void ServerShard::handleSetupRequestPacket(ClientContext &client, const SetupReqPacket *packet) {
+    if (client.inRoom) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Client with ID %hhu sent a second SETUP_REQ, ignoring it.\n" ANSI_RESET,
+                 client.playerId);
+        return;
+    }
+
+    size_t ownerShard;
+    GameRoom *roomPtr = server.rooms.acquire(packet->roomId, shardIndex, ownerShard);
+    if (roomPtr == nullptr) {
+        // The room lives on (or is moving to) another shard, follow it with this packet still unparsed
+        this->migrateClient(client, ownerShard);
+        return;
+    }
+
+    client.setupPhase = ClientSetupPhase::SETUP_REQ_RECV;
+    GameRoom &room = *roomPtr;
+    runnableRooms.insert(room.roomId);
+
+    ClientProfile &profile = *client.profile;
+    memset(profile.playerName, 0, MAX_PLAYER_NAME_LENGTH);
+    strncpy(profile.playerName, packet->playerName, MAX_PLAYER_NAME_LENGTH - 1);
+
+    //Respond with a generated token
+    const int clientAuthToken = packet->initialToken / 3;
+
+    // After a crash the room keeps the seats of the players who haven't come back yet, their name and token get it back
+    ReservedSeat seat{};
+    const bool reclaimed = room.claimReservedSeat(profile.playerName, clientAuthToken, seat);
+
+    //Room scoped ID, replaces the provisional one sent in SERVER_HELLO
+    const uint8_t playerId = reclaimed ? seat.playerId : room.freePlayerId();
+    if (!reclaimed && (!room.hasFreeSlot() || playerId == 0)) {
+        LOG_WARN(SERVER, ANSI_RED "[InternalServer] Room %u is full, dropping client with ID %hhu\n" ANSI_RESET,
+                 room.roomId, client.playerId);
+        this->disconnectClient(client);
+        return;
+    }
+
+    client.playerId = playerId;
+    client.roomId = room.roomId;
+    client.inRoom = true;
+    room.addMember(client.socket, client.playerId);
+
+    if (reclaimed) {
+        profile.isHost = seat.isHost && room.hostingPlayerId == seat.playerId;
+    } else {
+        profile.isHost = packet->isHost && room.hostingPlayerId == 0;
+        if (profile.isHost) room.hostingPlayerId = client.playerId;
+    }
+
+    const auto clientPieceType = reclaimed ? seat.piece : room.takeFirstAvailablePiece();
+    LOG_DEBUG(SERVER,
+              ANSI_CYAN "[InternalServer] Received SETUP_ACK with parameters [%hhu, %s, %d, room: %u]\n" ANSI_RESET,
+              packet->playerId, packet->playerName, packet->initialToken, packet->roomId);
+
+    //Add to playerlist - modify the client context (Or a separate active player list?)
+    profile.playerToken = clientAuthToken;
+    profile.pieceType = clientPieceType;
+    profile.playerWins = reclaimed ? seat.wins : 0;
+
+    SetupAckPacket setupAckPacket{};
+    setupAckPacket.generatedAuthToken = clientAuthToken;
+    setupAckPacket.playerId = client.playerId;
+    setupAckPacket.boardSize = room.boardData.boardSize;
+    setupAckPacket.winConditionLength = room.boardData.winConditionLength;
+    setupAckPacket.round = room.boardData.round;
+    setupAckPacket.playerCount = 0;
+    for (const SOCKET memberSocket: room.members) {
+        if (setupAckPacket.playerCount >= MAX_PLAYERS) {
+            break;
+        }
+        const ClientContext *playerContext = this->findClient(memberSocket);
+        if (playerContext == nullptr) continue;
+
+        setupAckPacket.players[setupAckPacket.playerCount] =
+                ServerUtils::clientContextToPlayer(*playerContext, client.playerId);
+        setupAckPacket.playerCount++;
+    }
+
+    memset(setupAckPacket.playerName, 0, MAX_PLAYER_NAME_LENGTH);
+    strncpy(setupAckPacket.playerName, profile.playerName, MAX_PLAYER_NAME_LENGTH - 1);
+    setupAckPacket.pieceType = clientPieceType;
+
+    LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Sending SETUP_ACK packet to client with ID: %d\n" ANSI_RESET,
+              client.playerId);
+    this->sendPacket(client, PacketType::SETUP_ACK, setupAckPacket);
+
+    // Broadcast new player joined packet
+    NewPlayerJoinPacket newPlayerJoinPacket{};
+    newPlayerJoinPacket.newPlayerId = client.playerId;
+    newPlayerJoinPacket.newPlayerPieceType = clientPieceType;
+    newPlayerJoinPacket.isHost = profile.isHost;
+    memset(newPlayerJoinPacket.newPlayerName, 0, MAX_PLAYER_NAME_LENGTH);
+    strncpy(newPlayerJoinPacket.newPlayerName, profile.playerName, MAX_PLAYER_NAME_LENGTH - 1);
+
+    this->broadcastPacket(room, PacketType::NEW_PLAYER_JOIN, newPlayerJoinPacket);
+
+    if (!reclaimed) {
+        this->journalSeat(room, client);
+    } else if (room.gameInProgress) {
+        // Back into the game that was running when the server went down, the keyframe syncs the move sequence
+        LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] Player %s is back in room %u, resuming the game.\n" ANSI_RESET,
+                 profile.playerName, room.roomId);
+        client.myTurn = client.playerId == room.boardData.actingPlayerId;
+        const GameStartPacket gameStartPacket = this->makeGameStartPacket(room);
+        this->sendPacket(client, PacketType::GAME_START, gameStartPacket, snapshotPayloadSize(gameStartPacket));
+        this->sendKeyframe(room, &client);
+    }
+
+    client.setupPhase = ClientSetupPhase::SET_UP;
+    timers.cancel(client.handshakeTimer);
+    client.handshakeTimer = TimerWheel::NO_TIMER;
+}
+
+void ServerShard::handleSettingsChangeRequestPacket(GameRoom &room, ClientContext &client,
+                                                    const SettingsChangeReqPacket *packet) {
+    LOG_DEBUG(SERVER,
+              ANSI_CYAN
+              "[InternalServer] Received SETTINGS_CHANGE_REQ packet from %hhu "
+              "with params: [size: %hhu, winCon: %hhu]!\n"
+              ANSI_RESET,
+              packet->playerId, packet->newBoardSize, packet->newWinConditionLength);
+
+    // Checked against the sender, the ID in the packet is only what the client claims
+    if (client.playerId != room.hostingPlayerId) {
+        LOG_WARN(SERVER,
+                 ANSI_RED
+                 "[InternalServer] Somehow got a game settings change request from a client that isn't the host! "
+                 "This shouldn't happen! [sender: %hhu != host: %hhu]\n" ANSI_RESET,
+                 client.playerId, room.hostingPlayerId);
+        return;
+    }
+
+    bool updated = false;
+    // 0 < BoardSize < MAX_BOARD_SIZE
+    if (packet->newBoardSize > 0 && packet->newBoardSize <= MAX_BOARD_SIZE && room.boardData.boardSize != packet->
+        newBoardSize) {
+        LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] BoardSize updated from %hhu to %hhu\n" ANSI_RESET,
+                 room.boardData.boardSize, packet->newBoardSize);
+        room.boardData.boardSize = packet->newBoardSize;
+        room.boardData.winConditionLength = std::min(room.boardData.winConditionLength, room.boardData.boardSize);
+        updated = true;
+    }
+
+    // 0 < WinConditionLength < BoardSize
+    if (packet->newWinConditionLength > 0 && packet->newWinConditionLength <= room.boardData.boardSize &&
+        room.boardData.winConditionLength != packet->newWinConditionLength) {
+        LOG_INFO(SERVER, ANSI_GREEN "[InternalServer] WinConditionLength updated from %hhu to %hhu\n" ANSI_RESET,
+                 room.boardData.winConditionLength, packet->newWinConditionLength);
+        room.boardData.winConditionLength = packet->newWinConditionLength;
+        updated = true;
+    }
+
+    //Send update packet if necessary
+    if (updated) {
+        SettingsUpdatePacket settingsUpdatePacket{};
+        settingsUpdatePacket.newBoardSize = room.boardData.boardSize;
+        settingsUpdatePacket.newWinConditionLength = room.boardData.winConditionLength;
+
+        LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Broadcasting new board settings!\n" ANSI_RESET);
+        this->broadcastPacket(room, PacketType::SETTINGS_UPDATE, settingsUpdatePacket);
+        this->journalRecord(JournalRecordType::ROOM_STATE, room.roomId, MoveJournal::roomStateRecord(room, 0));
+    }
+}
+
+void ServerShard::handleGameStartRequestPacket(GameRoom &room, ClientContext &client,
+                                               const GameStartRequestPacket *packet) {
+    LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Got a%s game start request from player with id %hhu\n" ANSI_RESET,
+              (packet->newGame ? " new" : ""), packet->requestingPlayerId);
+
+    // Checked against the sender, the ID in the packet is only what the client claims
+    if (client.playerId != room.hostingPlayerId) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Somehow got a game start request from a client that isn't the host! "
+                 "This shouldn't happen! [sender: %hhu != host: %hhu]\n" ANSI_RESET,
+                 client.playerId, room.hostingPlayerId);
+        return;
+    }
+
+    Utils::initializeGameBoard(room.boardData);
+    room.boardData.turn = 1;
+    room.boardData.actingPlayerId = this->getNextActingPlayerId(room);
+    room.moves.clear();
+    room.moveSequence = 0;
+    room.gameInProgress = true;
+    room.gameStartedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    for (const SOCKET memberSocket: room.members) {
+        if (ClientContext *ctx = this->findClient(memberSocket)) {
+            ctx->myTurn = ctx->playerId == room.boardData.actingPlayerId;
+            if (packet->newGame) ctx->profile->playerWins = 0;
+        }
+    }
+
+    const uint8_t journalFlags = JournalRoomState::RESET_BOARD | (packet->newGame ? JournalRoomState::RESET_WINS : 0);
+    this->journalRecord(JournalRecordType::ROOM_STATE, room.roomId, MoveJournal::roomStateRecord(room, journalFlags));
+
+    const GameStartPacket gameStartPacket = this->makeGameStartPacket(room);
+
+    LOG_INFO(SERVER,
+             ANSI_GREEN "[InternalServer] Sending out game start packets! [Starting playerID: %hhu]\n" ANSI_RESET,
+             gameStartPacket.startingPlayerId);
+    this->broadcastPacket(room, PacketType::GAME_START, gameStartPacket, snapshotPayloadSize(gameStartPacket));
+}
+
+void ServerShard::handleMoveRequestPacket(GameRoom &room, ClientContext &client,
+                                          const MoveRequestPacket *packet) {
+    LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Received a MOVE_REQ packet from player with ID: %hhu\n" ANSI_RESET,
+              packet->playerId);
+    // The client only ever moves for itself, whatever ID the packet claims
+    if (packet->playerId != client.playerId) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Player with ID %hhu sent a move request for player %hhu, ignoring it.\n"
+                 ANSI_RESET, client.playerId, packet->playerId);
+        return;
+    }
+
+    if (!room.gameInProgress) {
+        LOG_WARN(SERVER,
+                 ANSI_YELLOW "[InternalServer] Player with ID %hhu sent a move request outside of a game, "
+                 "ignoring it.\n" ANSI_RESET, client.playerId);
+        return;
+    }
+
+    if (packet->x >= room.boardData.boardSize || packet->y >= room.boardData.boardSize) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Player with ID %hhu tried placing a piece off the board! "
+                 "[x:%hhu, y:%hhu, size: %hhu]\n" ANSI_RESET,
+                 client.playerId, packet->x, packet->y, room.boardData.boardSize);
+        return;
+    }
+
+    if (packet->playerId != room.boardData.actingPlayerId) {
+        LOG_WARN(SERVER,
+                 ANSI_RED
+                 "[InternalServer] Somehow got a move request from a player whose ID doesnt match the current acting players! [req: %hhu != currActing: %hhu]\n"
+                 ANSI_RESET,
+                 packet->playerId, room.boardData.actingPlayerId);
+        return;
+    }
+
+    if (packet->turn != room.boardData.turn) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Turn mismatch! Possible desync! Sending BoardStateUpdate to fix.\n"
+                 ANSI_RESET);
+        this->sendKeyframe(room, &client);
+        return;
+    }
+
+    if (room.boardData.getSquareAt(packet->x, packet->y).piece != PieceType::EMPTY) {
+        LOG_WARN(SERVER,
+                 ANSI_YELLOW
+                 "[InternalServer] Player with id %hhu tried placing a piece on an already used square! "
+                 "[x:%hhu, y:%hhu]\n"
+                 ANSI_RESET,
+                 packet->playerId, packet->x, packet->y);
+        return;
+    }
+
+    // The piece is the seat's, not whatever the client put into the packet
+    const PieceType piece = client.profile->pieceType;
+    BoardSquare square{};
+    square.playerId = client.playerId;
+    square.turnPlaced = room.boardData.turn;
+    square.piece = piece;
+    room.boardData.setSquareAt(packet->x, packet->y, square);
+
+    //For the move history
+    Move move(piece, client.playerId, room.boardData.turn, packet->x, packet->y);
+    room.moves.push_back(std::move(move));
+
+    //Update the board state
+    room.boardData.turn += 1;
+    room.boardData.actingPlayerId = this->getNextActingPlayerId(room);
+    room.moveSequence += 1;
+    this->journalRecord(JournalRecordType::MOVE, room.roomId,
+                        MoveJournal::moveRecord(move, room.boardData.actingPlayerId));
+
+    // Only the player whose turn ended and the one whose turn starts change
+    if (ClientContext *previous = this->findPlayer(room, packet->playerId)) {
+        previous->myTurn = false;
+    }
+    if (ClientContext *acting = this->findPlayer(room, room.boardData.actingPlayerId)) {
+        acting->myTurn = true;
+    }
+
+    // Broadcast the move, with a full keyframe every few moves
+    if (room.moveSequence % KEYFRAME_INTERVAL == 0) {
+        LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Broadcasting board state update packets!\n" ANSI_RESET);
+        this->sendKeyframe(room, nullptr);
+    } else {
+        MoveAppliedPacket moveApplied{};
+        moveApplied.sequence = room.moveSequence;
+        moveApplied.move = move;
+        moveApplied.round = room.boardData.round;
+        moveApplied.turn = room.boardData.turn;
+        moveApplied.actingPlayerId = room.boardData.actingPlayerId;
+
+        LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Broadcasting move applied packets!\n" ANSI_RESET);
+        this->broadcastPacket(room, PacketType::MOVE_APPLIED, moveApplied);
+    }
+
+
+    bool gameFinished = WinValidator::checkWin(room.boardData, packet->x, packet->y);
+    if (gameFinished) {
+        LOG_INFO(SERVER,
+                 ANSI_GREEN "[InternalServer] Player with ID %hhu won the round!\n" ANSI_RESET, packet->playerId);
+        ClientContext *winningClient = this->findPlayer(room, packet->playerId);
+        if (winningClient == nullptr) {
+            winningClient = &client;
+        }
+        this->archiveReplay(room, FinishReason::PLAYER_WIN, *winningClient);
+        winningClient->profile->playerWins += 1;
+        room.boardData.round += 1;
+        room.gameInProgress = false;
+        this->journalSeat(room, *winningClient);
+        this->journalRecord(JournalRecordType::ROOM_STATE, room.roomId, MoveJournal::roomStateRecord(room, 0));
+
+        //Broadcast game finish
+        GameEndPacket gameEndPacket{};
+        gameEndPacket.reason = FinishReason::PLAYER_WIN;
+        gameEndPacket.playerId = packet->playerId;
+        gameEndPacket.player = ServerUtils::clientContextToPlayer(*winningClient, 0);
+
+        this->broadcastPacket(room, PacketType::GAME_END, gameEndPacket);
+    }
+}
+
+void ServerShard::handleBackToGameRoomPacket(GameRoom &room, ClientContext &,
+                                             const BackToGameRoomPacket *packet) {
+    LOG_DEBUG(SERVER,
+              ANSI_CYAN "[InternalServer] Got a BACK_TO_GAME_ROOM packet, relaying to all clients.\n" ANSI_RESET);
+
+    // Relay the packet
+    this->broadcastPacket(room, PacketType::BACK_TO_GAME_ROOM, *packet);
+}
+
+GameStartPacket ServerShard::makeGameStartPacket(const GameRoom &room) {
+    GameStartPacket gameStartPacket{};
+    gameStartPacket.requestedByPlayerId = room.hostingPlayerId;
+    gameStartPacket.finalBoardSize = room.boardData.boardSize;
+    gameStartPacket.finalWinConditionLength = room.boardData.winConditionLength;
+    gameStartPacket.round = room.boardData.round;
+    gameStartPacket.turn = room.boardData.turn;
+    gameStartPacket.startingPlayerId = room.boardData.actingPlayerId;
+    gameStartPacket.playerCount = room.members.size(); //To confirm we have synced the players on both sides
+    gameStartPacket.snapshotSize =
+            Utils::serializeBoard(room.boardData, gameStartPacket.snapshot, MAX_BOARD_SNAPSHOT_SIZE);
+    return gameStartPacket;
+}
+
+template<typename T>
+void ServerShard::journalRecord(const JournalRecordType type, const uint32_t roomId, const T &payload) {
+    if (journal.isOpen()) {
+        journal.append(type, roomId, server.nextJournalSequence(), payload);
+    }
+}
+
+void ServerShard::journalSeat(const GameRoom &room, const ClientContext &client) {
+    JournalSeat seat{};
+    seat.playerId = client.playerId;
+    seat.piece = client.profile->pieceType;
+    seat.isHost = client.profile->isHost;
+    seat.wins = client.profile->playerWins;
+    seat.playerToken = client.profile->playerToken;
+    std::memcpy(seat.playerName, client.profile->playerName, MAX_PLAYER_NAME_LENGTH);
+    this->journalRecord(JournalRecordType::SEAT, room.roomId, seat);
+}
+
+void ServerShard::archiveReplay(const GameRoom &room, const FinishReason reason, const ClientContext &finisher) {
+    if (server.replayDirectory.empty() || room.moves.empty()) {
+        return;
+    }
+    TRACE_SPAN("replay");
+
+    ReplayMatch match;
+    match.roomId = room.roomId;
+    match.boardSize = room.boardData.boardSize;
+    match.winConditionLength = room.boardData.winConditionLength;
+    match.round = room.boardData.round;
+    match.startedAtMs = room.gameStartedAtMs;
+    match.finishReason = reason;
+    match.finishPlayerId = finisher.playerId;
+    match.moves = room.moves;
+
+    // Everyone who holds a seat, including players of a recovered game who haven't reconnected
+    const auto addPlayer = [&match](const ClientContext &member) {
+        ReplayPlayer player{};
+        player.playerId = member.playerId;
+        player.piece = member.profile->pieceType;
+        player.isHost = member.profile->isHost;
+        std::memcpy(player.playerName, member.profile->playerName, MAX_PLAYER_NAME_LENGTH);
+        match.players.push_back(player);
+    };
+    for (const SOCKET memberSocket: room.members) {
+        if (const ClientContext *member = this->findClient(memberSocket)) addPlayer(*member);
+    }
+    if (std::ranges::none_of(match.players, [&](const ReplayPlayer &player) {
+        return player.playerId == finisher.playerId;
+    })) {
+        addPlayer(finisher);
+    }
+    for (const ReservedSeat &seat: room.reservedSeats) {
+        ReplayPlayer player{};
+        player.playerId = seat.playerId;
+        player.piece = seat.piece;
+        player.isHost = seat.isHost;
+        std::memcpy(player.playerName, seat.playerName, MAX_PLAYER_NAME_LENGTH);
+        match.players.push_back(player);
+    }
+
+    char fileName[96];
+    std::snprintf(fileName, sizeof(fileName), "room%u-round%u-%llu%s", room.roomId, room.boardData.round,
+                  static_cast<unsigned long long>(room.gameStartedAtMs), ReplayFile::FILE_EXTENSION);
+
+    std::vector<uint8_t> bytes = ReplayFile::encode(match);
+    if (bytes.empty()) {
+        LOG_WARN(SERVER, ANSI_YELLOW "[InternalServer] Couldn't archive the replay of room %u as %s\n" ANSI_RESET,
+                 room.roomId, fileName);
+        return;
+    }
+
+    // Only encoded here, the file gets written on the replay writer's thread
+    LOG_DEBUG(SERVER, ANSI_CYAN "[InternalServer] Archiving %zu moves of room %u as %s\n" ANSI_RESET,
+              match.moves.size(), room.roomId, fileName);
+    server.replayWriter.enqueue(server.replayDirectory + "/" + fileName, std::move(bytes));
+}
+
+void ServerShard::handleResyncRequestPacket(GameRoom &room, ClientContext &client,
+                                            const ResyncRequestPacket *packet) {
+    if (!room.gameInProgress) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Player with ID %hhu asked for a resync, but no game is running!\n"
+                 ANSI_RESET, client.playerId);
+        return;
+    }
+
+    //A keyframe may have crossed the request, nothing to catch up on then
+    if (packet->sequence == room.moveSequence) {
+        return;
+    }
+
+    LOG_INFO(SERVER, ANSI_YELLOW "[InternalServer] Resyncing player with ID %hhu [has: %u, current: %u]\n" ANSI_RESET,
+             client.playerId, packet->sequence, room.moveSequence);
+    this->sendKeyframe(room, &client);
+}
+
+void ServerShard::sendKeyframe(GameRoom &room, ClientContext *recipient) {
+    BoardStateUpdatePacket boardUpdate{};
+    boardUpdate.sequence = room.moveSequence;
+    boardUpdate.snapshotSize = Utils::serializeBoard(room.boardData, boardUpdate.snapshot, MAX_BOARD_SNAPSHOT_SIZE);
+    boardUpdate.boardSize = room.boardData.boardSize;
+    boardUpdate.winConditionLength = room.boardData.winConditionLength;
+    boardUpdate.round = room.boardData.round;
+    boardUpdate.turn = room.boardData.turn;
+    boardUpdate.actingPlayerId = room.boardData.actingPlayerId;
+    boardUpdate.lastMove = room.moves.empty() ? Move{} : room.moves.back();
+    boardUpdate.playerCount = 0;
+    for (const SOCKET memberSocket: room.members) {
+        if (boardUpdate.playerCount >= MAX_PLAYERS) {
+            break;
+        }
+        const ClientContext *playerContext = this->findClient(memberSocket);
+        if (playerContext == nullptr) continue;
+
+        boardUpdate.players[boardUpdate.playerCount] =
+                ServerUtils::clientContextToPlayer(*playerContext, recipient != nullptr ? recipient->playerId : 0);
+        boardUpdate.playerCount++;
+    }
+
+    if (recipient != nullptr) {
+        this->sendPacket(*recipient, PacketType::BOARD_STATE_UPDATE, boardUpdate, snapshotPayloadSize(boardUpdate));
+    } else {
+        this->broadcastPacket(room, PacketType::BOARD_STATE_UPDATE, boardUpdate, snapshotPayloadSize(boardUpdate));
+    }
+}
+
+template<typename T>
+void ServerShard::broadcastPacket(const GameRoom &room, const PacketType type, const T &data,
+                                  const size_t payloadSize) {
+    TRACE_SPAN("broadcast");
+    // Encoded once, every member gets a reference to the same frame
+    const SharedFrame frame = encodePacket(type, data, payloadSize);
+
+    for (const SOCKET memberSocket: room.members) {
+        ClientContext *client = this->findClient(memberSocket);
+        if (client == nullptr || client->markedForDeletion) continue;
+        this->queueFrame(*client, frame);
+    }
+}
+
+template<typename T>
+void ServerShard::sendPacket(ClientContext &client, const PacketType type, const T &data, const size_t payloadSize) {
+    this->queueFrame(client, encodePacket(type, data, payloadSize));
+}
+
+template<typename T>
+SharedFrame ServerShard::encodePacket(const PacketType type, const T &data, const size_t payloadSize) {
+    auto buffer = std::make_shared<std::vector<char>>();
+    buffer->reserve(sizeof(PacketHeader) + payloadSize);
+
+    PacketHeader header{};
+    header.type = type;
+    header.payloadSize = static_cast<uint32_t>(payloadSize);
+
+    const auto headerPtr = reinterpret_cast<const char *>(&header);
+    buffer->insert(buffer->end(), headerPtr, headerPtr + sizeof(header));
+
+    const auto dataPtr = reinterpret_cast<const char *>(&data);
+    buffer->insert(buffer->end(), dataPtr, dataPtr + payloadSize);
+
+    return buffer;
+}
+
+void ServerShard::queueFrame(ClientContext &client, const SharedFrame &frame) {
+    if (client.markedForDeletion || client.disconnectPending) {
+        return;
+    }
+
+    client.sendQueue.push(frame);
+    if (!client.flushScheduled) {
+        client.flushScheduled = true;
+        pendingFlushes.push_back(client.handle);
+    }
+
+    // Only a socket that refused data means the client is behind, a busy tick alone doesn't
+    if (client.waitingForWrite) {
+        this->enforceHighWaterMark(client);
+    }
+}
+
+void ServerShard::enforceHighWaterMark(ClientContext &client) {
+    if (client.sendQueue.size() > server.getOutboundHighWaterMark()) {
+        LOG_WARN(SERVER,
+                 ANSI_RED "[InternalServer] Player with ID %hhu fell too far behind (%zu bytes queued).\n" ANSI_RESET,
+                 client.playerId, client.sendQueue.size());
+        this->requestDisconnect(client);
+    }
+}
+
+void ServerShard::flushOutbound(ClientContext &client) {
+    if (client.loopback != nullptr) {
+        // The frames themselves get handed over, a loopback client never has a partially sent one
+        while (!client.sendQueue.empty()) {
+            if (!client.loopback->sendToClient(client.sendQueue.front())) {
+                this->enforceHighWaterMark(client);
+                return; //Retried once the client drained the channel and woke us
+            }
+            client.sendQueue.consume(client.sendQueue.front()->size());
+        }
+        return;
+    }
+
+    IoSlice slices[EventLoop::MAX_SEND_SLICES];
+
+    while (!client.sendQueue.empty()) {
+        // All queued frames go out in one gathered write
+        const size_t sliceCount = client.sendQueue.gather(slices, EventLoop::MAX_SEND_SLICES);
+        const int sent = eventLoop->send(client.socket, slices, sliceCount);
+        if (sent < 0) {
+            LOG_ERROR(SERVER, ANSI_RED "[InternalServer] Error sending data!\n" ANSI_RESET);
+            this->requestDisconnect(client);
+            return;
+        }
+        if (sent == 0) {
+            //Full, wait for write readiness
+            if (!client.waitingForWrite) {
+                client.waitingForWrite = true;
+                eventLoop->modify(client.socket, IoEvent::READ | IoEvent::WRITE);
+            }
+            this->enforceHighWaterMark(client);
+            return;
+        }
+        client.sendQueue.consume(sent);
+    }
+
+    if (client.waitingForWrite) {
+        client.waitingForWrite = false;
+        eventLoop->modify(client.socket, IoEvent::READ);
+    }
+}
+
+void ServerShard::flushPendingClients() {
+    TRACE_SPAN("flush");
+    // Disconnects notify the rest of the room and failed sends flag more disconnects, so loop until both settle
+    while (!pendingFlushes.empty() || !pendingDisconnects.empty()) {
+        this->disconnectPendingClients();
+
+        std::vector<ClientHandle> flushing;
+        flushing.swap(pendingFlushes);
+
+        for (const ClientHandle handle: flushing) {
+            ClientContext *client = this->findClient(handle);
+            if (client == nullptr || client->markedForDeletion || !client->flushScheduled) continue;
+
+            client->flushScheduled = false;
+            if (client->disconnectPending) continue;
+            this->flushOutbound(*client);
+        }
+    }
+}
+
+void ServerShard::requestDisconnect(ClientContext &client) {
+    if (client.disconnectPending) {
+        return;
+    }
+    client.disconnectPending = true;
+    pendingDisconnects.push_back(client.handle);
+}
+
+void ServerShard::disconnectPendingClients() {
+    // Disconnecting notifies the rest of the room, which can flag more clients, so loop until nobody is left
+    while (!pendingDisconnects.empty()) {
+        std::vector<ClientHandle> disconnecting;
+        disconnecting.swap(pendingDisconnects);
+
+        for (const ClientHandle handle: disconnecting) {
+            ClientContext *client = this->findClient(handle);
+            if (client != nullptr && client->disconnectPending && !client->markedForDeletion) {
+                this->disconnectClient(*client);
+            }
+        }
+    }
+}
+
+uint8_t ServerShard::getNextActingPlayerId(const GameRoom &room) {
+    return room.seatInTurnOrder(room.boardData.round + room.boardData.turn);
+}
+
+ClientContext ServerShard::detachClient(ClientContext &client) {
+    // Whatever the loop already received belongs to the client, not to this shard
+    std::vector<char> unread;
+    std::vector<char> unsent;
+    if (client.loopback != nullptr) {
+        // Frames still in the channel get picked up by the new shard
+        client.loopback->setOwner(nullptr);
+        std::erase(loopbackClients, client.handle);
+    } else {
+        eventLoop->detach(client.socket, unread, unsent);
+    }
+    clientBySocket.erase(client.socket);
+    this->cancelClientTimers(client);
+
+    ClientContext detached = std::move(client);
+    if (!unsent.empty()) {
+        // Accepted by our loop before anything still in the queue, the new shard sends it first
+        detached.sendQueue.pushFront(std::make_shared<const std::vector<char>>(std::move(unsent)));
+    }
+    if (!detached.receiveBuffer.append(unread.data(), unread.size())) {
+        // The stream can't be continued, let the new shard see the connection drop
+        LOG_WARN(SERVER, ANSI_RED "[InternalServer] Receive buffer of player with ID %hhu overflowed.\n" ANSI_RESET,
+                 detached.playerId);
+        if (detached.loopback != nullptr) {
+            detached.loopback->closeFromServer();
+        } else {
+            SocketLayer::shutdownBoth(detached.socket);
+        }
+    }
+
+    // The original stays behind as an empty husk until the end of the tick
+    this->markForRemoval(client);
+    client.socket = INVALID_SOCKET;
+
+    return detached;
+}
+
+void ServerShard::migrateClient(ClientContext &client, const size_t targetShard) {
+    server.getShard(targetShard).adoptClient(this->detachClient(client));
+}
+
+void ServerShard::migrateRoom(const uint32_t roomId, const size_t targetShard) {
+    const GameRoom *room = server.rooms.findOwned(roomId, shardIndex);
+    if (room == nullptr) {
+        return;
+    }
+
+    std::vector<ClientContext> members;
+    members.reserve(room->members.size());
+    for (const SOCKET memberSocket: room->members) {
+        if (ClientContext *member = this->findClient(memberSocket)) {
+            members.push_back(this->detachClient(*member));
+        }
+    }
+    runnableRooms.erase(roomId);
+
+    // From here on the room's contents belong to the target shard
+    server.getShard(targetShard).adoptRoom(roomId, std::move(members));
+
+    LOG_INFO(SERVER, ANSI_CYAN "[InternalServer] Shard %zu gave room %u to shard %zu\n" ANSI_RESET,
+             shardIndex, roomId, targetShard);
+}
+
+void ServerShard::balanceLoad(const bool hadWork) {
+    TRACE_SPAN("balance");
+    runnableRoomCount = runnableRooms.size();
+    idle = !hadWork;
+
+    // Serve a thief, but never give away our last runnable room
+    const int thiefIndex = stealRequestedBy.exchange(-1);
+    if (thiefIndex >= 0 && runnableRooms.size() > 1) {
+        // A room whose sockets can't leave our loop right now stays, moving it would cut its players off
+        const auto movable = std::ranges::find_if(runnableRooms, [this](const uint32_t roomId) {
+            const GameRoom *room = server.rooms.findOwned(roomId, shardIndex);
+            return room != nullptr && std::ranges::all_of(room->members, [this](const SOCKET memberSocket) {
+                const ClientContext *member = this->findClient(memberSocket);
+                return member == nullptr || member->loopback != nullptr || eventLoop->canDetach(memberSocket);
+            });
+        });
+        if (movable != runnableRooms.end()) {
+            this->migrateRoom(*movable, thiefIndex);
+            runnableRoomCount = runnableRooms.size();
+        }
+    }
+
+    if (!hadWork) {
+        server.stealFor(shardIndex);
+    } else if (runnableRooms.size() >= STEAL_THRESHOLD) {
+        server.wakeIdleShard(shardIndex);
+    }
+
+    runnableRooms.clear();
+}
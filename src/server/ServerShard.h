@@ -0,0 +1,623 @@
+#ifndef TICTACTOEOVERLAN_SERVERSHARD_H
+#define TICTACTOEOVERLAN_SERVERSHARD_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ClientContext.h"
+#include "EventLoop.h"
+#include "GameRoom.h"
+#include "MoveJournal.h"
+#include "SlotMap.h"
+#include "TimerWheel.h"
+#include "../common/LatencyHistogram.h"
+#include "../common/LogLinearHistogram.h"
+#include "../common/NetworkProtocol.h"
+#include "../common/PacketDispatcher.h"
+#include "../common/SeqLock.h"
+#include "../common/SocketLayer.h"
+
+class InternalGameServer;
+
+/**
+ * @brief Telemetry of a single shard, published once per tick for the debug overlay.
+ */
+struct ShardTelemetry {
+    size_t shardIndex = 0;
+    long long tick = 0;
+    long long lastTickTime = 0;
+    PackagedValues tickTimes; //Over the last `TICK_TIME_SAMPLES` ticks, filled in by the reader
+    size_t clientCount = 0;
+    size_t runnableRoomCount = 0;
+    LatencyHistogram roundTripTimes; //Heartbeat round trips of every client the shard has served
+};
+
+/**
+ * @brief Immutable copy of a room's state for the debug overlay, published by the shard that owns the room.
+ * <br> Fixed size, so it can be published through a `SeqLock` without allocating.
+ */
+struct RoomTelemetry {
+    uint64_t version = 0; //Publish order across all shards, the highest one is the room's latest state
+    uint32_t roomId = DEFAULT_ROOM_ID;
+    bool exists = false; //False once the room got destroyed, the rest then holds the defaults
+    uint8_t nextPlayerId = 1; //The ID the next player joining the room gets
+    uint8_t hostingPlayerId = 0;
+    uint16_t turn = 0;
+    uint8_t boardSize = 0;
+    uint8_t winConditionLength = 0;
+    uint8_t availablePieceCount = 0;
+    std::array<PieceType, MAX_PLAYERS> availablePieces{};
+    uint8_t playerCount = 0;
+    std::array<Player, MAX_PLAYERS> players{};
+    uint16_t moveCount = 0;
+    std::array<Move, TOTAL_BOARD_AREA> moves{};
+};
+
+/**
+ * @brief One worker of the InternalGameServer.
+ * <br> A shard owns its own `EventLoop`, the sockets registered in it and the rooms those sockets play in.
+ * Every member of a room lives on the shard that owns the room, so a room is only ever touched by one thread
+ * and the game logic needs no locking.
+ * <br> Clients joining a room owned by another shard, and whole rooms given away to an idle shard
+ * (work stealing), are handed over through `adoptClient` and `adoptRoom`.
+ */
+class ServerShard {
+    constexpr static size_t STEAL_THRESHOLD = 2; // Runnable rooms per tick before idle shards get poked
+    constexpr static uint32_t KEYFRAME_INTERVAL = 16; // Every n-th move is sent as a full BOARD_STATE_UPDATE
+    constexpr static uint64_t HANDSHAKE_TIMEOUT_MS = 10000; // Time a new connection gets to send its SETUP_REQ
+    constexpr static uint64_t HEARTBEAT_INTERVAL_MS = 2000; // Time between two PINGs to the same client
+    constexpr static uint64_t HEARTBEAT_TIMEOUT_MS = 10000; // Time without a PONG before a client is dropped
+    constexpr static uint64_t RESERVED_SEAT_TIMEOUT_MS = 60000; // Time the players of a recovered room get to return
+    constexpr static size_t MAX_ACCEPTS_PER_WAKEUP = 256; // Bounds one drain of the backlog, the rest waits a tick
+    constexpr static int TICK_TIME_SAMPLES = 4096; // Ticks the tick time statistics cover, enough for a p99.9
+
+    InternalGameServer &server;
+    const size_t shardIndex;
+
+    std::unique_ptr<EventLoop> eventLoop;
+    std::vector<ReadyEvent> readyEvents;
+    TimerWheel timers{TimerWheel::monotonicMs()}; //Deadlines of this shard's clients and rooms, driven by `run`
+    SOCKET listenSocket = INVALID_SOCKET;
+    bool spreadsConnections = true; //Hand accepted clients out round-robin, only when we're the sole acceptor
+
+    SlotMap<ClientContext> clients;
+    std::vector<ClientHandle> loopbackClients; //In-process clients, polled every tick instead of through the event loop
+    std::vector<ClientHandle> pendingDisconnects; //Clients to drop at the end of the tick, see `disconnectPending`
+    std::vector<ClientHandle> pendingFlushes; //Clients with frames queued this tick, see `flushScheduled`
+    std::vector<ClientHandle> pendingRemovals; //Clients marked for deletion, erased at the end of the tick
+    std::unordered_map<SOCKET, ClientHandle> clientBySocket; //For the sockets the event loop reports ready
+    uint8_t nextPlayerId = 1; //Provisional IDs for SERVER_HELLO, the room assigns the final one
+    MoveJournal journal; //Crash recovery log of the rooms this shard owns, stays closed unless the server journals
+
+    // Rooms that processed at least one packet during the current tick
+    std::unordered_set<uint32_t> runnableRooms;
+
+    // Clients and rooms handed over from other shards, adopted at the start of the next tick
+    std::mutex handoffMutex;
+    std::vector<ClientContext> pendingHandoffs;
+    std::vector<uint32_t> pendingRoomTransfers;
+    std::vector<std::shared_ptr<LoopbackChannel>> pendingLoopbackConnections;
+
+    // Work stealing, -1 when nobody asked for a room
+    std::atomic<int> stealRequestedBy = -1;
+    std::atomic<bool> idle = false;
+    std::atomic<size_t> runnableRoomCount = 0;
+
+    //Telemetry, only touched by the shard itself, other threads read the published snapshots
+    long long tick = 0;
+    long long lastTickTime = 0; //Nanoseconds on the steady clock, like the tick times
+    size_t clientCount = 0;
+    LogLinearHistogram tickTimes{TICK_TIME_SAMPLES}; //Lock-free, read directly by `getTickTimes`
+    LatencyHistogram roundTripTimes;
+    SeqLock<ShardTelemetry> shardTelemetry;
+    SeqLock<RoomTelemetry> roomTelemetry; //The watched room, last published while this shard owned it
+    uint32_t publishedRoomId = DEFAULT_ROOM_ID;
+    bool publishedRoomExists = false; //Whether our last snapshot of the watched room showed it alive
+    bool watchedRoomChanged = true; //Something outside the room's packets changed it, e.g. a member left
+
+public:
+    ServerShard(InternalGameServer &server, size_t shardIndex);
+
+    ~ServerShard();
+
+    /**
+     * @brief Runs the shard loop until the server stops, then closes every owned socket.
+     */
+    void run();
+
+    /**
+     * @brief Interrupts the shard's event loop, safe to call from any thread.
+     */
+    void wakeup();
+
+    /**
+     * @brief Makes this shard accept new connections on the given listening socket.
+     * <br> Must be called before `run`.
+     *
+     * @param socket The bound, listening and non-blocking socket.
+     * @param spreadConnections True if this is the only acceptor and it has to spread the clients across the
+     * shards itself, false if every shard has its own listener and the kernel already did.
+     */
+    void setListenSocket(SOCKET socket, bool spreadConnections);
+
+    /**
+     * @brief Makes this shard journal the moves and events of its rooms, see `MoveJournal`.
+     * <br> Must be called before `run`.
+     *
+     * @param directory Where the journal segments are kept.
+     * @param epoch The current server start.
+     * @return False if the segment couldn't be created.
+     */
+    bool openJournal(const std::string &directory, uint32_t epoch);
+
+    /**
+     * @brief Writes rooms recovered from the previous epoch into this shard's journal and waits until it's on the disk.
+     * <br> Must be called before `run`, the previous epoch's segments may only be deleted once this returned true.
+     *
+     * @param recoveredRooms The rooms rebuilt by `MoveJournal::recover`.
+     * @return False if the journal is closed or couldn't be synced.
+     */
+    bool checkpointRooms(const std::vector<std::unique_ptr<GameRoom>> &recoveredRooms);
+
+    /**
+     * @brief Starts the deadline of a recovered room's reserved seats, see `releaseReservedSeats`.
+     * <br> Must be called before `run`, for every recovered room this shard is going to own.
+     *
+     * @param room The recovered room, not restored into the `RoomManager` yet.
+     */
+    void holdReservedSeats(GameRoom &room);
+
+    /**
+     * @brief Hands a client over to this shard. Thread-safe.
+     * <br> The client's socket must already be removed from the previous shard's event loop.
+     * Any unparsed bytes in its `receiveBuffer` get processed on this shard.
+     *
+     * @param client The client to take over.
+     */
+    void adoptClient(ClientContext client);
+
+    /**
+     * @brief Accepts an in-process connection from the hosting client on the next tick. Thread-safe.
+     *
+     * @param channel The client's end of the connection.
+     */
+    void connectLoopback(std::shared_ptr<LoopbackChannel> channel);
+
+    /**
+     * @brief Hands a whole room over to this shard. Thread-safe.
+     * <br> Called by the current owner, which must have already detached all members.
+     *
+     * @param roomId The room to take over.
+     * @param members The detached members of the room.
+     */
+    void adoptRoom(uint32_t roomId, std::vector<ClientContext> members);
+
+    /**
+     * @brief Marks this shard as a thief that wants one of our runnable rooms.
+     *
+     * @param thiefIndex The index of the idle shard.
+     * @return True if the request was registered, false if another shard asked first.
+     */
+    bool requestSteal(int thiefIndex);
+
+    bool isIdle() const;
+
+    size_t getRunnableRoomCount() const;
+
+    /**
+     * @return The snapshot published at the end of the last tick, with the current `getTickTimes`.
+     * Lock-free, safe to call from any thread.
+     */
+    ShardTelemetry getTelemetry();
+
+    /**
+     * @return Average, min, max and tail percentiles of the recent tick times. Lock-free, safe to call from any thread.
+     */
+    PackagedValues getTickTimes();
+
+    /**
+     * @return The last snapshot of the watched room this shard published, see `InternalGameServer::watchRoom`.
+     * Lock-free, safe to call from any thread.
+     */
+    RoomTelemetry getRoomTelemetry() const;
+
+private:
+    /**
+     * @brief Publishes the watched room if this shard owns it and it changed during the tick.
+     * <br> Called before the runnable rooms are cleared, those are the rooms that processed packets.
+     */
+    void publishRoomTelemetry();
+
+    /**
+     * @brief Copies the room and its members into a fixed size snapshot.
+     */
+    RoomTelemetry captureRoom(const GameRoom &room);
+
+    /**
+     * @brief How long the loop may block: until the next timer is due, or the backend's idle timeout if that's sooner.
+     */
+    int nextWaitTimeoutMs() const;
+
+    /**
+     * @brief Drops a client that still hasn't completed the handshake, fired `HANDSHAKE_TIMEOUT_MS` after it connected.
+     */
+    void expireHandshake(ClientHandle handle);
+
+    /**
+     * @brief Sends the next PING to a client and schedules the one after, or drops the client if it stopped answering.
+     * <br> Runs every `HEARTBEAT_INTERVAL_MS` for every client of the shard.
+     */
+    void sendHeartbeat(ClientHandle handle);
+
+    /**
+     * @brief Schedules `releaseReservedSeats` for the room's `seatsReservedUntilMs` on this shard's wheel.
+     * <br> The deadline travels with the room, a shard that adopts it only waits for what's left.
+     */
+    void scheduleSeatRelease(const GameRoom &room);
+
+    /**
+     * @brief Releases the reserved seats nobody claimed before the deadline, as if their players disconnected.
+     * <br> Their pieces return to the pool, a game in progress ends, and the room is destroyed if nobody is left.
+     */
+    void releaseReservedSeats(uint32_t roomId);
+
+    /**
+     * @brief Records the round trip time of a heartbeat, per client and for the shard.
+     */
+    void handlePongPacket(ClientContext &client, const PongPacket *packet);
+
+    /**
+     * @brief Cancels the client's timers, they can't follow it to another shard.
+     */
+    void cancelClientTimers(ClientContext &client);
+
+    /**
+     * @brief Accepts every pending connection until the listener would block, at most `MAX_ACCEPTS_PER_WAKEUP`.
+     * <br> The listener stays readable if more are left, so the next wait returns right away.
+     */
+    void handleNewConnections();
+
+    /**
+     * @brief Sets up a freshly accepted connection.
+     * <br> Creates a new `ClientContext`, assigns an ID and sends `SERVER_HELLO`.
+     * <br> A sole acceptor then spreads the connection round-robin across the shards.
+     */
+    void acceptConnection(SOCKET socket);
+
+    /**
+     * @brief Creates the context of a freshly connected client, assigns a provisional ID and queues `SERVER_HELLO`.
+     *
+     * @param socket The client's socket, or the handle of its loopback channel.
+     * @return The new client, not registered with any shard yet.
+     */
+    ClientContext greetNewClient(SOCKET socket);
+
+    /**
+     * @brief Receives what the in-process clients sent since the last tick and parses it.
+     * <br> Also retries sends that didn't fit into their channel before.
+     *
+     * @return True if any of them sent something.
+     */
+    bool pollLoopbackClients();
+
+    /**
+     * @brief Removes the client's connection from this shard and closes it, the socket or the loopback channel.
+     *
+     * @param client The client whose connection gets closed.
+     */
+    void closeConnection(ClientContext &client);
+
+    /**
+     * @brief Registers a client with this shard's event loop and client list.
+     *
+     * @param client The client to add, moved into `clients`.
+     * @return The stored client, or nullptr if the event loop refused the socket.
+     */
+    ClientContext *addClient(ClientContext &&client);
+
+    /**
+     * @brief Takes all clients and rooms handed over by other shards and parses their buffered data.
+     */
+    void adoptPendingClients();
+
+    /**
+     * @brief Erases the clients that got disconnected or migrated this tick from `clients`.
+     * <br> Only touches those clients, the rest of the slot map and every room's turn order stay as they are.
+     */
+    void removeMarkedClients();
+
+    /**
+     * @brief Removes a client from this shard without closing its socket.
+     *
+     * @param client The client to detach, left marked for removal on this shard.
+     * @return The client moved out, including its unparsed receive buffer.
+     */
+    ClientContext detachClient(ClientContext &client);
+
+    /**
+     * @brief Moves a client to another shard, including its unparsed receive buffer.
+     *
+     * @param client The client to move, left marked for removal on this shard.
+     * @param targetShard The index of the shard that takes it over.
+     */
+    void migrateClient(ClientContext &client, size_t targetShard);
+
+    /**
+     * @brief Gives a room and all its members to another shard.
+     *
+     * @param roomId The room to move.
+     * @param targetShard The index of the shard that takes it over.
+     */
+    void migrateRoom(uint32_t roomId, size_t targetShard);
+
+    /**
+     * @brief End of tick load balancing.
+     * <br> Serves steal requests from idle shards, asks a busy shard for work when idle,
+     * and wakes an idle shard when this one has more runnable rooms than it should.
+     *
+     * @param hadWork Whether this tick processed any socket event or packet of an in-process client.
+     */
+    void balanceLoad(bool hadWork);
+
+    /**
+     * @brief Closes the client's socket and takes it out of its room.
+     * <br> Returns the piece to the room's pool and notifies the remaining members.
+     *
+     * @param client The client to drop.
+     */
+    void disconnectClient(ClientContext &client);
+
+    /**
+     * @brief Looks up a client owned by this shard by its socket.
+     *
+     * @param socket The client's socket.
+     * @return The client, or nullptr if the socket isn't known.
+     */
+    ClientContext *findClient(SOCKET socket);
+
+    /**
+     * @return The client, or nullptr if it left this shard since the handle was taken.
+     */
+    ClientContext *findClient(ClientHandle handle);
+
+    /**
+     * @brief Looks up a member of the room by its room scoped player ID, in constant time.
+     *
+     * @return The client, or nullptr if the room has no such member.
+     */
+    ClientContext *findPlayer(const GameRoom &room, uint8_t playerId);
+
+    /**
+     * @brief Flags the client for removal at the end of the tick, until then it stays a husk in `clients`.
+     */
+    void markForRemoval(ClientContext &client);
+
+    /**
+     * @brief Reads incoming data from a specific client.
+     * <br> Receives directly into the client's `receiveBuffer` and calls `parseReceivedPackets`.
+     *
+     * @param client The client connection to poll.
+     */
+    void handleClientData(ClientContext &client);
+
+    /**
+     * @brief Calls `processPacket` for every complete packet in the client's `receiveBuffer`.
+     * <br> Disconnects the client if it announces a packet bigger than the buffer can ever hold.
+     *
+     * @param client The client whose buffer gets parsed.
+     */
+    void parseReceivedPackets(ClientContext &client);
+
+    /**
+     * @brief Determines whose turn it is based on the round/turn counters.
+     *
+     * @param room The room to check.
+     * @return The ID of the acting player.
+     */
+    uint8_t getNextActingPlayerId(const GameRoom &room);
+
+    /**
+     * @brief The core logic dispatcher.
+     * <br> Runs the handler registered for the packet's type in `LobbyDispatcher` or, once the client is in a room,
+     * `RoomDispatcher`. Packets of the wrong size are dropped before any handler sees them.
+     *
+     * @param client The client who sent the packet.
+     * @param packetView The received packet, its payload points into the client's `receiveBuffer`.
+     */
+    void processPacket(ClientContext &client, const PacketView &packetView);
+
+    /**
+     * @brief Processes the SETUP_REQ packet.
+     * <br> Places the client into the requested room, creating it if necessary.
+     * <br> If the room is owned by another shard, the client is migrated there and the packet is handled again.
+     *
+     * @param client The client from which we received the packet.
+     * @param packet The parsed SetupReqPacket packet.
+     */
+    void handleSetupRequestPacket(ClientContext &client, const SetupReqPacket *packet);
+
+    /**
+     * @brief Processes the SETTINGS_CHANGE_REQ packet.
+     *
+     * @param room The room of the requesting client.
+     * @param client The client from which we received the packet.
+     * @param packet The parsed SettingsChangeReqPacket packet.
+     */
+    void handleSettingsChangeRequestPacket(GameRoom &room, ClientContext &client,
+                                           const SettingsChangeReqPacket *packet);
+
+    /**
+     * @brief Processes the GAME_START_REQ packet.
+     *
+     * @param room The room of the requesting client.
+     * @param client The client from which we received the packet.
+     * @param packet The parsed GameStartRequestPacket packet.
+     */
+    void handleGameStartRequestPacket(GameRoom &room, ClientContext &client, const GameStartRequestPacket *packet);
+
+    /**
+     * @brief Processes the MOVE_REQ packet.
+     *
+     * @param room The room of the requesting client.
+     * @param client The client from which we received the packet.
+     * @param packet The parsed MoveRequestPacket packet.
+     */
+    void handleMoveRequestPacket(GameRoom &room, ClientContext &client, const MoveRequestPacket *packet);
+
+    /**
+     * @brief Processes the BACK_TO_GAME_ROOM packet, relays it to the whole room.
+     *
+     * @param room The room of the requesting client.
+     * @param client The client from which we received the packet.
+     * @param packet The parsed BackToGameRoomPacket packet.
+     */
+    void handleBackToGameRoomPacket(GameRoom &room, ClientContext &client, const BackToGameRoomPacket *packet);
+
+    /**
+     * @brief Processes the RESYNC_REQ packet, sends the client a keyframe if it's behind.
+     *
+     * @param room The room of the requesting client.
+     * @param client The client from which we received the packet.
+     * @param packet The parsed ResyncRequestPacket packet.
+     */
+    void handleResyncRequestPacket(GameRoom &room, ClientContext &client, const ResyncRequestPacket *packet);
+
+    // Packets a client may send before it is in a room
+    using LobbyDispatcher = PacketDispatcher<void(ServerShard &, ClientContext &),
+        PacketRoute<PacketType::SETUP_REQ, &ServerShard::handleSetupRequestPacket>,
+        PacketRoute<PacketType::PONG, &ServerShard::handlePongPacket>>;
+
+    // Packets handled inside the client's room
+    using RoomDispatcher = PacketDispatcher<void(ServerShard &, GameRoom &, ClientContext &),
+        PacketRoute<PacketType::SETTINGS_CHANGE_REQ, &ServerShard::handleSettingsChangeRequestPacket>,
+        PacketRoute<PacketType::GAME_START_REQ, &ServerShard::handleGameStartRequestPacket>,
+        PacketRoute<PacketType::MOVE_REQ, &ServerShard::handleMoveRequestPacket>,
+        PacketRoute<PacketType::BACK_TO_GAME_ROOM, &ServerShard::handleBackToGameRoomPacket>,
+        PacketRoute<PacketType::RESYNC_REQ, &ServerShard::handleResyncRequestPacket>>;
+
+    /**
+     * @return A GAME_START announcing the room's current game, with a snapshot of its board.
+     */
+    GameStartPacket makeGameStartPacket(const GameRoom &room);
+
+    /**
+     * @brief Appends a record about the room to the shard's journal, stamped with the next global sequence.
+     * <br> A memcpy into the mapped segment, a no-op while journaling is off.
+     *
+     * @param type The record type, has to match the payload.
+     * @param roomId The room the record belongs to.
+     * @param payload The payload struct.
+     */
+    template<typename T>
+    void journalRecord(JournalRecordType type, uint32_t roomId, const T &payload);
+
+    /**
+     * @brief Journals the client's seat: its ID, piece, host flag, wins and name.
+     */
+    void journalSeat(const GameRoom &room, const ClientContext &client);
+
+    /**
+     * @brief Writes the room's finished game to the replay directory, a no-op while archiving is off.
+     * <br> Called before the room moves on: the moves, round and members still describe the game.
+     *
+     * @param room The room whose game ended.
+     * @param reason Why it ended.
+     * @param finisher The winner, or the player who left and can't be found through the room anymore.
+     */
+    void archiveReplay(const GameRoom &room, FinishReason reason, const ClientContext &finisher);
+
+    /**
+     * @brief Sends the room's full board state as a BOARD_STATE_UPDATE keyframe.
+     *
+     * @param room The room whose state gets sent.
+     * @param recipient The client to resync, or nullptr to broadcast to the whole room.
+     */
+    void sendKeyframe(GameRoom &room, ClientContext *recipient);
+
+    /**
+     * @brief Sends a structured packet to a specific client.
+     * <br> Never blocks, whatever the socket can't take right now waits in the client's `sendQueue`.
+     *
+     * @param client The target client.
+     * @param type The packet type identifier.
+     * @param data The payload struct.
+     * @param payloadSize Bytes of `data` to send, less than the whole struct for variable-length packets.
+     */
+    template<typename T>
+    void sendPacket(ClientContext &client, PacketType type, const T &data, size_t payloadSize = sizeof(T));
+
+    /**
+     * @brief Encodes a packet (Header + Payload) into an immutable frame that can be queued to many clients.
+     *
+     * @param type The packet type identifier.
+     * @param data The payload struct.
+     * @param payloadSize Bytes of `data` to encode, less than the whole struct for variable-length packets.
+     * @return The encoded frame.
+     */
+    template<typename T>
+    static SharedFrame encodePacket(PacketType type, const T &data, size_t payloadSize = sizeof(T));
+
+    /**
+     * @brief Queues an encoded frame for a client, it's sent with everything else queued this tick by `flushPendingClients`.
+     * <br> Flags the client for disconnection if its socket is full and the queue grows past the high-water mark.
+     *
+     * @param client The target client.
+     * @param frame The frame to send, shared with any other recipient.
+     */
+    void queueFrame(ClientContext &client, const SharedFrame &frame);
+
+    /**
+     * @brief Flags the client for disconnection if its unsent backlog grew past the server's high-water mark.
+     *
+     * @param client The client whose socket couldn't take everything.
+     */
+    void enforceHighWaterMark(ClientContext &client);
+
+    /**
+     * @brief Sends as much of the client's `sendQueue` as its socket takes, in one gathered write.
+     * <br> Watches for write readiness while something is left, and stops once the queue is empty.
+     *
+     * @param client The client to drain.
+     */
+    void flushOutbound(ClientContext &client);
+
+    /**
+     * @brief End of tick, writes out every client's queued frames and drops the clients flagged for disconnection.
+     * <br> All packets a client got during the tick (e.g. a BOARD_STATE_UPDATE followed by GAME_END)
+     * leave in a single write instead of one send per packet.
+     */
+    void flushPendingClients();
+
+    /**
+     * @brief Flags a client to be disconnected at the end of the tick.
+     * <br> Disconnecting right away could change a room's member list while it's being broadcast to.
+     *
+     * @param client The client to drop.
+     */
+    void requestDisconnect(ClientContext &client);
+
+    /**
+     * @brief Disconnects every client flagged by `requestDisconnect`.
+     */
+    void disconnectPendingClients();
+
+    /**
+     * @brief Sends a packet to ALL members of a room.
+     * <br> The packet is encoded once, every member's queue references the same frame.
+     *
+     * @param room The room to broadcast to.
+     * @param type The packet type identifier.
+     * @param data The payload struct.
+     * @param payloadSize Bytes of `data` to send, less than the whole struct for variable-length packets.
+     */
+    template<typename T>
+    void broadcastPacket(const GameRoom &room, const PacketType type, const T &data, size_t payloadSize = sizeof(T));
+};
+
+
+#endif //TICTACTOEOVERLAN_SERVERSHARD_H
@@ -1,15 +1,17 @@
 #include "ServerUtils.h"
 
+#include <cstring>
+
 Player ServerUtils::clientContextToPlayer(const ClientContext &client, bool requestingPlayerId) {
     Player p{};
     p.playerId = client.playerId;
-    p.wins = client.playerWins;
+    p.wins = client.profile->playerWins;
     // p.playerName = client.playerName;
     memset(p.playerName, 0, MAX_PLAYER_NAME_LENGTH);
-    strncpy(p.playerName, client.playerName, MAX_PLAYER_NAME_LENGTH - 1);
-    p.piece = client.pieceType;
+    strncpy(p.playerName, client.profile->playerName, MAX_PLAYER_NAME_LENGTH - 1);
+    p.piece = client.profile->pieceType;
     p.isMe = (client.playerId == requestingPlayerId);
     p.myTurn = client.myTurn;
-    p.isHost = client.isHost;
+    p.isHost = client.profile->isHost;
     return p;
 }
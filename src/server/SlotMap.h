@@ -0,0 +1,139 @@
+#ifndef TICTACTOEOVERLAN_SLOTMAP_H
+#define TICTACTOEOVERLAN_SLOTMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Stable reference to an element of a `SlotMap`.
+ * <br> Resolves to nothing once its element is erased, even after the slot got reused for another element,
+ * because every reuse bumps the slot's generation.
+ */
+struct SlotHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0; //Never handed out, a default handle resolves to nothing
+
+    bool operator==(const SlotHandle &other) const = default;
+};
+
+/**
+ * @brief Unordered container with O(1) insert, erase and lookup through stable `SlotHandle`s.
+ * <br> The elements themselves are kept densely packed, so iterating touches no holes. Erasing moves the last
+ * element into the gap, which only changes the iteration order, never what a handle resolves to.
+ * <br> Pointers to elements are invalidated by `insert` and `erase`, handles are not.
+ *
+ * @tparam T The element type, has to be movable.
+ */
+template<typename T>
+class SlotMap {
+    constexpr static uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Slot {
+        uint32_t denseIndex = NO_SLOT; //Position of the element in `values`, the next free slot while unused
+        uint32_t generation = 1;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<T> values; //Dense, in no particular order
+    std::vector<uint32_t> slotOfValue; //The slot of each element of `values`, to fix it up when the element moves
+    uint32_t freeHead = NO_SLOT;
+
+public:
+    /**
+     * @brief Moves an element in, reusing a free slot if there is one.
+     *
+     * @return The element's handle.
+     */
+    SlotHandle insert(T &&value) {
+        uint32_t slotIndex;
+        if (freeHead != NO_SLOT) {
+            slotIndex = freeHead;
+            freeHead = slots[slotIndex].denseIndex;
+        } else {
+            slotIndex = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        }
+
+        slots[slotIndex].denseIndex = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        slotOfValue.push_back(slotIndex);
+        return {slotIndex, slots[slotIndex].generation};
+    }
+
+    /**
+     * @brief Erases the element, its handle and every copy of it stop resolving.
+     *
+     * @return False if the handle didn't resolve to anything.
+     */
+    bool erase(const SlotHandle handle) {
+        if (this->get(handle) == nullptr) {
+            return false;
+        }
+
+        Slot &slot = slots[handle.index];
+        const uint32_t denseIndex = slot.denseIndex;
+        const uint32_t lastIndex = static_cast<uint32_t>(values.size() - 1);
+        if (denseIndex != lastIndex) {
+            values[denseIndex] = std::move(values[lastIndex]);
+            slotOfValue[denseIndex] = slotOfValue[lastIndex];
+            slots[slotOfValue[denseIndex]].denseIndex = denseIndex;
+        }
+        values.pop_back();
+        slotOfValue.pop_back();
+
+        // Skips 0 when wrapping around, that's the generation of a default handle
+        if (++slot.generation == 0) slot.generation = 1;
+        slot.denseIndex = freeHead;
+        freeHead = handle.index;
+        return true;
+    }
+
+    /**
+     * @return The element, nullptr if the handle is stale or default.
+     */
+    T *get(const SlotHandle handle) {
+        if (handle.index >= slots.size() || slots[handle.index].generation != handle.generation) {
+            return nullptr;
+        }
+        return &values[slots[handle.index].denseIndex];
+    }
+
+    const T *get(const SlotHandle handle) const {
+        return const_cast<SlotMap *>(this)->get(handle);
+    }
+
+    /**
+     * @return The handle of the element at `denseIndex` in iteration order.
+     */
+    SlotHandle handleAt(const size_t denseIndex) const {
+        const uint32_t slotIndex = slotOfValue[denseIndex];
+        return {slotIndex, slots[slotIndex].generation};
+    }
+
+    /**
+     * @brief Erases every element, all handles handed out so far stop resolving.
+     */
+    void clear() {
+        while (!values.empty()) {
+            this->erase(this->handleAt(values.size() - 1));
+        }
+    }
+
+    size_t size() const {
+        return values.size();
+    }
+
+    bool empty() const {
+        return values.empty();
+    }
+
+    auto begin() { return values.begin(); }
+    auto end() { return values.end(); }
+    auto begin() const { return values.begin(); }
+    auto end() const { return values.end(); }
+};
+
+
+#endif //TICTACTOEOVERLAN_SLOTMAP_H
@@ -0,0 +1,184 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <climits>
+
+TimerWheel::TimerWheel(const uint64_t startMs) : currentMs(startMs) {
+    for (auto &level: slotHeads) {
+        level.fill(NO_NODE);
+    }
+}
+
+TimerId TimerWheel::schedule(const uint64_t delayMs, Callback callback) {
+    const uint32_t index = this->acquireNode();
+    TimerNode &node = nodes[index];
+    node.expiresAt = currentMs + std::max<uint64_t>(delayMs, 1);
+    node.callback = std::move(callback);
+    node.active = true;
+    this->link(index);
+    ++activeCount;
+
+    return static_cast<TimerId>(node.generation) << 32 | index;
+}
+
+bool TimerWheel::cancel(const TimerId timer) {
+    const uint32_t index = static_cast<uint32_t>(timer);
+    if (index >= nodes.size()) {
+        return false;
+    }
+
+    const TimerNode &node = nodes[index];
+    if (!node.active || node.generation != static_cast<uint32_t>(timer >> 32)) {
+        return false;
+    }
+
+    this->unlink(index);
+    this->releaseNode(index);
+    return true;
+}
+
+void TimerWheel::advance(const uint64_t nowMs) {
+    // Jump straight from one due moment to the next, idle stretches cost nothing
+    for (uint64_t next = this->nextEventMs(); next <= nowMs; next = this->nextEventMs()) {
+        currentMs = next;
+        this->processCurrent();
+    }
+    currentMs = std::max(currentMs, nowMs);
+}
+
+int TimerWheel::msUntilNextEvent(const uint64_t nowMs) const {
+    const uint64_t next = this->nextEventMs();
+    if (next == UINT64_MAX) {
+        return -1;
+    }
+    if (next <= nowMs) {
+        return 0;
+    }
+    return static_cast<int>(std::min<uint64_t>(next - nowMs, INT_MAX));
+}
+
+size_t TimerWheel::size() const {
+    return activeCount;
+}
+
+uint64_t TimerWheel::monotonicMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t TimerWheel::acquireNode() {
+    if (!freeNodes.empty()) {
+        const uint32_t index = freeNodes.back();
+        freeNodes.pop_back();
+        return index;
+    }
+
+    nodes.emplace_back();
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void TimerWheel::releaseNode(const uint32_t index) {
+    TimerNode &node = nodes[index];
+    node.active = false;
+    node.callback = nullptr;
+    ++node.generation;
+    freeNodes.push_back(index);
+    --activeCount;
+}
+
+void TimerWheel::link(const uint32_t index) {
+    TimerNode &node = nodes[index];
+
+    // Far out timers sit in the top level's last reachable slot and get placed again when it cascades
+    const uint64_t placedAt = std::min(node.expiresAt, currentMs + MAX_DELAY_MS);
+    const uint64_t delta = placedAt - currentMs;
+
+    size_t level = 0;
+    while (level + 1 < LEVELS && delta >> (SLOT_BITS * (level + 1)) != 0) {
+        ++level;
+    }
+
+    const size_t slot = (placedAt >> (SLOT_BITS * level)) & (SLOTS - 1);
+    node.level = static_cast<uint8_t>(level);
+    node.slot = static_cast<uint8_t>(slot);
+    node.previous = NO_NODE;
+    node.next = slotHeads[level][slot];
+
+    if (node.next != NO_NODE) {
+        nodes[node.next].previous = index;
+    }
+    slotHeads[level][slot] = index;
+    occupiedSlots[level] |= 1ULL << slot;
+}
+
+void TimerWheel::unlink(const uint32_t index) {
+    const TimerNode &node = nodes[index];
+
+    if (node.previous != NO_NODE) {
+        nodes[node.previous].next = node.next;
+    } else {
+        slotHeads[node.level][node.slot] = node.next;
+    }
+    if (node.next != NO_NODE) {
+        nodes[node.next].previous = node.previous;
+    }
+
+    if (slotHeads[node.level][node.slot] == NO_NODE) {
+        occupiedSlots[node.level] &= ~(1ULL << node.slot);
+    }
+}
+
+uint64_t TimerWheel::nextEventMs() const {
+    uint64_t next = UINT64_MAX;
+
+    for (size_t level = 0; level < LEVELS; ++level) {
+        if (occupiedSlots[level] == 0) {
+            continue;
+        }
+
+        // A slot is due when the wheel reaches its start, the first occupied slot after the current one is next
+        const size_t shift = SLOT_BITS * level;
+        const uint64_t position = currentMs >> shift;
+        const size_t firstAfter = (position + 1) & (SLOTS - 1);
+        const uint64_t rotated = std::rotr(occupiedSlots[level], static_cast<int>(firstAfter));
+        const uint64_t distance = std::countr_zero(rotated) + 1;
+
+        next = std::min(next, (position + distance) << shift);
+    }
+
+    return next;
+}
+
+void TimerWheel::processCurrent() {
+    // Top down, so a timer can fall through several levels at once and still fire right now
+    for (size_t level = LEVELS - 1; level > 0; --level) {
+        const size_t shift = SLOT_BITS * level;
+        if ((currentMs & ((1ULL << shift) - 1)) != 0) {
+            continue;
+        }
+
+        const size_t slot = (currentMs >> shift) & (SLOTS - 1);
+        uint32_t index = slotHeads[level][slot];
+        slotHeads[level][slot] = NO_NODE;
+        occupiedSlots[level] &= ~(1ULL << slot);
+
+        while (index != NO_NODE) {
+            const uint32_t next = nodes[index].next;
+            this->link(index);
+            index = next;
+        }
+    }
+
+    // Popped one at a time, a callback may cancel the timers behind it
+    const size_t slot = currentMs & (SLOTS - 1);
+    while (slotHeads[0][slot] != NO_NODE) {
+        const uint32_t index = slotHeads[0][slot];
+        this->unlink(index);
+
+        Callback callback = std::move(nodes[index].callback);
+        this->releaseNode(index);
+        callback();
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef TICTACTOEOVERLAN_TIMERWHEEL_H
+#define TICTACTOEOVERLAN_TIMERWHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Handle of a scheduled timer, stays unique even after the timer fired or got cancelled.
+ */
+using TimerId = uint64_t;
+
+/**
+ * @brief Hierarchical timing wheel with a resolution of 1ms, owned and driven by a single thread.
+ * <br> `LEVELS` wheels of `SLOTS` slots each, every level covers `SLOTS` times the span of the one below it.
+ * A timer is placed on the lowest level whose span reaches its expiry and moves down a level every time
+ * the wheel passes its slot, until it fires from level 0. Expiries past the top level are clamped and re-placed.
+ * <br> Scheduling and cancelling are O(1): slots are intrusive linked lists over a pooled node array.
+ * A bitmap per level tells which slots are occupied, so finding the next expiry and skipping idle time
+ * never walks empty slots.
+ */
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+
+    constexpr static TimerId NO_TIMER = 0;
+    constexpr static size_t LEVELS = 4;
+    constexpr static size_t SLOT_BITS = 6;
+    constexpr static size_t SLOTS = 1 << SLOT_BITS; //64 slots, one occupancy bit each
+    constexpr static uint64_t MAX_DELAY_MS = (1ULL << (SLOT_BITS * LEVELS)) - 1; //~4.6 hours, longer delays get re-placed
+
+private:
+    constexpr static uint32_t NO_NODE = UINT32_MAX;
+
+    struct TimerNode {
+        uint64_t expiresAt = 0;
+        Callback callback;
+        uint32_t previous = NO_NODE;
+        uint32_t next = NO_NODE;
+        uint32_t generation = 1; //Bumped on every release, so stale TimerIds don't match a reused node
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool active = false;
+    };
+
+    std::vector<TimerNode> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::array<std::array<uint32_t, SLOTS>, LEVELS> slotHeads{};
+    std::array<uint64_t, LEVELS> occupiedSlots{}; //Bit n set if slot n of the level has timers
+    uint64_t currentMs; //Everything up to and including this moment has been processed
+    size_t activeCount = 0;
+
+public:
+    /**
+     * @param startMs The current time, from `monotonicMs`.
+     */
+    explicit TimerWheel(uint64_t startMs);
+
+    /**
+     * @brief Schedules a callback to run once, `delayMs` after the wheel's current time.
+     * <br> The callback runs from `advance` and may schedule or cancel timers itself.
+     *
+     * @param delayMs Delay in milliseconds, rounded up to at least 1.
+     * @param callback The function to run.
+     * @return Handle for `cancel`.
+     */
+    TimerId schedule(uint64_t delayMs, Callback callback);
+
+    /**
+     * @brief Cancels a pending timer.
+     *
+     * @return False if the timer already fired or was cancelled.
+     */
+    bool cancel(TimerId timer);
+
+    /**
+     * @brief Moves the wheel forward to `nowMs`, running every timer that expired on the way in expiry order.
+     */
+    void advance(uint64_t nowMs);
+
+    /**
+     * @brief How long the owner may sleep before it has to call `advance` again.
+     * <br> May be earlier than the next expiry, when a timer has to move down a level first.
+     *
+     * @return Milliseconds until then, 0 if it's already due, -1 if nothing is scheduled.
+     */
+    int msUntilNextEvent(uint64_t nowMs) const;
+
+    /**
+     * @return Number of pending timers.
+     */
+    size_t size() const;
+
+    /**
+     * @return Milliseconds on a monotonic clock, the time base the wheel is driven with.
+     */
+    static uint64_t monotonicMs();
+
+private:
+    uint32_t acquireNode();
+
+    void releaseNode(uint32_t index);
+
+    void link(uint32_t index);
+
+    void unlink(uint32_t index);
+
+    /**
+     * @brief The next moment something has to happen: a timer on level 0 expires or a higher slot has to cascade.
+     *
+     * @return UINT64_MAX if nothing is scheduled.
+     */
+    uint64_t nextEventMs() const;
+
+    /**
+     * @brief Cascades the higher slots that start at `currentMs` and fires level 0's slot.
+     */
+    void processCurrent();
+};
+
+
+#endif //TICTACTOEOVERLAN_TIMERWHEEL_H
@@ -1,6 +1,9 @@
 #include "WinValidator.h"
 
+#include "../common/Tracer.h"
+
 bool WinValidator::checkWin(const BoardData &board, const int lastX, const int lastY) {
+    TRACE_SPAN("checkWin");
     const PieceType currentPiece = board.getSquareAt(lastX, lastY).piece;
 
     if (currentPiece == PieceType::EMPTY) return false;